@@ -27,10 +27,12 @@
 #include "timers_config.h"
 
 #include "sd_task.h"
+#include "sd_rate.h"
 #include "lora_task.h"
 #include "can_task.h"
 #include "measure_task.h"
 #include "esp_now_task.h"
+#include "log_capture.h"
 
 #include "abort_button.h"
 
@@ -70,6 +72,12 @@ void app_init_task(void* pvParameters) {
     ESP_LOGI(TAG, "### SD Card initialization success ###");
   }
 
+#ifdef CONFIG_SD_LOG_CAPTURE
+  if (log_capture_init(LOG_CAPTURE_DEFAULT_LEVEL, LOG_CAPTURE_DEFAULT_UART) != ESP_OK) {
+    ESP_LOGE(TAG, "Log capture initialization failed");
+  }
+#endif
+
   ESP_LOGI(TAG, "Initializing MCU configuration...");
 
   ret |= TANWA_mcu_config_init();
@@ -114,6 +122,15 @@ void app_init_task(void* pvParameters) {
     ESP_LOGI(TAG, "### ESP-NOW initialization success ###");
   }
 
+  ESP_LOGI(TAG, "Loading calibration...");
+
+  // NVS is initialized together with ESP-NOW
+  if (TANWA_calibration_init() != ESP_OK) {
+    ESP_LOGE(TAG, "Calibration loading failed");
+  } else {
+    ESP_LOGI(TAG, "### Calibration loading success ###");
+  }
+
   ESP_LOGI(TAG, "Initializing shared memory...");
 
   if (!tanwa_data_init()) {
@@ -128,8 +145,15 @@ void app_init_task(void* pvParameters) {
     ESP_LOGI(TAG, "### Timers initialization success ###");
   }
 
+ // TEMPERATURE TIMER
+  if (!temperature_timer_start(TEMPERATURE_TIMER_DEFAULT_PERIOD_MS)) {
+    ESP_LOGE(TAG, "TEMPERATURE | Timer start failed");
+  } else {
+    ESP_LOGI(TAG, "TEMPERATURE | Timer started");
+  }
+
  // SD CARD TIMER
-  if (!sys_timer_start(TIMER_SD_DATA, 50, TIMER_TYPE_PERIODIC)) {
+  if (!sd_rate_start()) {
     ESP_LOGE(TAG, "SD CARD | Timer start failed");
   } else {
     ESP_LOGI(TAG, "SD CARD | Timer started");
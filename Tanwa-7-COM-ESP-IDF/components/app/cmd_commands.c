@@ -14,6 +14,7 @@
 
 #include "can_commands.h"
 #include "can_task.h"
+#include "lora_task.h"
 
 #define TAG "CMD_COMMANDS"
 
@@ -430,6 +431,13 @@ void lora_command_parsing(uint32_t lora_id, uint32_t command, int32_t payload) {
                         tanwa_heating((uint8_t) payload);
                         break;
                     }
+            case CMD_TELEMETRY_ACK: {
+                ESP_LOGD(TAG, "LORA | Telemetry ack | %d", payload);
+                if (lora_task_telemetry_ack((uint8_t) payload) == false) {
+                    ESP_LOGW(TAG, "LORA | Telemetry ack too old | %d", payload);
+                }
+                break;
+            }
             default: {
                 ESP_LOGI(TAG, "LORA command: %d", command);
                 ESP_LOGW(TAG, "LORA | Unknown command");
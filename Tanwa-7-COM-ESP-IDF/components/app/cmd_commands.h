@@ -58,6 +58,7 @@ typedef enum {
     // LoRa config commands
     CMD_LORA_FREQ = 0x80,
     CMD_LORA_TIME = 0x81,
+    CMD_TELEMETRY_ACK = 0x82,  // payload: sequence of the received compact telemetry frame
     //Bottle heating commands
     CMD_HEATING = 0x47,
 } cmd_command_t;
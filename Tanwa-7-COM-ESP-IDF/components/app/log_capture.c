@@ -0,0 +1,196 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "log_capture.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "sd_task.h"
+
+#define TAG "LOG_CAPTURE"
+
+typedef struct {
+    char tag[LOG_CAPTURE_TAG_SIZE];
+    esp_log_level_t level;
+} tag_level_t;
+
+static struct {
+    vprintf_like_t uart_vprintf;
+    volatile bool uart_output;
+    volatile esp_log_level_t default_level;
+    tag_level_t tags[LOG_CAPTURE_MAX_TAGS];
+    uint32_t tag_count;
+    uint32_t captured;
+    uint32_t filtered;
+    uint32_t dropped;
+} capture = {
+    .uart_vprintf = NULL,
+    .uart_output = true,
+    .default_level = ESP_LOG_INFO,
+    .tag_count = 0,
+};
+
+static esp_log_level_t get_level(const char *tag) {
+    if (tag == NULL) {
+        return capture.default_level;
+    }
+
+    uint32_t count = __atomic_load_n(&capture.tag_count, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (strcmp(capture.tags[i].tag, tag) == 0) {
+            return capture.tags[i].level;
+        }
+    }
+    return capture.default_level;
+}
+
+/**
+ * @brief Get the level and the tag of the line printed by ESP_LOGx
+ *
+ * @note The ESP_LOGx format is "L (timestamp) %s: ...", optionally with a color prefix. The
+ *       timestamp is a number or a string depending on the timestamp source, both take one
+ *       32-bit argument, so the tag is always the second one.
+ */
+static bool parse_log_line(const char *format, va_list args, esp_log_level_t *level, const char **tag) {
+    const char *letter = format;
+    if (*letter == '\033') {
+        letter = strchr(letter, 'm');
+        if (letter == NULL) {
+            return false;
+        }
+        letter++;
+    }
+
+    switch (*letter) {
+        case 'E': *level = ESP_LOG_ERROR; break;
+        case 'W': *level = ESP_LOG_WARN; break;
+        case 'I': *level = ESP_LOG_INFO; break;
+        case 'D': *level = ESP_LOG_DEBUG; break;
+        case 'V': *level = ESP_LOG_VERBOSE; break;
+        default: return false;
+    }
+    if (strncmp(letter + 1, " (%", 3) != 0) {
+        return false;
+    }
+
+    va_list copy;
+    va_copy(copy, args);
+    (void)va_arg(copy, uint32_t);
+    *tag = va_arg(copy, const char*);
+    va_end(copy);
+    return true;
+}
+
+static int log_capture_vprintf(const char *format, va_list args) {
+    int ret = 0;
+    if (capture.uart_output == true && capture.uart_vprintf != NULL) {
+        va_list copy;
+        va_copy(copy, args);
+        ret = capture.uart_vprintf(format, copy);
+        va_end(copy);
+    }
+
+    esp_log_level_t level = ESP_LOG_INFO;
+    const char *tag = NULL;
+    parse_log_line(format, args, &level, &tag);
+    if (level > get_level(tag)) {
+        __atomic_add_fetch(&capture.filtered, 1, __ATOMIC_RELAXED);
+        return ret;
+    }
+
+    // formatted right in the log ring, the caller stack holds no line buffer, the SD task does
+    // the writing, nothing here can log
+    log_ring_reservation_t reservation;
+    if (SDT_reserve_log(SD_LOG_BUFFER_MAX_SIZE, &reservation) == false) {
+        __atomic_add_fetch(&capture.dropped, 1, __ATOMIC_RELAXED);
+        return ret;
+    }
+    char *line = (char*)reservation.data;
+    size_t size = reservation.length;  // the terminating zero is not part of the record
+    int64_t now = esp_timer_get_time();
+    int length = snprintf(line, size, "[%lld.%06lld] ", now / 1000000, now % 1000000);
+
+    va_list copy;
+    va_copy(copy, args);
+    int message_length = vsnprintf(line + length, size - length, format, copy);
+    va_end(copy);
+    if (message_length < 0) {
+        SDT_commit_log(&reservation, 0);
+        __atomic_add_fetch(&capture.dropped, 1, __ATOMIC_RELAXED);
+        return ret;
+    }
+
+    length += message_length;
+    if (length >= (int)size) {
+        // truncated, keep the line ending
+        length = size - 1;
+        line[length - 1] = '\n';
+    }
+
+    SDT_commit_log(&reservation, length);
+    __atomic_add_fetch(&capture.captured, 1, __ATOMIC_RELAXED);
+    return ret;
+}
+
+esp_err_t log_capture_init(esp_log_level_t level, bool uart_output) {
+    if (capture.uart_vprintf != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    capture.default_level = level;
+    capture.uart_output = uart_output;
+    capture.uart_vprintf = esp_log_set_vprintf(log_capture_vprintf);
+    ESP_LOGI(TAG, "Capturing logs to SD card, level %d, UART output %s", level, uart_output ? "on" : "off");
+    return ESP_OK;
+}
+
+esp_err_t log_capture_set_level(const char *tag, esp_log_level_t level) {
+    if (tag == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (strcmp(tag, "*") == 0) {
+        capture.default_level = level;
+        return ESP_OK;
+    }
+
+    for (uint32_t i = 0; i < capture.tag_count; ++i) {
+        if (strcmp(capture.tags[i].tag, tag) == 0) {
+            capture.tags[i].level = level;
+            return ESP_OK;
+        }
+    }
+
+    if (capture.tag_count >= LOG_CAPTURE_MAX_TAGS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // entries are only appended, the hook sees the new one after the count is published
+    tag_level_t *entry = &capture.tags[capture.tag_count];
+    strncpy(entry->tag, tag, sizeof(entry->tag) - 1);
+    entry->tag[sizeof(entry->tag) - 1] = '\0';
+    entry->level = level;
+    __atomic_store_n(&capture.tag_count, capture.tag_count + 1, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+void log_capture_set_uart_output(bool enable) {
+    capture.uart_output = enable;
+}
+
+bool log_capture_get_uart_output(void) {
+    return capture.uart_output;
+}
+
+void log_capture_get_stats(log_capture_stats_t *stats) {
+    stats->captured = __atomic_load_n(&capture.captured, __ATOMIC_RELAXED);
+    stats->filtered = __atomic_load_n(&capture.filtered, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&capture.dropped, __ATOMIC_RELAXED);
+}
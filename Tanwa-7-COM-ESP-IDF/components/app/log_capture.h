@@ -0,0 +1,68 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the ESP log capture. The log output is hooked with
+/// esp_log_set_vprintf, every line is timestamped and formatted right into a record of the SD task
+/// log ring. The caller only formats the line, all SD card writes are done by the SD task.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_LOG_CAPTURE_H_
+#define PWRINSPACE_LOG_CAPTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#define LOG_CAPTURE_MAX_TAGS 16
+#define LOG_CAPTURE_TAG_SIZE 16
+
+#define LOG_CAPTURE_DEFAULT_LEVEL CONFIG_SD_LOG_CAPTURE_LEVEL
+#ifdef CONFIG_SD_LOG_CAPTURE_UART
+#define LOG_CAPTURE_DEFAULT_UART true
+#else
+#define LOG_CAPTURE_DEFAULT_UART false
+#endif
+
+typedef struct {
+    uint32_t captured;
+    uint32_t filtered;
+    uint32_t dropped;
+} log_capture_stats_t;
+
+/**
+ * @brief Install the log output hook
+ *
+ * @note Call after the SD task is initialized, logs sent before are only printed on UART.
+ *
+ * @param level default capture level for tags without their own level
+ * @param uart_output print the logs also on UART
+ * @return ESP_OK on success
+ */
+esp_err_t log_capture_init(esp_log_level_t level, bool uart_output);
+
+/**
+ * @brief Set the capture level of the tag
+ *
+ * @note Independent of esp_log_level_set, a line has to pass both to be captured.
+ *
+ * @param tag log tag, "*" changes the default level
+ * @param level lowest captured level
+ * @return ESP_ERR_NO_MEM if there is no space for another tag
+ */
+esp_err_t log_capture_set_level(const char *tag, esp_log_level_t level);
+
+void log_capture_set_uart_output(bool enable);
+
+bool log_capture_get_uart_output(void);
+
+void log_capture_get_stats(log_capture_stats_t *stats);
+
+#endif /* PWRINSPACE_LOG_CAPTURE_H_ */
@@ -8,14 +8,20 @@
 #include "freertos/task.h"
 #include "freertos/timers.h"
 
+#include "esp_timer.h"
+
 #include "lora.pb-c.h"
+#include "pb_arena.h"
 
 #include "TANWA_config.h"
+#include "TANWA_data.h"
 #include "mcu_gpio_config.h"
 #include "mcu_spi_config.h"
 #include "mcu_misc_config.h"
 
 #include "cmd_commands.h"
+#include "telemetry_compact.h"
+#include "telemetry_frames.h"
 
 #include "esp_log.h"
 
@@ -24,14 +30,30 @@
 #define LORA_TASK_STACK_SIZE 8192
 #define LORA_TASK_PRIORITY 2
 #define LORA_TASK_CORE 0
+#define LORA_TASK_TX_DEFER_MS 50  // retry of the TX slot while a packet is being received
+#define LORA_TASK_TX_TIMEOUT_MS 3000  // TX done missing, longer than any packet at SF12
+#define LORA_TASK_ARENA_SIZE 256  // unpacked LoRaCommand, reset for every packet
 
 static struct {
     lora_struct_t lora;
     lora_task_process_rx_packet process_packet_fnc;
+    lora_task_get_tx_packet get_tx_packet_fnc;
+    uint32_t transmit_period_ms;
     TaskHandle_t task;
+    int64_t rx_start_us;
+    bool tx_busy;
+    int64_t tx_start_us;
+    TickType_t tx_deadline;  // tick of the TX timeout, other notifications do not restart it
+    volatile int64_t irq_us;  // time of the last DIO0 interrupt
+    pb_arena_t arena;
+    uint8_t arena_buffer[LORA_TASK_ARENA_SIZE] __attribute__((aligned(PB_ARENA_ALIGN)));
+    lora_modem_config_t modem;
+    telemetry_compact_encoder_t compact;
+    lora_task_stats_t stats;
 } gb;
 
 void IRAM_ATTR lora_task_irq_notify(void *arg) {
+    gb.irq_us = esp_timer_get_time();
     BaseType_t higher_priority_task_woken = pdFALSE;
     vTaskNotifyGiveFromISR(gb.task, &higher_priority_task_woken);
     if (higher_priority_task_woken == pdTRUE) {
@@ -75,6 +97,45 @@ static uint8_t calculate_checksum(uint8_t* buffer, size_t size) {
     return sum;
 }
 
+/**
+ * @brief Telemetry packet, the same framing as the commands: prefix, LoRaFrame or compact frame,
+ *        checksum
+ */
+static size_t create_telemetry_packet(uint8_t *buffer, size_t buffer_size) {
+    tanwa_data_t tanwa_data = tanwa_data_read();
+    LoRaFrame frame;
+    telemetry_fill_lora_frame(&tanwa_data, &frame);
+
+    uint8_t prefix_size = sizeof(PACKET_PREFIX) - 1;
+    size_t protobuf_size = lo_ra_frame__get_packed_size(&frame);
+    size_t frame_size = LORA_TASK_COMPACT_TELEMETRY ? TELEMETRY_COMPACT_MAX_SIZE : protobuf_size;
+    if (prefix_size + frame_size + 1 > buffer_size) {
+        ESP_LOGE(TAG, "Telemetry frame too big, %d bytes", frame_size);
+        return 0;
+    }
+
+    memcpy(buffer, PACKET_PREFIX, prefix_size);
+    if (LORA_TASK_COMPACT_TELEMETRY) {
+        telemetry_compact_t compact;
+        telemetry_compact_from_lora_frame(&frame, &compact);
+        uint32_t delta_frames = gb.compact.delta_frames;
+        frame_size = telemetry_compact_encode(&gb.compact, &compact, buffer + prefix_size);
+        gb.stats.telemetry_delta += gb.compact.delta_frames - delta_frames;
+    } else {
+        lo_ra_frame__pack(&frame, buffer + prefix_size);
+    }
+    buffer[prefix_size + frame_size] = calculate_checksum(buffer + prefix_size, frame_size);
+
+    size_t size = prefix_size + frame_size + 1;
+    size_t protobuf_packet_size = prefix_size + protobuf_size + 1;
+    gb.stats.telemetry_frames++;
+    gb.stats.telemetry_bytes += size;
+    gb.stats.telemetry_protobuf_bytes += protobuf_packet_size;
+    gb.stats.telemetry_time_on_air_us += lora_task_time_on_air_us(size);
+    gb.stats.telemetry_protobuf_time_on_air_us += lora_task_time_on_air_us(protobuf_packet_size);
+    return size;
+}
+
 static void lora_process(uint8_t* packet, size_t packet_size) {
     if (packet_size > 40) {
         ESP_LOGI(TAG, "Recevied packet is too big");
@@ -96,14 +157,16 @@ static void lora_process(uint8_t* packet, size_t packet_size) {
 
     ESP_LOGI(TAG, "Received packet: %s", packet + prefix_size);
 
+    // the previous command is no longer used, its memory is reused without the heap
+    pb_arena_reset(&gb.arena);
     LoRaCommand* received =
-        lo_ra_command__unpack(NULL, packet_size - prefix_size - 1, packet + prefix_size);
+        lo_ra_command__unpack(&gb.arena.allocator, packet_size - prefix_size - 1, packet + prefix_size);
     if (received != NULL) {
         ESP_LOGI(TAG, "Received LORA_ID %d, DEV_ID %d, COMMAND %d, PLD %d", received->lora_dev_id,
                  received->sys_dev_id, received->command, received->payload);
         // cmd_message_t received_command = cmd_create_message(received->command, received->payload);
         lora_command_parsing(received->lora_dev_id, received->command, received->payload);
-        lo_ra_command__free_unpacked(received, NULL);
+        lo_ra_command__free_unpacked(received, &gb.arena.allocator);
     } else {
         ESP_LOGE(TAG, "Unable to decode received package");
     }
@@ -114,6 +177,7 @@ bool initialize_lora(uint32_t frequency_khz, uint32_t transmiting_period) {
     _lora_gpio_attach_d0_isr(lora_task_irq_notify);
     lora_struct_t lora = {
         ._spi_transmit = _lora_spi_transmit,
+        ._spi_transmit_burst = _lora_spi_transmit_burst,
         ._delay = _lora_delay_ms,
         ._gpio_set_level = _lora_gpio_set_level,
         .log = _lora_log,
@@ -126,6 +190,7 @@ bool initialize_lora(uint32_t frequency_khz, uint32_t transmiting_period) {
     lora_api_config_t cfg = {
         .lora = &lora,
         .process_rx_packet_fnc = lora_process,
+        .get_tx_packet_fnc = create_telemetry_packet,
         .frequency_khz = frequency_khz,
         .transmiting_period = transmiting_period,
     };
@@ -133,6 +198,22 @@ bool initialize_lora(uint32_t frequency_khz, uint32_t transmiting_period) {
     return true;
 }
 
+/**
+ * @brief Modem settings the task sets, the chip defaults except the bandwidth and CRC
+ */
+static lora_modem_config_t configured_modem(void) {
+    lora_modem_config_t modem = {
+        .sf = LORA_SF_128_CoS,
+        .bw = LORA_TASK_BANDWIDTH,
+        .coding_rate = 5,
+        .preamble_length = 8,
+        .implicit_header = false,
+        .crc = LORA_TASK_CRC_ENABLE,
+        .low_data_rate_optimize = false,
+    };
+    return modem;
+}
+
 bool lora_task_init(lora_api_config_t *cfg) {
     assert(cfg != NULL);
     if (cfg == NULL) {
@@ -144,6 +225,10 @@ bool lora_task_init(lora_api_config_t *cfg) {
     }
 
     gb.process_packet_fnc = cfg->process_rx_packet_fnc;
+    gb.get_tx_packet_fnc = cfg->get_tx_packet_fnc;
+    gb.transmit_period_ms = cfg->get_tx_packet_fnc != NULL ? cfg->transmiting_period : 0;
+    pb_arena_init(&gb.arena, gb.arena_buffer, sizeof(gb.arena_buffer));
+    telemetry_compact_encoder_init(&gb.compact, LORA_TASK_COMPACT_DELTA);
     memcpy(&gb.lora, cfg->lora, sizeof(lora_struct_t));
 
     lora_init(&gb.lora);
@@ -151,12 +236,19 @@ bool lora_task_init(lora_api_config_t *cfg) {
     lora_set_bandwidth(&gb.lora, LORA_TASK_BANDWIDTH);
     lora_map_d0_interrupt(&gb.lora, LORA_IRQ_D0_RXDONE);
     lora_set_receive_mode(&gb.lora);
+    lora_task_reset_stats();
 
     if (LORA_TASK_CRC_ENABLE) {
         lora_enable_crc(&gb.lora);
     } else {
         lora_disable_crc(&gb.lora);
     }
+    gb.modem = configured_modem();
+    if (lora_get_modem_config(&gb.lora, &gb.modem) != LORA_OK) {
+        ESP_LOGE(TAG, "Invalid modem config, the airtime is counted for the configured one");
+    }
+    ESP_LOGI(TAG, "Modem SF %d, BW %d, CR 4/%d, preamble %d, CRC %d", gb.modem.sf, gb.modem.bw,
+             gb.modem.coding_rate, gb.modem.preamble_length, gb.modem.crc);
 
     ESP_LOGI(TAG, "Reading LoRa registers");
     int16_t read_val_one = lora_read_reg(&gb.lora, 0x0d);
@@ -182,24 +274,170 @@ bool lora_change_frequency(uint32_t frequency_khz) {
     return true;
 }
 
+/**
+ * @brief Time in the receive mode since the last start or the statistics reset
+ */
+static int64_t receive_time_us(int64_t now) {
+    return now - (gb.rx_start_us > gb.stats.since_us ? gb.rx_start_us : gb.stats.since_us);
+}
+
+static void start_receive(void) {
+    lora_map_d0_interrupt(&gb.lora, LORA_IRQ_D0_RXDONE);
+    lora_set_receive_mode(&gb.lora);
+    gb.rx_start_us = esp_timer_get_time();
+}
+
+/**
+ * @brief TX slot, the radio leaves the receive mode only for the packet airtime
+ *
+ * @note Returns after the packet is in the FIFO, the TX done interrupt finishes the slot.
+ */
+static void start_transmit(void) {
+    uint8_t tx_buffer[LORA_TASK_TX_BUFFER_SIZE];
+    size_t size = gb.get_tx_packet_fnc(tx_buffer, sizeof(tx_buffer));
+    if (size == 0) {
+        gb.stats.tx_skipped++;
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    gb.stats.rx_us += receive_time_us(start);
+    lora_err_t ret = lora_send_packet_async(&gb.lora, tx_buffer, size);
+    gb.tx_start_us = esp_timer_get_time();
+    latency_hist_add(&gb.stats.fifo_write, gb.tx_start_us - start);
+    if (ret != LORA_OK) {
+        gb.stats.tx_errors++;
+        ESP_LOGE(TAG, "Telemetry transmit failed");
+        start_receive();
+        return;
+    }
+    gb.tx_busy = true;
+    gb.tx_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(LORA_TASK_TX_TIMEOUT_MS);
+    gb.stats.tx_bytes += size;
+}
+
+/**
+ * @param done_us time of the TX done interrupt, or of the timeout
+ */
+static void finish_transmit(int64_t done_us) {
+    gb.tx_busy = false;
+    bool done = lora_check_tx_done(&gb.lora);
+    lora_write_irq_flags(&gb.lora);
+    start_receive();
+
+    int64_t airtime = done_us - gb.tx_start_us;
+    gb.stats.tx_us += airtime;
+    if (done == false) {
+        gb.stats.tx_errors++;
+        gb.stats.tx_timeouts++;
+        ESP_LOGE(TAG, "Telemetry transmit timeout");
+        return;
+    }
+    gb.stats.tx_count++;
+    latency_hist_add(&gb.stats.airtime, airtime);
+    ESP_LOGD(TAG, "Telemetry sent, airtime %lld us", airtime);
+}
+
+static TickType_t ticks_until(TickType_t deadline) {
+    TickType_t now = xTaskGetTickCount();
+    return (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+}
+
+/**
+ * @brief Time to the next TX slot, the task waits for the RX interrupt until then
+ */
+static TickType_t time_to_slot(TickType_t next_tx) {
+    if (gb.transmit_period_ms == 0) {
+        return portMAX_DELAY;
+    }
+    return ticks_until(next_tx);
+}
+
+/**
+ * @brief Slot after the finished one, the ground station always gets the whole receive window
+ *        between the packets
+ */
+static TickType_t schedule_next_slot(TickType_t previous) {
+    TickType_t rx_window_end = xTaskGetTickCount() + pdMS_TO_TICKS(LORA_TASK_RECEIVE_WINDOW);
+    TickType_t next_tx = previous + pdMS_TO_TICKS(gb.transmit_period_ms);
+    return (int32_t)(rx_window_end - next_tx) > 0 ? rx_window_end : next_tx;
+}
+
 void lora_task(void* pvParameters) {
     ESP_LOGI(TAG, "LoRa Task started");
 
     uint8_t rx_buffer[256];
     size_t rx_packet_size = 0;
+    TickType_t next_tx = xTaskGetTickCount() + pdMS_TO_TICKS(gb.transmit_period_ms);
+    gb.rx_start_us = esp_timer_get_time();
 
     while (1) {
-        if (ulTaskNotifyTake(pdTRUE, portMAX_DELAY) == pdTRUE) {
+        TickType_t timeout = gb.tx_busy ? ticks_until(gb.tx_deadline) : time_to_slot(next_tx);
+        if (ulTaskNotifyTake(pdTRUE, timeout) == pdTRUE) {
+            if (gb.tx_busy == true) {
+                // DIO0 is mapped to TX done until the slot is finished, skip a notification left from RX
+                if (lora_check_tx_done(&gb.lora) == false) {
+                    continue;
+                }
+                finish_transmit(gb.irq_us);
+                next_tx = schedule_next_slot(next_tx);
+                continue;
+            }
             ESP_LOGI(TAG, "IRQ received");
             if (lora_received(&gb.lora) == LORA_OK) {
                 rx_packet_size = on_lora_receive(rx_buffer, sizeof(rx_buffer));
                 if (rx_packet_size > 0 && gb.process_packet_fnc != NULL) {
                     ESP_LOGI(TAG, "Processing packet");
+                    gb.stats.rx_count++;
                     gb.process_packet_fnc(rx_buffer, rx_packet_size);
                     vTaskDelay(pdMS_TO_TICKS(100));
                 }
             }
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        if (gb.tx_busy == true) {
+            finish_transmit(esp_timer_get_time());
+            next_tx = schedule_next_slot(next_tx);
+            continue;
+        }
+        if (gb.transmit_period_ms == 0) {
+            continue;
+        }
+        if (lora_rx_in_progress(&gb.lora) == true || lora_received(&gb.lora) == LORA_OK) {
+            // do not cut off or overwrite the command in the FIFO, the slot waits for the RX done
+            gb.stats.tx_deferred++;
+            next_tx = xTaskGetTickCount() + pdMS_TO_TICKS(LORA_TASK_TX_DEFER_MS);
+            continue;
+        }
+
+        start_transmit();
+        if (gb.tx_busy == false) {
+            next_tx = schedule_next_slot(next_tx);
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
-}
\ No newline at end of file
+}
+
+bool lora_task_telemetry_ack(uint8_t sequence) {
+    return telemetry_compact_ack(&gb.compact, sequence);
+}
+
+uint32_t lora_task_time_on_air_us(size_t size) {
+    return lora_time_on_air_us(&gb.modem, size);
+}
+
+void lora_task_get_stats(lora_task_stats_t *stats) {
+    *stats = gb.stats;
+    stats->arena_max_used = gb.arena.max_used;
+    stats->arena_failures = gb.arena.failures;
+    // the current receive interval is not added yet
+    if (gb.tx_busy == false) {
+        stats->rx_us += receive_time_us(esp_timer_get_time());
+    }
+}
+
+void lora_task_reset_stats(void) {
+    memset(&gb.stats, 0, sizeof(gb.stats));
+    gb.stats.since_us = esp_timer_get_time();
+}
@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "lora.h"
+#include "latency_hist.h"
 
 #define LORA_TASK_CRC_ENABLE 0
 #define LORA_TASK_FREQUENCY_KHZ 869525
@@ -12,6 +13,9 @@
 #define LORA_TASK_SPREADING_FACTOR 1
 #define LORA_TASK_RECEIVE_WINDOW 1500
 #define LORA_TASK_TRANSMIT_MS 1800
+#define LORA_TASK_TX_BUFFER_SIZE 255  // FIFO limit of the radio
+#define LORA_TASK_COMPACT_TELEMETRY 0  // bit-packed frames instead of the LoRaFrame protobuf
+#define LORA_TASK_COMPACT_DELTA 1  // compact delta frames after the ground station acknowledges
 
 #define PRIVILAGE_MASK 0x01
 #define BORADCAST_DEV_ID 0x00
@@ -34,9 +38,32 @@ typedef struct {
     lora_task_get_tx_packet get_tx_packet_fnc;
     lora_struct_t *lora;
     uint32_t frequency_khz;
-    uint32_t transmiting_period;
+    uint32_t transmiting_period;  // 0 to only receive
 } lora_api_config_t;
 
+typedef struct {
+    uint32_t tx_count;
+    uint32_t tx_errors;
+    uint32_t tx_skipped;  // no packet to send in the slot
+    uint32_t tx_deferred;  // slot moved because a packet was being received
+    uint32_t tx_bytes;
+    uint32_t rx_count;
+    uint32_t arena_max_used;  // command decode memory, since boot
+    uint32_t arena_failures;
+    uint32_t tx_timeouts;  // no TX done interrupt
+    uint32_t telemetry_frames;  // telemetry packets built
+    uint32_t telemetry_delta;  // of them compact delta frames
+    uint32_t telemetry_bytes;
+    uint32_t telemetry_protobuf_bytes;  // the same frames as the LoRaFrame protobuf packet
+    uint64_t telemetry_time_on_air_us;  // computed from the modem settings
+    uint64_t telemetry_protobuf_time_on_air_us;
+    latency_hist_t fifo_write;  // packet copied to the radio
+    latency_hist_t airtime;  // from the TX start to the TX done interrupt
+    uint64_t tx_us;  // radio transmitting
+    uint64_t rx_us;  // radio in the receive mode
+    int64_t since_us;  // time of the last reset
+} lora_task_stats_t;
+
 /**
  * @brief Initialize lora api and run lora task
  *q
@@ -67,4 +94,34 @@ bool lora_task_init(lora_api_config_t *cfg);
 
 void lora_task(void* pvParameters);
 
+/**
+ * @brief The ground station received the compact telemetry frame, the next frames can be deltas
+ *
+ * @note Call from the LoRa task, the commands are parsed there.
+ *
+ * @param sequence sequence of the frame
+ * @return false if the frame is too old
+ */
+bool lora_task_telemetry_ack(uint8_t sequence);
+
+/**
+ * @brief Time on air of a packet with the current modem settings
+ *
+ * @param size packet size in bytes
+ */
+uint32_t lora_task_time_on_air_us(size_t size);
+
+/**
+ * @brief Get the link statistics of the lora task
+ *
+ * @param stats pointer to the statistics copy
+ */
+void lora_task_get_stats(lora_task_stats_t *stats);
+
+/**
+ * @brief Clear the link statistics
+ *
+ */
+void lora_task_reset_stats(void);
+
 #endif
\ No newline at end of file
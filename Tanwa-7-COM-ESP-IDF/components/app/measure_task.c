@@ -19,6 +19,7 @@
 #include "TANWA_data.h"
 
 #include "now.h"
+#include "telemetry_frames.h"
 
 #include "mcu_gpio_config.h"
 #include "state_machine_config.h"
@@ -68,31 +69,7 @@ void change_measure_task_period(uint32_t period_ms) {
 void copy_tanwa_data_to_now_struct(DataToObc *now_struct){
     // Get data from shared memory
     tanwa_data_t tanwa_data = tanwa_data_read();
-    // Copy data to now struct
-    now_struct->vbat = tanwa_data.com_data.vbat;
-    now_struct->tanWaState = tanwa_data.state;
-    now_struct->rocketWeight_val = tanwa_data.can_hx_rocket_data.weight;
-    now_struct->tankWeight_val = tanwa_data.can_hx_oxidizer_data.weight;
-    now_struct->fill_temp = tanwa_data.can_flc_data.temperature_1;
-    now_struct->preFill_pres = tanwa_data.com_data.pressure_1;
-    now_struct->postFill_pres = tanwa_data.com_data.pressure_2;
-    now_struct->tank_pres = tanwa_data.com_data.pressure_3;
-    now_struct->canHxBtl_con = tanwa_data.can_connected_slaves.hx_oxidizer;
-    now_struct->canHxRck_con = tanwa_data.can_connected_slaves.hx_rocket;
-    now_struct->canFac_con = tanwa_data.can_connected_slaves.fac;
-    now_struct->canFlc_con = tanwa_data.can_connected_slaves.flc;
-    now_struct->canTermo_con = tanwa_data.can_connected_slaves.termo;
-    now_struct->igniterContinouity_1 = tanwa_data.com_data.igniter_cont_1;
-    now_struct->igniterContinouity_2 = tanwa_data.com_data.igniter_cont_2;
-    now_struct->limitSwitch_1 = tanwa_data.can_fac_status.limit_switch_1;
-    now_struct->limitSwitch_2 = tanwa_data.can_fac_status.limit_switch_2;
-    now_struct->facMotorState_1 = tanwa_data.can_fac_status.motor_state_1;
-    now_struct->facMotorState_2 = tanwa_data.can_fac_status.motor_state_2;
-    now_struct->coolingState = tanwa_data.can_termo_status.cooling_status;
-    now_struct->heatingState = tanwa_data.can_termo_status.heating_status;
-    now_struct->abortButton = tanwa_data.com_data.abort_button;
-    now_struct->fillState = tanwa_data.com_data.solenoid_state_fill;
-    now_struct->deprState = tanwa_data.com_data.solenoid_state_depr;
+    telemetry_fill_now_frame(&tanwa_data, now_struct);
 }
 
 void measure_task(void* pvParameters) {
@@ -153,10 +130,9 @@ void measure_task(void* pvParameters) {
             com_data.pressure_3 = pressure[2];
             com_data.pressure_4 = pressure[3];
 
-            // Measure temperature
-            for (int i = 0; i < 2; ++i) {
-                tmp1075_get_temp_celsius(&(TANWA_hardware.tmp1075[i]), &temp[i]);
-            }
+            // Temperature is acquired by the temperature task, take the last sample
+            temperature_driver_get_temperature(&(TANWA_utility.temperature_driver), TEMPERATURE_DRIVER_SENSOR_1, &temp[0]);
+            temperature_driver_get_temperature(&(TANWA_utility.temperature_driver), TEMPERATURE_DRIVER_SENSOR_2, &temp[1]);
             // ESP_LOGI(TAG, "Temperature sensors 1: %.2f, 2: %.2f", temp[0], temp[1]);
             com_data.temperature_1 = temp[0];
             com_data.temperature_2 = temp[1];
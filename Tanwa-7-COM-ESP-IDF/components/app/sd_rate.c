@@ -0,0 +1,140 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "sd_rate.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "timers_config.h"
+
+#define TAG "SD_RATE"
+
+#define STATE_TEXT_SIZE 32
+
+static struct {
+    uint32_t periods_ms[SD_RATE_STATE_COUNT];
+    uint32_t period_ms;  // period of the running timer, 0 if not started
+    SemaphoreHandle_t mutex;
+} rate = {
+    .periods_ms = {
+        [INIT] = SD_RATE_IDLE_PERIOD_MS,
+        [IDLE] = SD_RATE_IDLE_PERIOD_MS,
+        [RECOVERY_ARM] = SD_RATE_FUELING_PERIOD_MS,
+        [FUELING] = SD_RATE_FUELING_PERIOD_MS,
+        [ARMED_TO_LAUNCH] = SD_RATE_FUELING_PERIOD_MS,
+        [RDY_TO_LAUNCH] = SD_RATE_FUELING_PERIOD_MS,
+        [COUNTDOWN] = SD_RATE_FLIGHT_PERIOD_MS,
+        [FLIGHT] = SD_RATE_FLIGHT_PERIOD_MS,
+        [FIRST_STAGE_RECOVERY] = SD_RATE_FLIGHT_PERIOD_MS,
+        [SECOND_STAGE_RECOVERY] = SD_RATE_FLIGHT_PERIOD_MS,
+        [ON_GROUND] = SD_RATE_FLIGHT_PERIOD_MS,
+        [HOLD] = SD_RATE_FUELING_PERIOD_MS,
+        [ABORT] = SD_RATE_FLIGHT_PERIOD_MS,
+    },
+    .period_ms = 0,
+    .mutex = NULL,
+};
+
+static uint32_t state_period(uint8_t state) {
+    return state < SD_RATE_STATE_COUNT ? rate.periods_ms[state] : SD_RATE_FLIGHT_PERIOD_MS;
+}
+
+/**
+ * @param after_sample called right after a sample, the new period can start at once
+ */
+static void follow_state(bool after_sample) {
+    if (rate.period_ms == 0) {
+        return;
+    }
+
+    uint8_t state = state_machine_get_current_state();
+    uint32_t period_ms = state_period(state);
+    if (period_ms == rate.period_ms) {
+        return;
+    }
+
+    if (after_sample == false) {
+        // a slower rate waits for the planned sample, a faster one starts if it comes earlier
+        uint64_t expiry;
+        if (sys_timer_get_expiry_time(TIMER_SD_DATA, &expiry) == true &&
+            (int64_t)expiry - esp_timer_get_time() <= (int64_t)period_ms * 1000) {
+            return;
+        }
+    }
+
+    if (sys_timer_restart(TIMER_SD_DATA, period_ms) == false) {
+        ESP_LOGE(TAG, "Unable to change the SD data period");
+        return;
+    }
+
+    char text[STATE_TEXT_SIZE];
+    get_state_text(state, text);
+    ESP_LOGI(TAG, "SD data period %u -> %u ms in %s", rate.period_ms, period_ms, text);
+    rate.period_ms = period_ms;
+}
+
+bool sd_rate_start(void) {
+    if (rate.mutex == NULL) {
+        rate.mutex = xSemaphoreCreateMutex();
+        if (rate.mutex == NULL) {
+            return false;
+        }
+    }
+
+    uint32_t period_ms = state_period(state_machine_get_current_state());
+    if (sys_timer_start(TIMER_SD_DATA, period_ms, TIMER_TYPE_PERIODIC) == false) {
+        return false;
+    }
+
+    rate.period_ms = period_ms;
+    ESP_LOGI(TAG, "SD data period %u ms", period_ms);
+    return true;
+}
+
+void sd_rate_update(void) {
+    if (rate.mutex == NULL || xSemaphoreTake(rate.mutex, portMAX_DELAY) == pdFALSE) {
+        return;
+    }
+
+    follow_state(false);
+    xSemaphoreGive(rate.mutex);
+}
+
+void sd_rate_on_timer(void) {
+    // the timer task does not wait, the next sample checks again
+    if (rate.mutex == NULL || xSemaphoreTake(rate.mutex, 0) == pdFALSE) {
+        return;
+    }
+
+    follow_state(true);
+    xSemaphoreGive(rate.mutex);
+}
+
+bool sd_rate_set_period(uint8_t state, uint32_t period_ms) {
+    if (state >= SD_RATE_STATE_COUNT || period_ms < SD_RATE_MIN_PERIOD_MS || period_ms > SD_RATE_MAX_PERIOD_MS) {
+        return false;
+    }
+
+    char text[STATE_TEXT_SIZE];
+    get_state_text(state, text);
+    ESP_LOGI(TAG, "SD data period of %s %u -> %u ms", text, rate.periods_ms[state], period_ms);
+    rate.periods_ms[state] = period_ms;
+    sd_rate_update();
+    return true;
+}
+
+uint32_t sd_rate_get_period(uint8_t state) {
+    return state < SD_RATE_STATE_COUNT ? rate.periods_ms[state] : 0;
+}
+
+uint32_t sd_rate_get_current_period(void) {
+    return rate.period_ms;
+}
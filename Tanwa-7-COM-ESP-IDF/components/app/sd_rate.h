@@ -0,0 +1,73 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the state-aware SD logging rate. Every state has its own
+/// period of the SD data timer. The period follows the state machine: a faster rate starts at
+/// once, a slower one after the next sample, so no sample is doubled and no gap is longer than
+/// the old period. The profiles can be changed at runtime, every change is logged.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_SD_RATE_H_
+#define PWRINSPACE_SD_RATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#include "state_machine_config.h"
+
+#define SD_RATE_STATE_COUNT (ABORT + 1)
+#define SD_RATE_MIN_PERIOD_MS 5
+#define SD_RATE_MAX_PERIOD_MS 60000
+
+#define SD_RATE_IDLE_PERIOD_MS CONFIG_SD_RATE_IDLE_PERIOD_MS
+#define SD_RATE_FUELING_PERIOD_MS CONFIG_SD_RATE_FUELING_PERIOD_MS
+#define SD_RATE_FLIGHT_PERIOD_MS CONFIG_SD_RATE_FLIGHT_PERIOD_MS
+
+/**
+ * @brief Start the SD data timer with the period of the current state
+ *
+ * @return true :D
+ * @return false :C
+ */
+bool sd_rate_start(void);
+
+/**
+ * @brief Follow the current state, called from the state callbacks
+ */
+void sd_rate_update(void);
+
+/**
+ * @brief Follow the current state right after a sample, called from the SD data timer
+ *
+ * @note Also catches the state changes made without a callback.
+ */
+void sd_rate_on_timer(void);
+
+/**
+ * @brief Change the period of the state
+ *
+ * @param state state of the state machine
+ * @param period_ms period of the SD data
+ * @return true :D
+ * @return false :C state or period out of range
+ */
+bool sd_rate_set_period(uint8_t state, uint32_t period_ms);
+
+/**
+ * @return period of the state, 0 if the state is out of range
+ */
+uint32_t sd_rate_get_period(uint8_t state);
+
+/**
+ * @return period the SD data timer runs with
+ */
+uint32_t sd_rate_get_current_period(void);
+
+#endif /* PWRINSPACE_SD_RATE_H_ */
@@ -1,114 +1,1445 @@
 // Copyright 2022 PWr in Space, Kuba
 #include "sd_task.h"
 
+#include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/timers.h"
 
-#include "TANWA_data.h"
+#include "TANWA_data.h"
+#include "tanwa_log_format.h"
+#include "log_ring.h"
+#include "record_codec.h"
+#include "spill_buffer.h"
+#include "backpressure.h"
+#include "record_summary.h"
+
+#include "sd_task.h"
+
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "esp_idf_version.h"
+#include "nvs_flash.h"
+
+#include "esp_log.h"
+
+#define TAG "SD_TASK"
+
+#define SD_TASK_STACK_SIZE 8192
+#define SD_TASK_PRIORITY 5
+#define SD_TASK_CORE_ID 0
+
+// the chunks are aligned to the buffer size, a partial sector would be read and rewritten by FATFS
+#if SD_DATA_WRITE_BUFFER_SIZE % 512 != 0
+#error "CONFIG_SD_WRITE_BUFFER_SIZE has to be a multiple of 512"
+#endif
+
+extern SemaphoreHandle_t mutex_spi;
+
+/**
+ * @brief File kept open for the whole session, written through the buffer
+ *
+ * @note The buffer is written only when it reaches the next multiple of its size in the file,
+ *       so the card gets whole aligned chunks. A sync writes the partial buffer and seeks back to
+ *       its beginning, the next full write overwrites it, so the alignment is kept.
+ *
+ * @note A preallocated file is longer than the data in it, the end of the data (high-water mark)
+ *       is kept in the sidecar file on every sync. The file is truncated to it when closed,
+ *       or on the next boot if it was not closed.
+ */
+typedef struct {
+    FILE *file;
+    FILE *hwm_file;
+    char *path;
+    size_t preallocate_size;
+    bool preallocated;
+    uint8_t *buffer;
+    size_t buffer_size;
+    size_t buffer_used;
+    size_t buffer_written;  // bytes of the buffer already written by a sync, rewritten with the chunk
+    size_t offset;  // position of the first buffered byte in the file
+    bool offset_valid;
+} sd_file_t;
+
+/**
+ * @brief Circular file of the recent full-rate records
+ *
+ * @note The records are collected in the block buffer, a full block is written to its slot and
+ *       the next one starts, so an old block is overwritten in one write. A sync writes the
+ *       partial block to the same slot. The ring id tells the blocks of this file from the stale
+ *       data of the clusters it got.
+ *
+ * @note A freeze copies the blocks oldest first to the frozen file. The copy is done in steps,
+ *       the writer copies the oldest block itself before its slot is overwritten.
+ */
+typedef struct {
+    FILE *file;
+    char path[SD_PATH_SIZE];
+    bool created;
+    uint32_t ring_id;
+    uint32_t block_count;  // 0 if the two-tier logging is disabled
+    uint32_t block_sequence;  // sequence of the block in the buffer
+    uint32_t frame_sequence;
+    uint8_t *buffer;
+    size_t used;
+
+    bool freezing;
+    FILE *frozen_file;
+    char frozen_path[SD_PATH_SIZE];
+    uint32_t freeze_count;
+    uint32_t copy_next;  // next block sequence to copy
+    uint32_t copy_end;
+    uint8_t *copy_buffer;
+    int64_t freeze_start_us;
+} sd_ring_t;
+
+static struct {
+    sd_card_t sd_card;
+
+    TaskHandle_t sd_task;
+    QueueHandle_t data_queue;
+    SemaphoreHandle_t data_write_mutex;  // prevent race condition during path changing
+    SemaphoreHandle_t spi_mutex;
+
+    void *data_from_queue;
+    size_t data_from_queue_size;
+    size_t queue_item_size;  // data and its decimation byte
+    void *discarded_item;  // the oldest item removed by BACKPRESSURE_DROP_OLDEST, never read
+    uint8_t *send_item;  // item staged by the producer in SDT_send_data, not on its stack
+    char data_buffer[SD_DATA_BUFFER_MAX_SIZE];
+    log_ring_t log_ring;
+    spill_buffer_t spill;  // data received while the card can not be written
+    backpressure_t backpressure;
+    backpressure_counters_t accounted;  // counters at the last backpressure frame
+    int64_t accounted_us;
+    uint8_t written_decimation;  // decimation of the last written record
+    uint8_t log_ring_buffer[SD_LOG_RING_SIZE] __attribute__((aligned(4)));
+
+    char session_path[SD_PATH_SIZE];
+    char data_path[SD_PATH_SIZE];  // current segment of the session
+    char log_path[SD_PATH_SIZE];
+    sd_file_t data_file;
+    sd_file_t log_file;
+
+    record_codec_t *codec;  // NULL if the data is not compressed
+    sd_ring_t ring;
+    record_summary_t *summary;  // NULL if the two-tier logging is disabled
+    uint32_t summary_interval_ms;
+    volatile bool freeze_requested;
+    uint32_t frame_sequence;  // continues over the segments of the session
+
+    FILE *index_file;
+    tanwa_log_index_entry_t segment;  // index entry of the current segment
+    uint32_t segment_samples;  // samples in the time span of the segment, with those in the recent file
+    int64_t segment_start_us;
+    size_t segment_size;
+    uint32_t segment_duration_ms;
+
+    uint32_t try_to_mount_counter;
+    bool data_file_new;
+    uint32_t sync_interval_ms;
+    int64_t last_sync_us;
+    volatile bool sync_requested;
+    volatile bool benchmark_running;
+    sd_task_stats_t stats;
+
+    error_handler error_handler_fnc;
+    create_sd_frame create_sd_frame_fnc;
+    create_sd_header create_sd_header_fnc;
+    get_sd_data_info get_data_info_fnc;
+} mem = {
+    .sd_task = NULL,
+    .data_write_mutex = NULL,
+    .codec = NULL,
+    .index_file = NULL,
+};
+
+static void report_error(SD_TASK_ERR error_code) {
+    if (mem.error_handler_fnc == NULL) {
+        return;
+    }
+
+    mem.error_handler_fnc(error_code);
+}
+
+
+static void create_hwm_path(const char *path, char *hwm_path, size_t size) {
+    const char *extension = strrchr(path, '.');
+    int name_length = extension != NULL ? extension - path : (int)strlen(path);
+    snprintf(hwm_path, size, "%.*s" SD_HWM_FILE_EXTENSION, name_length, path);
+}
+
+static bool file_allocate(sd_file_t *file, char *path, size_t buffer_size, size_t preallocate_size) {
+    file->file = NULL;
+    file->hwm_file = NULL;
+    file->path = path;
+    file->preallocate_size = preallocate_size;
+    file->preallocated = false;
+    file->buffer_size = buffer_size;
+    file->buffer_used = 0;
+    file->buffer_written = 0;
+    file->offset = 0;
+    file->offset_valid = false;
+    // DMA capable buffer lets the SPI driver send the sectors without a bounce buffer
+    file->buffer = heap_caps_aligned_alloc(4, buffer_size, MALLOC_CAP_DMA);
+    return file->buffer != NULL;
+}
+
+static void file_free(sd_file_t *file) {
+    heap_caps_free(file->buffer);
+    file->buffer = NULL;
+}
+
+static bool file_preallocate(sd_file_t *file) {
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    if (esp_vfs_fat_create_contiguous_file(SD_MOUNT_POINT, file->path, file->preallocate_size, true) != ESP_OK) {
+        return false;
+    }
+#else
+    // no contiguous allocation in this FATFS port, extending the file still allocates the whole
+    // cluster chain now instead of during the writes
+    FILE *new_file = fopen(file->path, "w");
+    if (new_file == NULL) {
+        return false;
+    }
+    bool ret = fseek(new_file, file->preallocate_size - 1, SEEK_SET) == 0 && fputc(0, new_file) != EOF;
+    fclose(new_file);
+    if (ret == false) {
+        remove(file->path);
+        return false;
+    }
+#endif
+    return true;
+}
+
+static bool file_open_hwm(sd_file_t *file, bool create) {
+    char hwm_path[SD_PATH_SIZE];
+    create_hwm_path(file->path, hwm_path, sizeof(hwm_path));
+    file->hwm_file = fopen(hwm_path, create == true ? "w" : "r+");
+    if (file->hwm_file == NULL) {
+        return false;
+    }
+    setvbuf(file->hwm_file, NULL, _IONBF, 0);
+    return true;
+}
+
+static bool file_open(sd_file_t *file) {
+    if (file->file != NULL) {
+        return true;
+    }
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    bool exists = SD_file_exists(file->path);
+    if (exists == false && file->preallocate_size > 0) {
+        int64_t start = esp_timer_get_time();
+        if (file_preallocate(file) == true && file_open_hwm(file, true) == true) {
+            ESP_LOGI(TAG, "Preallocated %u B for %s in %lld us", file->preallocate_size, file->path,
+                     esp_timer_get_time() - start);
+            exists = true;
+            file->preallocated = true;
+            file->offset = 0;
+            file->offset_valid = true;
+        } else {
+            ESP_LOGW(TAG, "Unable to preallocate %s", file->path);
+            exists = SD_file_exists(file->path);
+        }
+    } else if (file->preallocated == true && file->hwm_file == NULL) {
+        file_open_hwm(file, false);
+    }
+    file->file = fopen(file->path, exists == true ? "r+" : "w");
+    if (file->file != NULL) {
+        // the data goes to the card in whole chunks, a stdio buffer would only copy it again
+        setvbuf(file->file, NULL, _IONBF, 0);
+        if (file->offset_valid == true) {
+            // reopened after remount, continue where the buffer starts
+            fseek(file->file, file->offset, SEEK_SET);
+        } else {
+            fseek(file->file, 0, SEEK_END);
+            file->offset = ftell(file->file);
+            file->offset_valid = true;
+        }
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (file->file == NULL) {
+        ESP_LOGE(TAG, "Can not open the file %s", file->path);
+        return false;
+    }
+
+    return true;
+}
+
+static void close_files_and_remount(void) {
+    // the buffers and offsets are kept, the files are reopened after the card is mounted again
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    sd_file_t *files[] = {&mem.data_file, &mem.log_file};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        if (files[i]->file != NULL) {
+            fclose(files[i]->file);
+            files[i]->file = NULL;
+        }
+        if (files[i]->hwm_file != NULL) {
+            fclose(files[i]->hwm_file);
+            files[i]->hwm_file = NULL;
+        }
+    }
+    if (mem.index_file != NULL) {
+        fclose(mem.index_file);
+        mem.index_file = NULL;
+    }
+    if (mem.ring.file != NULL) {
+        fclose(mem.ring.file);
+        mem.ring.file = NULL;
+    }
+    if (mem.ring.frozen_file != NULL) {
+        fclose(mem.ring.frozen_file);
+        mem.ring.frozen_file = NULL;
+    }
+    SD_remount(&mem.sd_card);
+    xSemaphoreGive(mem.spi_mutex);
+
+    mem.stats.error_count++;
+    report_error(SD_WRITE);
+}
+
+static bool file_write_buffer(sd_file_t *file, size_t size) {
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    size_t written = fwrite(file->buffer, 1, size, file->file);
+    xSemaphoreGive(mem.spi_mutex);
+    int64_t time = esp_timer_get_time() - start;
+
+    if (written != size) {
+        ESP_LOGE(TAG, "Write to %s failed", file->path);
+        close_files_and_remount();
+        return false;
+    }
+
+    // the tail written by a sync is written again with its chunk, count only the new bytes
+    mem.stats.bytes_written += size - file->buffer_written;
+    file->buffer_written = size;
+    latency_hist_add(&mem.stats.write, time);
+    return true;
+}
+
+static bool file_append(sd_file_t *file, const uint8_t *data, size_t size) {
+    if (file_open(file) == false) {
+        return false;
+    }
+
+    size_t copied = 0;
+    while (copied < size) {
+        size_t chunk = file->buffer_size - (file->offset % file->buffer_size);
+        size_t part = size - copied;
+        if (part > chunk - file->buffer_used) {
+            part = chunk - file->buffer_used;
+        }
+        memcpy(file->buffer + file->buffer_used, data + copied, part);
+        file->buffer_used += part;
+        copied += part;
+
+        if (file->buffer_used < chunk) {
+            continue;
+        }
+
+        if (file_write_buffer(file, file->buffer_used) == false) {
+            // do not leave a part of the frame in the buffer
+            file->buffer_used -= part;
+            return false;
+        }
+        file->offset += file->buffer_used;
+        file->buffer_used = 0;
+        file->buffer_written = 0;
+    }
+
+    return true;
+}
+
+static bool file_sync(sd_file_t *file) {
+    if (file->file == NULL) {
+        return true;
+    }
+
+    if (file->buffer_used > 0) {
+        if (file_write_buffer(file, file->buffer_used) == false) {
+            return false;
+        }
+    }
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    int ret = fsync(fileno(file->file));
+    if (file->buffer_used > 0) {
+        fseek(file->file, file->offset, SEEK_SET);
+    }
+    if (ret == 0 && file->hwm_file != NULL) {
+        // fixed width, the sidecar is rewritten in place without allocating anything
+        rewind(file->hwm_file);
+        fprintf(file->hwm_file, "%010u\n", file->offset + file->buffer_used);
+        ret = fsync(fileno(file->hwm_file));
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Sync of %s failed", file->path);
+        close_files_and_remount();
+        return false;
+    }
+
+    return true;
+}
+
+static void file_close(sd_file_t *file) {
+    if (file->file == NULL) {
+        return;
+    }
+
+    file_sync(file);
+    if (file->file == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    fclose(file->file);
+    file->file = NULL;
+    if (file->preallocated == true) {
+        char hwm_path[SD_PATH_SIZE];
+        create_hwm_path(file->path, hwm_path, sizeof(hwm_path));
+        if (file->hwm_file != NULL) {
+            fclose(file->hwm_file);
+            file->hwm_file = NULL;
+        }
+        if (truncate(file->path, file->offset + file->buffer_used) == 0) {
+            remove(hwm_path);
+        } else {
+            ESP_LOGE(TAG, "Unable to truncate %s, it will be recovered on the next boot", file->path);
+        }
+        file->preallocated = false;
+    }
+    xSemaphoreGive(mem.spi_mutex);
+}
+
+/**
+ * @brief Truncate the garbage after the last valid frame of the segment
+ *
+ * @note Only the tail of the segment is scanned, the frames before it were synced long ago.
+ *
+ * @param[out] size segment size after the recovery
+ * @return true if the segment ends with a valid frame now
+ */
+static bool recover_segment(const char *path, uint32_t *size) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    uint8_t *buffer = malloc(SD_RECOVERY_BUFFER_SIZE);
+    if (buffer == NULL) {
+        fclose(file);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size_t file_size = ftell(file);
+    size_t start = file_size > SD_RECOVERY_SCAN_SIZE ? file_size - SD_RECOVERY_SCAN_SIZE : 0;
+    fseek(file, start, SEEK_SET);
+
+    tanwa_log_scanner_t scanner;
+    tanwa_log_scanner_init(&scanner, start, NULL, NULL);
+    size_t used = 0;
+    bool end = false;
+    while (end == false) {
+        used += fread(buffer + used, 1, SD_RECOVERY_BUFFER_SIZE - used, file);
+        end = used < SD_RECOVERY_BUFFER_SIZE;
+        size_t consumed = tanwa_log_scanner_feed(&scanner, buffer, used, end);
+        memmove(buffer, buffer + consumed, used - consumed);
+        used -= consumed;
+    }
+    free(buffer);
+    fclose(file);
+
+    if (scanner.frames == 0) {
+        ESP_LOGE(TAG, "No valid frame at the end of %s", path);
+        return false;
+    }
+
+    *size = scanner.valid_end;
+    if (scanner.valid_end < file_size) {
+        if (truncate(path, scanner.valid_end) != 0) {
+            ESP_LOGE(TAG, "Unable to truncate %s", path);
+            return false;
+        }
+        ESP_LOGW(TAG, "Truncated %u B of garbage from %s, last frame %u", file_size - scanner.valid_end, path,
+                 scanner.last_sequence);
+    }
+    return true;
+}
+
+/**
+ * @brief Recover the last segment of the session if it was not closed
+ *
+ * @note The index entry gets the recovered size and the closed flag, the record count and the
+ *       timestamps stay from the last sync.
+ */
+static void recover_session(const char *session_path) {
+    char path[SD_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/" TANWA_LOG_INDEX_NAME, session_path);
+    FILE *index_file = fopen(path, "r+");
+    if (index_file == NULL) {
+        return;
+    }
+
+    fseek(index_file, 0, SEEK_END);
+    long size = ftell(index_file);
+    long entries = (size - TANWA_LOG_INDEX_HEADER_SIZE) / TANWA_LOG_INDEX_ENTRY_SIZE;
+    uint8_t buffer[TANWA_LOG_INDEX_ENTRY_SIZE];
+    tanwa_log_index_entry_t entry;
+    long position = TANWA_LOG_INDEX_HEADER_SIZE + (entries - 1) * TANWA_LOG_INDEX_ENTRY_SIZE;
+    if (entries <= 0 || fseek(index_file, position, SEEK_SET) != 0 ||
+        fread(buffer, 1, sizeof(buffer), index_file) != sizeof(buffer) ||
+        tanwa_log_decode_index_entry(buffer, &entry) == false ||
+        (entry.flags & TANWA_LOG_INDEX_FLAG_CLOSED) != 0) {
+        fclose(index_file);
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%s/" TANWA_LOG_SEGMENT_NAME, session_path, (unsigned int)entry.segment);
+    if (recover_segment(path, &entry.size) == true) {
+        entry.flags |= TANWA_LOG_INDEX_FLAG_CLOSED;
+        tanwa_log_encode_index_entry(buffer, sizeof(buffer), &entry);
+        fseek(index_file, position, SEEK_SET);
+        fwrite(buffer, 1, sizeof(buffer), index_file);
+    }
+    fclose(index_file);
+}
+
+static void recover_files(const char *dir_path) {
+    DIR *dir = opendir(dir_path);
+    if (dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_DIR) {
+            continue;
+        }
+
+        char *extension = strrchr(entry->d_name, '.');
+        if (extension == NULL || strcasecmp(extension, SD_HWM_FILE_EXTENSION) != 0) {
+            continue;
+        }
+
+        char hwm_path[SD_PATH_SIZE];
+        char data_path[SD_PATH_SIZE];
+        int name_length = extension - entry->d_name;
+        snprintf(hwm_path, sizeof(hwm_path), "%s/%s", dir_path, entry->d_name);
+        snprintf(data_path, sizeof(data_path), "%s/%.*s" SD_DATA_FILE_EXTENSION,
+                 dir_path, name_length, entry->d_name);
+
+        unsigned int hwm = 0;
+        FILE *hwm_file = fopen(hwm_path, "r");
+        if (hwm_file == NULL) {
+            continue;
+        }
+        bool valid = fscanf(hwm_file, "%u", &hwm) == 1;
+        fclose(hwm_file);
+
+        if (valid == true && truncate(data_path, hwm) == 0) {
+            ESP_LOGW(TAG, "Recovered %s, %u B of data", data_path, hwm);
+        } else {
+            ESP_LOGE(TAG, "Unable to recover %s", data_path);
+        }
+        remove(hwm_path);
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Remember the session until it is closed, NULL clears it
+ *
+ * @note Only this session can need a recovery on the next boot, so the boot does not have to
+ *       walk all the session directories on the card.
+ */
+static void store_open_session(const char *session_path) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(SD_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        if (session_path != NULL) {
+            err = nvs_set_str(handle, SD_NVS_OPEN_SESSION_KEY, session_path);
+        } else {
+            err = nvs_erase_key(handle, SD_NVS_OPEN_SESSION_KEY);
+            err = err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Unable to store the open session: %s", esp_err_to_name(err));
+    }
+}
+
+static bool load_open_session(char *session_path, size_t size) {
+    nvs_handle_t handle;
+    if (nvs_open(SD_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = nvs_get_str(handle, SD_NVS_OPEN_SESSION_KEY, session_path, &size);
+    nvs_close(handle);
+    return err == ESP_OK;
+}
+
+/**
+ * @brief Replace the prefix with the full path of the lowest free number
+ *
+ * @note FATFS reads the whole directory to find out that a name is missing, so one directory read
+ *       costs the same as a single existence check and replaces probing the numbers one by one.
+ */
+static bool create_unique_path(char *path, size_t size, const char *extension) {
+    int64_t start = esp_timer_get_time();
+    char prefix[SD_PATH_SIZE];
+    snprintf(prefix, sizeof(prefix), "%s", path);
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    int number = SD_find_free_number(SD_MOUNT_POINT, prefix, extension, 0, SD_FREE_NUMBER_MAX);
+    xSemaphoreGive(mem.spi_mutex);
+    if (number < 0) {
+        return false;
+    }
+
+    char temp_path[SD_PATH_SIZE] = {0};
+    int ret = snprintf(temp_path, sizeof(temp_path), SD_MOUNT_POINT "/%s%d%s", prefix, number, extension);
+    if (ret >= SD_PATH_SIZE) {
+        return false;
+    }
+
+    memcpy(path, temp_path, size);
+    ESP_LOGI(TAG, "Created path %s in %lld us", path, esp_timer_get_time() - start);
+    return true;
+}
+
+/**
+ * @brief Append the payload wrapped in a frame
+ *
+ * @note The payload is not copied, a frame torn by a failed write is skipped by the scanner.
+ */
+static bool write_frame(uint8_t type, const uint8_t *payload, size_t size) {
+    if (size > TANWA_LOG_FRAME_MAX_PAYLOAD) {
+        return false;
+    }
+
+    uint8_t header[TANWA_LOG_FRAME_HEADER_SIZE];
+    uint8_t trailer[TANWA_LOG_CRC_SIZE];
+    tanwa_log_frame_begin(header, type, mem.frame_sequence++, (uint16_t)size);
+    tanwa_log_frame_end(header, payload, (uint16_t)size, trailer);
+    return file_append(&mem.data_file, header, sizeof(header)) == true &&
+           file_append(&mem.data_file, payload, size) == true &&
+           file_append(&mem.data_file, trailer, sizeof(trailer)) == true;
+}
+
+static void write_codec_block(const uint8_t *block, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    mem.stats.compress_bytes_out += size + TANWA_LOG_FRAME_OVERHEAD;
+    write_frame(TANWA_LOG_FRAME_BLOCK, block, size);
+}
+
+///===-----------------------------------------------------------------------------------------===//
+/// Two-tier logging, full-rate records in the circular file and summaries in the segments
+///===-----------------------------------------------------------------------------------------===//
+
+static long ring_block_offset(uint32_t sequence) {
+    return (long)(1 + sequence % mem.ring.block_count) * TANWA_LOG_RING_BLOCK_SIZE;
+}
+
+static void ring_start_session(void) {
+    sd_ring_t *ring = &mem.ring;
+    snprintf(ring->path, sizeof(ring->path), "%s/" TANWA_LOG_RING_NAME, mem.session_path);
+    ring->created = false;
+    ring->block_sequence = 0;
+    ring->frame_sequence = 0;
+    ring->used = TANWA_LOG_RING_BLOCK_HEADER_SIZE;
+    ring->freeze_count = 0;
+    if (ring->buffer != NULL) {
+        memset(ring->buffer, 0, TANWA_LOG_RING_BLOCK_SIZE);
+    }
+}
+
+/**
+ * @brief Open the circular file, a new one gets the schema header and the ring descriptor
+ */
+static bool ring_open(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring->file != NULL) {
+        return true;
+    }
+
+    size_t header_size = 0;
+    uint8_t *block = ring->copy_buffer;
+    if (ring->created == false) {
+        // no freeze before the file exists, the copy buffer is free
+        memset(block, 0, TANWA_LOG_RING_BLOCK_SIZE);
+        header_size = mem.create_sd_header_fnc((char*)block, TANWA_LOG_RING_BLOCK_SIZE - TANWA_LOG_RING_BLOCK_HEADER_SIZE);
+        ring->ring_id = esp_random();
+        tanwa_log_ring_block_t descriptor = {
+            .used = 0,
+            .ring_id = ring->ring_id,
+            .sequence = ring->block_count,
+        };
+        tanwa_log_encode_ring_block(block + TANWA_LOG_RING_BLOCK_SIZE - TANWA_LOG_RING_BLOCK_HEADER_SIZE, &descriptor);
+    }
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    ring->file = fopen(ring->path, ring->created == true ? "r+" : "w+");
+    bool ret = ring->file != NULL;
+    if (ret == true) {
+        setvbuf(ring->file, NULL, _IONBF, 0);
+        if (ring->created == false) {
+            ret = header_size > 0 && fwrite(block, 1, TANWA_LOG_RING_BLOCK_SIZE, ring->file) == TANWA_LOG_RING_BLOCK_SIZE;
+        }
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret == false) {
+        ESP_LOGE(TAG, "Can not open the recent data file %s", ring->path);
+        close_files_and_remount();
+        return false;
+    }
+
+    ring->created = true;
+    return true;
+}
+
+static bool frozen_open(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring->frozen_file != NULL) {
+        return true;
+    }
+
+    // reopened after remount, the copied blocks are only appended
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    ring->frozen_file = fopen(ring->frozen_path, "a");
+    if (ring->frozen_file != NULL) {
+        setvbuf(ring->frozen_file, NULL, _IONBF, 0);
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ring->frozen_file == NULL) {
+        ESP_LOGE(TAG, "Can not open the frozen data file %s", ring->frozen_path);
+        return false;
+    }
+    return true;
+}
+
+static void freeze_finish(void) {
+    sd_ring_t *ring = &mem.ring;
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    if (ring->frozen_file != NULL) {
+        fsync(fileno(ring->frozen_file));
+        fclose(ring->frozen_file);
+        ring->frozen_file = NULL;
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    ring->freezing = false;
+    ESP_LOGI(TAG, "Recent data frozen to %s in %lld ms", ring->frozen_path,
+             (esp_timer_get_time() - ring->freeze_start_us) / 1000);
+}
+
+/**
+ * @brief Copy the frames of the oldest block not yet copied to the frozen file
+ */
+static bool freeze_copy_block(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring_open() == false || frozen_open() == false) {
+        return false;
+    }
+
+    tanwa_log_ring_block_t block;
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    bool ret = fseek(ring->file, ring_block_offset(ring->copy_next), SEEK_SET) == 0 &&
+               fread(ring->copy_buffer, 1, TANWA_LOG_RING_BLOCK_SIZE, ring->file) == TANWA_LOG_RING_BLOCK_SIZE;
+    if (ret == true && tanwa_log_decode_ring_block(ring->copy_buffer, &block) == true &&
+        block.ring_id == ring->ring_id && block.sequence == ring->copy_next &&
+        block.used > TANWA_LOG_RING_BLOCK_HEADER_SIZE) {
+        size_t size = block.used - TANWA_LOG_RING_BLOCK_HEADER_SIZE;
+        ret = fwrite(ring->copy_buffer + TANWA_LOG_RING_BLOCK_HEADER_SIZE, 1, size, ring->frozen_file) == size;
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret == false) {
+        ESP_LOGE(TAG, "Copy of the recent block %u failed", ring->copy_next);
+        close_files_and_remount();
+        return false;
+    }
+
+    ring->copy_next++;
+    mem.stats.frozen_blocks++;
+    return true;
+}
+
+/**
+ * @brief Copy the blocks up to the sequence, the freeze is finished after the last one
+ */
+static bool freeze_copy_until(uint32_t sequence) {
+    sd_ring_t *ring = &mem.ring;
+    if (sequence > ring->copy_end) {
+        sequence = ring->copy_end;
+    }
+    while (ring->freezing == true && ring->copy_next < sequence) {
+        if (freeze_copy_block() == false) {
+            return false;
+        }
+    }
+
+    if (ring->freezing == true && ring->copy_next >= ring->copy_end) {
+        freeze_finish();
+    }
+    return true;
+}
+
+/**
+ * @brief Write the block buffer to its slot
+ */
+static bool ring_write_block(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring->freezing == true && ring->block_sequence >= ring->block_count &&
+        freeze_copy_until(ring->block_sequence - ring->block_count + 1) == false) {
+        return false;
+    }
+    if (ring_open() == false) {
+        return false;
+    }
+
+    tanwa_log_ring_block_t block = {
+        .used = (uint16_t)ring->used,
+        .ring_id = ring->ring_id,
+        .sequence = ring->block_sequence,
+    };
+    tanwa_log_encode_ring_block(ring->buffer, &block);
+
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    bool ret = fseek(ring->file, ring_block_offset(ring->block_sequence), SEEK_SET) == 0 &&
+               fwrite(ring->buffer, 1, TANWA_LOG_RING_BLOCK_SIZE, ring->file) == TANWA_LOG_RING_BLOCK_SIZE;
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret == false) {
+        ESP_LOGE(TAG, "Write to %s failed", ring->path);
+        close_files_and_remount();
+        return false;
+    }
+
+    mem.stats.bytes_written += TANWA_LOG_RING_BLOCK_SIZE;
+    latency_hist_add(&mem.stats.write, esp_timer_get_time() - start);
+    return true;
+}
+
+static bool ring_next_block(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring_write_block() == false) {
+        return false;
+    }
+
+    ring->block_sequence++;
+    ring->used = TANWA_LOG_RING_BLOCK_HEADER_SIZE;
+    memset(ring->buffer, 0, TANWA_LOG_RING_BLOCK_SIZE);
+    mem.stats.recent_blocks++;
+    return true;
+}
+
+static bool ring_append(const uint8_t *payload, size_t size) {
+    sd_ring_t *ring = &mem.ring;
+    size_t frame_size = size + TANWA_LOG_FRAME_OVERHEAD;
+    if (frame_size > TANWA_LOG_RING_BLOCK_SIZE - TANWA_LOG_RING_BLOCK_HEADER_SIZE) {
+        return false;
+    }
+    if (ring->used + frame_size > TANWA_LOG_RING_BLOCK_SIZE && ring_next_block() == false) {
+        return false;
+    }
+
+    uint8_t *frame = ring->buffer + ring->used;
+    tanwa_log_frame_begin(frame, TANWA_LOG_FRAME_RECORD, ring->frame_sequence++, (uint16_t)size);
+    memcpy(frame + TANWA_LOG_FRAME_HEADER_SIZE, payload, size);
+    tanwa_log_frame_end(frame, payload, (uint16_t)size, frame + TANWA_LOG_FRAME_HEADER_SIZE + size);
+    ring->used += frame_size;
+    return true;
+}
+
+static void ring_sync(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring->file == NULL || ring->used == TANWA_LOG_RING_BLOCK_HEADER_SIZE || ring_write_block() == false) {
+        return;
+    }
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    int ret = fsync(fileno(ring->file));
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Sync of %s failed", ring->path);
+        close_files_and_remount();
+    }
+}
+
+/**
+ * @brief Finish the freeze and close the circular file of the session
+ */
+static void ring_close(void) {
+    sd_ring_t *ring = &mem.ring;
+    if (ring->block_count == 0) {
+        return;
+    }
+
+    if (ring->freezing == true && freeze_copy_until(ring->copy_end) == false) {
+        ESP_LOGE(TAG, "Freeze of %s not finished", ring->path);
+        ring->freezing = false;
+    }
+    ring_sync();
+
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    if (ring->file != NULL) {
+        fclose(ring->file);
+        ring->file = NULL;
+    }
+    if (ring->frozen_file != NULL) {
+        fclose(ring->frozen_file);
+        ring->frozen_file = NULL;
+    }
+    xSemaphoreGive(mem.spi_mutex);
+}
+
+static void freeze_start(void) {
+    sd_ring_t *ring = &mem.ring;
+    mem.freeze_requested = false;
+    if (ring->freezing == true) {
+        ESP_LOGW(TAG, "Recent data is already being frozen to %s", ring->frozen_path);
+        return;
+    }
+    if (ring->used > TANWA_LOG_RING_BLOCK_HEADER_SIZE && ring_next_block() == false) {
+        return;
+    }
+    if (ring->block_sequence == 0) {
+        ESP_LOGW(TAG, "No recent data to freeze");
+        return;
+    }
+
+    snprintf(ring->frozen_path, sizeof(ring->frozen_path), "%s/" TANWA_LOG_FROZEN_NAME, mem.session_path,
+             (unsigned int)ring->freeze_count);
+    size_t header_size = mem.create_sd_header_fnc((char*)ring->copy_buffer, TANWA_LOG_RING_BLOCK_SIZE);
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    ring->frozen_file = fopen(ring->frozen_path, "w");
+    bool ret = ring->frozen_file != NULL;
+    if (ret == true) {
+        setvbuf(ring->frozen_file, NULL, _IONBF, 0);
+        ret = fwrite(ring->copy_buffer, 1, header_size, ring->frozen_file) == header_size;
+    }
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret == false) {
+        ESP_LOGE(TAG, "Can not create the frozen data file %s", ring->frozen_path);
+        close_files_and_remount();
+        return;
+    }
+
+    ring->freeze_count++;
+    ring->copy_end = ring->block_sequence;
+    ring->copy_next = ring->copy_end > ring->block_count ? ring->copy_end - ring->block_count : 0;
+    ring->freezing = true;
+    ring->freeze_start_us = esp_timer_get_time();
+    ESP_LOGI(TAG, "Freezing %u recent blocks to %s", ring->copy_end - ring->copy_next, ring->frozen_path);
+}
+
+static void freeze_check_and_copy(void) {
+    if (mem.ring.block_count == 0 || mem.sd_card.mounted == false) {
+        return;
+    }
+
+    if (mem.freeze_requested == true) {
+        freeze_start();
+    }
+    if (mem.ring.freezing == true) {
+        freeze_copy_until(mem.ring.copy_next + SD_FREEZE_BLOCKS_PER_CYCLE);
+    }
+}
+
+static void free_recent(void) {
+    heap_caps_free(mem.ring.buffer);
+    mem.ring.buffer = NULL;
+    heap_caps_free(mem.ring.copy_buffer);
+    mem.ring.copy_buffer = NULL;
+    free(mem.summary);
+    mem.summary = NULL;
+    mem.ring.block_count = 0;
+}
+
+/**
+ * @brief Allocate the two-tier logging, without it the full-rate records go to the segments
+ */
+static void allocate_recent(sd_task_cfg_t *task_cfg) {
+    mem.ring.block_count = 0;
+    if (task_cfg->recent_size == 0) {
+        return;
+    }
+    if (task_cfg->create_sd_header_fnc == NULL || task_cfg->recent_size < 3 * TANWA_LOG_RING_BLOCK_SIZE) {
+        ESP_LOGW(TAG, "Two-tier logging needs the data header and at least 3 blocks");
+        return;
+    }
+
+    mem.ring.buffer = heap_caps_aligned_alloc(4, TANWA_LOG_RING_BLOCK_SIZE, MALLOC_CAP_DMA);
+    mem.ring.copy_buffer = heap_caps_aligned_alloc(4, TANWA_LOG_RING_BLOCK_SIZE, MALLOC_CAP_DMA);
+    mem.summary = malloc(sizeof(record_summary_t));
+    size_t header_size = task_cfg->create_sd_header_fnc(mem.data_buffer, sizeof(mem.data_buffer));
+    if (mem.ring.buffer == NULL || mem.ring.copy_buffer == NULL || mem.summary == NULL ||
+        record_summary_init(mem.summary, (uint8_t*)mem.data_buffer, header_size) == false) {
+        ESP_LOGW(TAG, "Unable to allocate the two-tier logging, full-rate data goes to the segments");
+        free_recent();
+        return;
+    }
+
+    memset(mem.ring.buffer, 0, TANWA_LOG_RING_BLOCK_SIZE);
+    mem.summary_interval_ms = task_cfg->summary_interval_ms;
+    // the first block keeps the header
+    mem.ring.block_count = task_cfg->recent_size / TANWA_LOG_RING_BLOCK_SIZE - 1;
+    ESP_LOGI(TAG, "Recent data in %u blocks of %d B, summary every %u ms", mem.ring.block_count,
+             TANWA_LOG_RING_BLOCK_SIZE, mem.summary_interval_ms);
+}
+
+static void write_summary(void) {
+    const uint8_t *payload = NULL;
+    size_t size = record_summary_flush(mem.summary, &payload);
+    if (size > 0 && write_frame(TANWA_LOG_FRAME_SUMMARY, payload, size) == true) {
+        // the summaries are the records of the segment, the readers skip segments without any
+        mem.segment.record_count++;
+        mem.stats.summaries++;
+    }
+}
+
+/**
+ * @brief Write the record to the circular file and add it to the summary of the segment
+ */
+static bool recent_append(const uint8_t *frame, size_t size) {
+    if (ring_append(frame, size) == false) {
+        return false;
+    }
+
+    if (record_summary_is_due(mem.summary, frame, mem.summary_interval_ms) == true) {
+        write_summary();
+    }
+    record_summary_add(mem.summary, frame);
+    return true;
+}
+
+/**
+ * @brief Write the frame, through the codec if the data is compressed
+ *
+ * @return true if the frame was written or taken by the codec
+ */
+static bool data_append(const uint8_t *frame, size_t size) {
+    if (mem.ring.block_count > 0) {
+        return recent_append(frame, size);
+    }
+
+    if (mem.codec == NULL) {
+        return write_frame(TANWA_LOG_FRAME_RECORD, frame, size);
+    }
 
-#include "sd_task.h"
+    const uint8_t *block = NULL;
+    int64_t start = esp_timer_get_time();
+    size_t block_size = record_codec_push(mem.codec, frame, size, &block);
+    mem.stats.compress_us += esp_timer_get_time() - start;
+    mem.stats.compress_records++;
+    mem.stats.compress_bytes_in += size;
 
-#include "esp_timer.h"
+    // the frame is already in the next block, even if the closed one is lost
+    write_codec_block(block, block_size);
+    return true;
+}
 
-#include "esp_log.h"
+static void flush_codec(void) {
+    if (mem.codec == NULL) {
+        return;
+    }
 
-#define TAG "SD_TASK"
+    const uint8_t *block = NULL;
+    int64_t start = esp_timer_get_time();
+    size_t block_size = record_codec_flush(mem.codec, &block);
+    mem.stats.compress_us += esp_timer_get_time() - start;
+    write_codec_block(block, block_size);
+}
 
-#define SD_TASK_STACK_SIZE 8192
-#define SD_TASK_PRIORITY 5
-#define SD_TASK_CORE_ID 0
+/**
+ * @brief Write the sample accounting since the last backpressure frame
+ */
+static void write_backpressure_frame(uint8_t decimation) {
+    backpressure_counters_t counters;
+    backpressure_get_counters(&mem.backpressure, &counters);
+    int64_t now = esp_timer_get_time();
+    tanwa_log_backpressure_t frame = {
+        .timestamp_ms = (uint32_t)(now / 1000),
+        .interval_ms = (uint32_t)((now - mem.accounted_us) / 1000),
+        .policy = (uint8_t)backpressure_get_policy(&mem.backpressure),
+        .decimation = decimation,
+        .produced = counters.produced - mem.accounted.produced,
+        .decimated = counters.decimated - mem.accounted.decimated,
+        .dropped = counters.dropped - mem.accounted.dropped,
+        .written = counters.written - mem.accounted.written,
+    };
 
-extern SemaphoreHandle_t mutex_spi;
+    uint8_t payload[TANWA_LOG_BACKPRESSURE_SIZE];
+    size_t size = tanwa_log_encode_backpressure(payload, sizeof(payload), &frame);
+    if (write_frame(TANWA_LOG_FRAME_BACKPRESSURE, payload, size) == false) {
+        // counted in the next frame
+        return;
+    }
+    mem.accounted = counters;
+    mem.accounted_us = now;
+    mem.written_decimation = decimation;
+}
 
-static struct {
-    sd_card_t sd_card;
+static bool index_open(void) {
+    if (mem.index_file != NULL) {
+        return true;
+    }
 
-    TaskHandle_t sd_task;
-    QueueHandle_t data_queue;
-    QueueHandle_t log_queue;
-    SemaphoreHandle_t data_write_mutex;  // prevent race condition during path changing
-    SemaphoreHandle_t spi_mutex;
+    char index_path[SD_PATH_SIZE];
+    snprintf(index_path, sizeof(index_path), "%s/" TANWA_LOG_INDEX_NAME, mem.session_path);
 
-    void *data_from_queue;
-    size_t data_from_queue_size;
-    char data_buffer[SD_DATA_BUFFER_MAX_SIZE];
-    char log_buffer[SD_LOG_BUFFER_MAX_SIZE];
+    bool ret = true;
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    bool exists = SD_file_exists(index_path);
+    mem.index_file = fopen(index_path, exists == true ? "r+" : "w");
+    if (mem.index_file != NULL) {
+        setvbuf(mem.index_file, NULL, _IONBF, 0);
+        if (exists == false) {
+            uint8_t header[TANWA_LOG_INDEX_HEADER_SIZE];
+            tanwa_log_write_index_header(header, sizeof(header));
+            ret = fwrite(header, 1, sizeof(header), mem.index_file) == sizeof(header);
+        }
+    } else {
+        ret = false;
+    }
+    xSemaphoreGive(mem.spi_mutex);
 
-    char data_path[SD_PATH_SIZE];
-    char log_path[SD_PATH_SIZE];
+    if (ret == false) {
+        ESP_LOGE(TAG, "Can not open the index file %s", index_path);
+        if (mem.index_file != NULL) {
+            fclose(mem.index_file);
+            mem.index_file = NULL;
+        }
+    }
+    return ret;
+}
 
-    uint32_t try_to_mount_counter;
+/**
+ * @brief Rewrite the index entry of the current segment in place
+ *
+ * @note Written after the segment data is synced, so the entry never points past the data.
+ */
+static void index_update(void) {
+    if (mem.segment.record_count == 0 || index_open() == false) {
+        return;
+    }
 
-    error_handler error_handler_fnc;
-    create_sd_frame create_sd_frame_fnc;
-} mem = {
-    .sd_task = NULL,
-    .log_queue = NULL,
-    .data_write_mutex = NULL,
-};
+    uint8_t entry[TANWA_LOG_INDEX_ENTRY_SIZE];
+    mem.segment.size = mem.data_file.offset + mem.data_file.buffer_used;
+    tanwa_log_encode_index_entry(entry, sizeof(entry), &mem.segment);
 
-static void report_error(SD_TASK_ERR error_code) {
-    if (mem.error_handler_fnc == NULL) {
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    long position = TANWA_LOG_INDEX_HEADER_SIZE + (long)mem.segment.segment * TANWA_LOG_INDEX_ENTRY_SIZE;
+    bool ret = fseek(mem.index_file, position, SEEK_SET) == 0 &&
+               fwrite(entry, 1, sizeof(entry), mem.index_file) == sizeof(entry) &&
+               fsync(fileno(mem.index_file)) == 0;
+    xSemaphoreGive(mem.spi_mutex);
+
+    if (ret == false) {
+        ESP_LOGE(TAG, "Index update of %s failed", mem.session_path);
+        close_files_and_remount();
+    }
+}
+
+static void index_close(void) {
+    if (mem.index_file == NULL) {
         return;
     }
 
-    mem.error_handler_fnc(error_code);
+    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+    fclose(mem.index_file);
+    mem.index_file = NULL;
+    xSemaphoreGive(mem.spi_mutex);
 }
 
+static void start_segment(uint32_t number) {
+    snprintf(mem.data_path, sizeof(mem.data_path), "%s/" TANWA_LOG_SEGMENT_NAME, mem.session_path,
+             (unsigned int)number);
+    memset(&mem.segment, 0, sizeof(mem.segment));
+    mem.segment.segment = number;
+    mem.segment_samples = 0;
+    mem.segment_start_us = esp_timer_get_time();
+    mem.data_file.offset_valid = false;
+    mem.data_file.buffer_used = 0;
+    mem.data_file.buffer_written = 0;
+    mem.data_file_new = true;
+    // every segment starts with the decimation of its records
+    mem.written_decimation = UINT8_MAX;
+}
 
-static bool write_to_sd(FILE *file, char *data, size_t size) {
-    if (file == NULL) {
+/**
+ * @brief Close the current segment and mark it closed in the index
+ */
+static void finish_segment(void) {
+    flush_codec();
+    if (mem.summary != NULL && mem.data_file_new == false) {
+        write_summary();
+    }
+    if (mem.data_file_new == false && mem.written_decimation != UINT8_MAX) {
+        // the sums of the segment frames are exact up to its last record
+        write_backpressure_frame(mem.written_decimation);
+    }
+    file_close(&mem.data_file);
+    mem.segment.flags |= TANWA_LOG_INDEX_FLAG_CLOSED;
+    index_update();
+}
+
+static void check_rotate_condition(void) {
+    if (mem.segment.record_count == 0) {
+        return;
+    }
+
+    size_t size = mem.data_file.offset + mem.data_file.buffer_used;
+    int64_t duration_ms = (esp_timer_get_time() - mem.segment_start_us) / 1000;
+    if (size < mem.segment_size &&
+        (mem.segment_duration_ms == 0 || duration_ms < (int64_t)mem.segment_duration_ms)) {
+        return;
+    }
+
+    finish_segment();
+    start_segment(mem.segment.segment + 1);
+    mem.stats.segment_count++;
+    ESP_LOGI(TAG, "Rotated data to %s", mem.data_path);
+}
+
+static bool start_session(const char *prefix, size_t prefix_size) {
+    if (prefix_size > sizeof(mem.session_path)) {
+        prefix_size = sizeof(mem.session_path);
+    }
+    memcpy(mem.session_path, prefix, prefix_size);
+    mem.session_path[sizeof(mem.session_path) - 1] = '\0';
+    if (strlen(mem.session_path) > SD_SESSION_PREFIX_MAX_SIZE) {
+        mem.session_path[SD_SESSION_PREFIX_MAX_SIZE] = '\0';
+    }
+
+    if (create_unique_path(mem.session_path, sizeof(mem.session_path), "") == false) {
+        ESP_LOGE(TAG, "Unable to create unique path");
         return false;
     }
 
     xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
-    fwrite(data, 1, size, file);
+    int ret = mkdir(mem.session_path, 0775);
     xSemaphoreGive(mem.spi_mutex);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Unable to create session directory %s", mem.session_path);
+        return false;
+    }
 
+    store_open_session(mem.session_path);
+    mem.frame_sequence = 0;
+    start_segment(0);
+    ring_start_session();
     return true;
 }
 
-static void get_data_from_queue_and_save(FILE * data_file) {
-    size_t frame_size;
-    if (xQueueReceive(mem.data_queue, mem.data_from_queue, 0) == pdFALSE) {
-            report_error(SD_QUEUE_READ);
-    } else {
-        frame_size = mem.create_sd_frame_fnc(mem.data_buffer, sizeof(mem.data_buffer),
-                                             mem.data_from_queue, mem.data_from_queue_size);
-        if (write_to_sd(data_file, mem.data_buffer, frame_size) == false) {
-            xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
-            SD_remount(&mem.sd_card);
-            xSemaphoreGive(mem.spi_mutex);
-            report_error(SD_WRITE);
+static void sync_files(void) {
+    if (mem.sd_card.mounted == false) {
+        return;
+    }
+
+    // a block is decodable only when closed, every synced record has to be in one
+    int64_t start = esp_timer_get_time();
+    flush_codec();
+    if (file_sync(&mem.data_file) == true && mem.data_file.file != NULL) {
+        index_update();
+    }
+    ring_sync();
+    file_sync(&mem.log_file);
+    mem.last_sync_us = esp_timer_get_time();
+    latency_hist_add(&mem.stats.sync, mem.last_sync_us - start);
+    mem.sync_requested = false;
+}
+
+static void check_sync_condition(void) {
+    if (mem.sync_requested == false &&
+        esp_timer_get_time() - mem.last_sync_us < (int64_t)mem.sync_interval_ms * 1000) {
+        return;
+    }
+
+    sync_files();
+}
+
+static void write_data_header(void) {
+    if (mem.data_file_new == false || mem.create_sd_header_fnc == NULL) {
+        return;
+    }
+
+    size_t header_size = mem.create_sd_header_fnc(mem.data_buffer, sizeof(mem.data_buffer));
+    if (header_size == 0 || file_append(&mem.data_file, (uint8_t*)mem.data_buffer, header_size) == false) {
+        ESP_LOGE(TAG, "Can not write the header of %s", mem.data_path);
+        report_error(SD_WRITE);
+        return;
+    }
+    mem.data_file_new = false;
+}
+
+/**
+ * @param in_segment the record frame was written to the segment, not to the recent file
+ */
+static void update_segment_entry(void *data, bool in_segment) {
+    uint32_t timestamp_ms = 0;
+    uint8_t state = 0;
+    if (mem.get_data_info_fnc != NULL) {
+        mem.get_data_info_fnc(data, &timestamp_ms, &state);
+    }
+
+    if (mem.segment_samples == 0) {
+        mem.segment.first_timestamp_ms = timestamp_ms;
+        mem.segment.first_state = state;
+    }
+    mem.segment.last_timestamp_ms = timestamp_ms;
+    mem.segment.last_state = state;
+    mem.segment_samples++;
+    if (in_segment == true) {
+        mem.segment.record_count++;
+    }
+}
+
+static void record_queue_wait(void *data) {
+    uint32_t timestamp_ms;
+    uint8_t state;
+    if (mem.get_data_info_fnc == NULL || mem.get_data_info_fnc(data, &timestamp_ms, &state) == false) {
+        return;
+    }
+
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    latency_hist_add(&mem.stats.queue_wait, (int64_t)(now_ms - timestamp_ms) * 1000);
+}
+
+static void check_accounting_condition(void) {
+    // a new segment gets its first frame with the first record
+    if (mem.written_decimation == UINT8_MAX ||
+        esp_timer_get_time() - mem.accounted_us < SD_ACCOUNTING_INTERVAL_MS * 1000) {
+        return;
+    }
+
+    write_backpressure_frame(mem.written_decimation);
+}
+
+static bool save_data(void *data) {
+    uint8_t decimation = ((uint8_t*)data)[mem.data_from_queue_size];
+    if (decimation != mem.written_decimation) {
+        // the records taken with the new factor have to follow the frame
+        flush_codec();
+        write_backpressure_frame(decimation);
+    }
+
+    record_queue_wait(data);
+    int64_t start = esp_timer_get_time();
+    size_t frame_size = mem.create_sd_frame_fnc(mem.data_buffer, sizeof(mem.data_buffer),
+                                                data, mem.data_from_queue_size);
+    latency_hist_add(&mem.stats.serialize, esp_timer_get_time() - start);
+    bool in_segment = mem.ring.block_count == 0;
+    if (data_append((uint8_t*)mem.data_buffer, frame_size) == false) {
+        return false;
+    }
+
+    update_segment_entry(data, in_segment);
+    backpressure_count_written(&mem.backpressure);
+    return true;
+}
+
+static void spill_data(void *data) {
+    if (spill_buffer_push(&mem.spill, data) == false) {
+        backpressure_count_dropped(&mem.backpressure);
+    }
+}
+
+/**
+ * @brief Move the queued data to the spill buffer, used while the card can not be written
+ */
+static void spill_data_from_queue(void) {
+    while (xQueueReceive(mem.data_queue, mem.data_from_queue, 0) == pdTRUE) {
+        spill_data(mem.data_from_queue);
+    }
+}
+
+/**
+ * @brief Write the spilled data, oldest first
+ *
+ * @return true if the spill buffer is empty
+ */
+static bool drain_spill(void) {
+    uint8_t *data;
+    int drained = 0;
+    while (drained < SD_SPILL_DRAIN_MAX && (data = spill_buffer_peek(&mem.spill)) != NULL) {
+        if (save_data(data) == false) {
+            // kept for the next try after the remount
+            return false;
         }
+        spill_buffer_pop(&mem.spill);
+        drained++;
+    }
+    return spill_buffer_count(&mem.spill) == 0;
+}
+
+static void get_data_from_queue_and_save(void) {
+    if (xQueueReceive(mem.data_queue, mem.data_from_queue, 0) == pdFALSE) {
+        report_error(SD_QUEUE_READ);
+        return;
+    }
+
+    if (save_data(mem.data_from_queue) == false) {
+        spill_data(mem.data_from_queue);
     }
 }
 
 static void prepare_data_file_and_save(void) {
-    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
-    FILE *data_file = fopen(mem.data_path, "a");
-     if (data_file == NULL) {
-        ESP_LOGE(TAG, "Can not open the file %s", mem.data_path);
-        // return;
+    check_rotate_condition();
+    if (file_open(&mem.data_file) == false) {
+        report_error(SD_WRITE);
+        return;
+    }
+
+    write_data_header();
+    check_accounting_condition();
+
+    if (drain_spill() == false) {
+        // the queue goes behind the spilled data to keep the order
+        spill_data_from_queue();
+        return;
     }
-    xSemaphoreGive(mem.spi_mutex);
 
     int received_data_counter = 0;
-    // ESP_LOGI(TAG, "Saving to sd");
     while (uxQueueMessagesWaiting(mem.data_queue) > 0) {
-        get_data_from_queue_and_save(data_file);
+        get_data_from_queue_and_save();
+        if (spill_buffer_count(&mem.spill) > 0) {
+            // the write failed, the rest waits for the remount
+            spill_data_from_queue();
+            break;
+        }
 
         received_data_counter++;
         if (received_data_counter > SD_MAX_DATA_RECEIVE) {
             ESP_LOGI(TAG, "TIMEOUT");
             break;
         }
-        vTaskDelay(pdMS_TO_TICKS(1));
     }
-
-    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
-    fclose(data_file);
-    xSemaphoreGive(mem.spi_mutex);
 }
 
 static bool check_sd_status(void) {
@@ -125,17 +1456,20 @@ static bool check_sd_status(void) {
     xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
     bool result = SD_mount(&mem.sd_card);
     xSemaphoreGive(mem.spi_mutex);
-    xQueueReset(mem.data_queue);
+    if (result == true) {
+        ESP_LOGI(TAG, "SD card mounted again, %u records spilled", spill_buffer_count(&mem.spill));
+    }
 
     return result;
 }
 
 static void data_check_and_save(void) {
     if (check_sd_status() == false) {
+        spill_data_from_queue();
         return;
     }
 
-    if (uxQueueMessagesWaiting(mem.data_queue) < SD_DATA_DROP_VALUE) {
+    if (uxQueueMessagesWaiting(mem.data_queue) < SD_DATA_DROP_VALUE && spill_buffer_count(&mem.spill) == 0) {
         return;
     }
 
@@ -148,29 +1482,34 @@ static void log_check_and_save(void) {
     }
 
     int received_data_counter = 0;
-    while (uxQueueMessagesWaiting(mem.log_queue) > 0) {
-        xQueueReceive(mem.log_queue, &mem.log_buffer, 0);
-        xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
-        if (SD_write(&mem.sd_card, mem.log_path, mem.log_buffer, sizeof(mem.log_buffer)) == false) {
+    const uint8_t *log;
+    size_t length;
+    while ((length = log_ring_peek(&mem.log_ring, &log)) > 0) {
+        bool ret = file_append(&mem.log_file, log, length);
+        log_ring_release(&mem.log_ring);
+        if (ret == false) {
             report_error(SD_WRITE);
         }
-        xSemaphoreGive(mem.spi_mutex);
 
         received_data_counter++;
         if (received_data_counter > SD_MAX_DATA_RECEIVE) {
             return;
         }
-        vTaskDelay(pdMS_TO_TICKS(1));
     }
 }
 
 static void terminate_task(void) {
     ESP_LOGI(TAG, "Terminating SD TASK");
     vQueueDelete(mem.data_queue);
-    vQueueDelete(mem.log_queue);
     mem.data_queue = NULL;
-    mem.log_queue = NULL;
     free(mem.data_from_queue);
+    free(mem.codec);
+    mem.codec = NULL;
+    heap_caps_free(mem.spill.buffer);
+    spill_buffer_init(&mem.spill, NULL, 0, 0);
+    free_recent();
+    file_free(&mem.data_file);
+    file_free(&mem.log_file);
     vTaskDelete(NULL);
 }
 
@@ -179,53 +1518,40 @@ static void check_terminate_condition(void) {
         return;
     }
 
+    xSemaphoreTake(mem.data_write_mutex, portMAX_DELAY);
     prepare_data_file_and_save();
+    finish_segment();
+    index_close();
+    ring_close();
+    store_open_session(NULL);
+    xSemaphoreGive(mem.data_write_mutex);
     log_check_and_save();
+    file_close(&mem.log_file);
     terminate_task();
 }
 
 static void sdTask(void *args) {
     ESP_LOGI(TAG, "RUNNING SD TASK");
     while (1) {
-        if (xSemaphoreTake(mem.data_write_mutex, 10) == pdTRUE) {
+        if (mem.benchmark_running == true) {
+            // the card is used by the benchmark, only the sd task touches the spill buffer
+            spill_data_from_queue();
+        } else if (xSemaphoreTake(mem.data_write_mutex, 10) == pdTRUE) {
             data_check_and_save();
+            freeze_check_and_copy();
+            log_check_and_save();
+            check_sync_condition();
             xSemaphoreGive(mem.data_write_mutex);
         } else {
             report_error(SD_MUTEX);
         }
 
-        log_check_and_save();
         check_terminate_condition();
 
         vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
-static bool check_if_file_exists(char *path) {
-    bool res;
-    xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
-    res = SD_file_exists(path);
-    xSemaphoreGive(mem.spi_mutex);
-    return res;
-}
-
-static bool create_unique_path(char *path, size_t size) {
-    char temp_path[SD_PATH_SIZE] = {0};
-    int ret = 0;
-    for (int i = 0; i < 1000; ++i) {
-        ret = snprintf(temp_path, sizeof(temp_path), SD_MOUNT_POINT "/%s%d.txt", path, i);
-        if (ret == SD_PATH_SIZE) {
-            return false;
-        }
-
-        if (check_if_file_exists(temp_path) == false) {
-            memcpy(path, temp_path, size);
-            return true;
-        }
-    }
-    return false;
-}
-
 static bool initialize_sd_card(sd_task_cfg_t *task_cfg) {
     sd_card_config_t card_cfg = {
         .spi_host = task_cfg->spi_host,
@@ -242,17 +1568,35 @@ static bool initialize_sd_card(sd_task_cfg_t *task_cfg) {
 
     mem.error_handler_fnc = task_cfg->error_handler_fnc;
 
-    memcpy(mem.data_path, task_cfg->data_path, task_cfg->data_path_size);
-    memcpy(mem.log_path, task_cfg->log_path, task_cfg->log_path_size);
-    if (create_unique_path(mem.data_path, sizeof(mem.data_path)) == false) {
-        ESP_LOGE(TAG, "Unable to create unique path");
+    // NVS keeps the next session number and the session left open, without it the number is found
+    // on the card and nothing is recovered
+    esp_err_t err = nvs_flash_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS not available: %s", esp_err_to_name(err));
+    }
+
+    // the older sessions were closed or recovered on an earlier boot
+    char open_session[SD_PATH_SIZE];
+    if (load_open_session(open_session, sizeof(open_session)) == true) {
+        int64_t start = esp_timer_get_time();
+        xSemaphoreTake(mem.spi_mutex, portMAX_DELAY);
+        recover_files(open_session);
+        recover_session(open_session);
+        xSemaphoreGive(mem.spi_mutex);
+        ESP_LOGI(TAG, "Checked the open session %s in %lld us", open_session, esp_timer_get_time() - start);
     }
 
-    if (create_unique_path(mem.log_path, sizeof(mem.log_path)) == false) {
+    mem.segment_size = task_cfg->segment_size;
+    mem.segment_duration_ms = task_cfg->segment_duration_ms;
+    start_session(task_cfg->data_path, task_cfg->data_path_size);
+
+    memcpy(mem.log_path, task_cfg->log_path, task_cfg->log_path_size);
+
+    if (create_unique_path(mem.log_path, sizeof(mem.log_path), SD_LOG_FILE_EXTENSION) == false) {
         ESP_LOGE(TAG, "Unable to create unique path");
     }
 
-    ESP_LOGI(TAG, "Using data path %s", mem.data_path);
+    ESP_LOGI(TAG, "Using data session %s", mem.session_path);
     ESP_LOGI(TAG, "Using log path %s", mem.log_path);
 
     return true;
@@ -263,23 +1607,81 @@ static bool initialize_task(sd_task_cfg_t *task_cfg) {
         return false;
     }
     mem.create_sd_frame_fnc = task_cfg->create_sd_frame_fnc;
+    mem.create_sd_header_fnc = task_cfg->create_sd_header_fnc;
+    mem.get_data_info_fnc = task_cfg->get_data_info_fnc;
 
     mem.data_from_queue_size = task_cfg->data_size;
-    mem.data_from_queue = malloc(task_cfg->data_size);
+    mem.queue_item_size = task_cfg->data_size + 1;
+    if (mem.queue_item_size > SD_DATA_ITEM_MAX_SIZE) {
+        return false;
+    }
+    mem.data_from_queue = malloc(3 * mem.queue_item_size);
     if (mem.data_from_queue == NULL) {
         return false;
     }
+    mem.discarded_item = (uint8_t*)mem.data_from_queue + mem.queue_item_size;
+    mem.send_item = (uint8_t*)mem.data_from_queue + 2 * mem.queue_item_size;
+    backpressure_init(&mem.backpressure, task_cfg->backpressure_policy, SD_DATA_QUEUE_SIZE,
+                      task_cfg->backpressure_groups, task_cfg->backpressure_group_count);
+    memset(&mem.accounted, 0, sizeof(mem.accounted));
+    mem.accounted_us = esp_timer_get_time();
+
+    if (file_allocate(&mem.data_file, mem.data_path, SD_DATA_WRITE_BUFFER_SIZE, task_cfg->preallocate_size) == false ||
+        file_allocate(&mem.log_file, mem.log_path, SD_LOG_WRITE_BUFFER_SIZE, 0) == false) {
+        file_free(&mem.data_file);
+        file_free(&mem.log_file);
+        free(mem.data_from_queue);
+        return false;
+    }
+    allocate_recent(task_cfg);
+    if (task_cfg->keyframe_interval > 0 && mem.ring.block_count > 0) {
+        // the full-rate records go to the recent file as they are, the segments get the summaries
+        ESP_LOGW(TAG, "Compression is not used with the two-tier logging");
+    } else if (task_cfg->keyframe_interval > 0) {
+        mem.codec = malloc(sizeof(record_codec_t));
+        if (mem.codec == NULL) {
+            file_free(&mem.data_file);
+            file_free(&mem.log_file);
+            free(mem.data_from_queue);
+            return false;
+        }
+        record_codec_init(mem.codec, task_cfg->keyframe_interval, task_cfg->compress_lz);
+    }
+    uint8_t *spill = NULL;
+    if (task_cfg->spill_size > 0) {
+        spill = heap_caps_malloc(task_cfg->spill_size, MALLOC_CAP_SPIRAM);
+        if (spill == NULL) {
+            spill = heap_caps_malloc(task_cfg->spill_size, MALLOC_CAP_8BIT);
+        }
+        if (spill == NULL) {
+            ESP_LOGW(TAG, "Unable to allocate the spill buffer, data is lost during remounts");
+        }
+    }
+    spill_buffer_init(&mem.spill, spill, spill != NULL ? task_cfg->spill_size : 0, mem.queue_item_size);
+    ESP_LOGI(TAG, "Spill buffer for %u records", mem.spill.capacity);
+    mem.sync_interval_ms = task_cfg->sync_interval_ms;
+    mem.last_sync_us = esp_timer_get_time();
+    SDT_reset_stats();
 
-    mem.data_queue = xQueueCreate(SD_DATA_QUEUE_SIZE, mem.data_from_queue_size);
+    mem.data_queue = xQueueCreate(SD_DATA_QUEUE_SIZE, mem.queue_item_size);
     if (mem.data_queue == NULL) {
         free(mem.data_from_queue);
+        free(mem.codec);
+        heap_caps_free(mem.spill.buffer);
+        free_recent();
+        file_free(&mem.data_file);
+        file_free(&mem.log_file);
         return false;
     }
 
-    mem.log_queue = xQueueCreate(SD_LOG_QUEUE_SIZE, sizeof(char[SD_LOG_BUFFER_MAX_SIZE]));
-    if (mem.log_queue == NULL) {
+    if (log_ring_init(&mem.log_ring, mem.log_ring_buffer, sizeof(mem.log_ring_buffer)) != LOG_RING_OK) {
         vQueueDelete(mem.data_queue);
         free(mem.data_from_queue);
+        free(mem.codec);
+        heap_caps_free(mem.spill.buffer);
+        free_recent();
+        file_free(&mem.data_file);
+        file_free(&mem.log_file);
         mem.data_queue = NULL;
         return false;
     }
@@ -288,10 +1690,13 @@ static bool initialize_task(sd_task_cfg_t *task_cfg) {
     mem.data_write_mutex = xSemaphoreCreateMutex();
     if (mem.data_write_mutex == NULL) {
         vQueueDelete(mem.data_queue);
-        vQueueDelete(mem.log_queue);
         mem.data_queue = NULL;
-        mem.log_queue = NULL;
         free(mem.data_from_queue);
+        free(mem.codec);
+        heap_caps_free(mem.spill.buffer);
+        free_recent();
+        file_free(&mem.data_file);
+        file_free(&mem.log_file);
         return false;
     }
 
@@ -300,10 +1705,13 @@ static bool initialize_task(sd_task_cfg_t *task_cfg) {
 
     if (mem.sd_task == NULL) {
         vQueueDelete(mem.data_queue);
-        vQueueDelete(mem.log_queue);
         mem.data_queue = NULL;
-        mem.log_queue = NULL;
         free(mem.data_from_queue);
+        free(mem.codec);
+        heap_caps_free(mem.spill.buffer);
+        free_recent();
+        file_free(&mem.data_file);
+        file_free(&mem.log_file);
         return false;
     }
 
@@ -332,6 +1740,60 @@ static size_t convert_data_to_frame(char *buf, size_t buf_size, void* data, size
     return frame_size;
 }
 
+static size_t encode_data_to_record(char *buf, size_t buf_size, void* data, size_t size) {
+    return tanwa_log_encode_record((uint8_t*)buf, buf_size, (tanwa_log_sample_t*)data);
+}
+
+static size_t create_data_header(char *buf, size_t buf_size) {
+    // the records are in codec blocks only if the codec is used, not with the two-tier logging
+    return tanwa_log_write_header((uint8_t*)buf, buf_size, mem.codec != NULL ? TANWA_LOG_FLAG_COMPRESSED : 0);
+}
+
+static bool get_sample_info(void *data, uint32_t *timestamp_ms, uint8_t *state) {
+    tanwa_log_sample_t *sample = (tanwa_log_sample_t*)data;
+    *timestamp_ms = sample->timestamp_ms;
+    *state = sample->data.state;
+    return true;
+}
+
+bool sd_frame_benchmark(uint32_t iterations, sd_frame_benchmark_t *result) {
+    if (iterations == 0 || result == NULL) {
+        return false;
+    }
+
+    // the console task has a 4 kB stack, the frame buffer does not go on it
+    char *buffer = malloc(SD_DATA_BUFFER_MAX_SIZE);
+    if (buffer == NULL) {
+        return false;
+    }
+    tanwa_log_sample_t sample = {
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .data = tanwa_data_read(),
+    };
+
+    size_t csv_size = 0;
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        csv_size = convert_data_to_frame(buffer, SD_DATA_BUFFER_MAX_SIZE, &sample.data, sizeof(sample.data));
+    }
+    int64_t csv_time = esp_timer_get_time() - start;
+
+    size_t binary_size = 0;
+    start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        binary_size = encode_data_to_record(buffer, SD_DATA_BUFFER_MAX_SIZE, &sample, sizeof(sample));
+    }
+    int64_t binary_time = esp_timer_get_time() - start;
+    free(buffer);
+
+    result->iterations = iterations;
+    result->csv_us_per_record = (float)csv_time / iterations;
+    result->csv_bytes_per_record = csv_size;
+    result->binary_us_per_record = (float)binary_time / iterations;
+    result->binary_bytes_per_record = binary_size;
+    return true;
+}
+
 void on_error(SD_TASK_ERR error) {
     if (error == SD_WRITE || error == SD_QUEUE_READ) {
         ESP_LOGE(TAG, "!!! SD ERROR CODE: SD_WRITE !!!");
@@ -340,9 +1802,30 @@ void on_error(SD_TASK_ERR error) {
     }
 }
 
+#define SAMPLE_GROUP(field) {offsetof(tanwa_log_sample_t, field), sizeof(((tanwa_log_sample_t*)0)->field)}
+
+// discrete parts of the sample, the "changed" policy keeps every sample in which one of them changed
+static const backpressure_group_t sample_groups[] = {
+    SAMPLE_GROUP(data.state),
+    // abort button and the solenoid bits after it
+    {offsetof(tanwa_log_sample_t, data.com_data.abort_button), 2},
+    SAMPLE_GROUP(data.com_data.igniter_cont_1),
+    SAMPLE_GROUP(data.com_data.igniter_cont_2),
+    SAMPLE_GROUP(data.can_connected_slaves),
+    SAMPLE_GROUP(data.can_hx_rocket_status),
+    SAMPLE_GROUP(data.can_hx_oxidizer_status),
+    SAMPLE_GROUP(data.can_fac_status),
+    SAMPLE_GROUP(data.can_flc_status),
+    SAMPLE_GROUP(data.can_termo_status),
+};
+
 bool init_sd_card(void) {
     // esp_timer_init();
     ESP_LOGI(TAG, "Initializing sd task");
+    if (tanwa_log_schema_record_size() != TANWA_LOG_RECORD_SIZE) {
+        ESP_LOGE(TAG, "Log record size mismatch: schema %d, record %d", tanwa_log_schema_record_size(), TANWA_LOG_RECORD_SIZE);
+        return false;
+    }
     sd_task_cfg_t cfg = {
         .cs_pin = CONFIG_SD_CS,
         .data_path = "data",
@@ -354,8 +1837,22 @@ bool init_sd_card(void) {
         .priority = SD_TASK_PRIORITY,
         .core_id = SD_TASK_CORE_ID,
         .error_handler_fnc = on_error,
-        .data_size = sizeof(tanwa_data_t),
-        .create_sd_frame_fnc = convert_data_to_frame,
+        .data_size = sizeof(tanwa_log_sample_t),
+        .create_sd_frame_fnc = encode_data_to_record,
+        .create_sd_header_fnc = create_data_header,
+        .get_data_info_fnc = get_sample_info,
+        .sync_interval_ms = SD_SYNC_INTERVAL_MS,
+        .preallocate_size = SD_DATA_PREALLOCATE_SIZE,
+        .segment_size = SD_SEGMENT_SIZE,
+        .segment_duration_ms = SD_SEGMENT_DURATION_MS,
+        .keyframe_interval = SD_DATA_KEYFRAME_INTERVAL,
+        .compress_lz = SD_DATA_COMPRESS_LZ,
+        .spill_size = SD_SPILL_BUFFER_SIZE,
+        .backpressure_policy = SD_BACKPRESSURE_POLICY,
+        .backpressure_groups = sample_groups,
+        .backpressure_group_count = sizeof(sample_groups) / sizeof(sample_groups[0]),
+        .recent_size = SD_RECENT_SIZE,
+        .summary_interval_ms = SD_SUMMARY_INTERVAL_MS,
         .spi_mutex = mutex_spi,
     };
 
@@ -387,33 +1884,56 @@ bool SDT_send_data(void *data, size_t data_size) {
         return false;
     }
 
-    if (mem.sd_card.mounted == false) {
-        return false;
+    if (backpressure_check(&mem.backpressure, data, data_size, uxQueueMessagesWaiting(mem.data_queue)) == false) {
+        // decimated, counted in the backpressure frame
+        return true;
     }
 
-    if (xQueueSend(mem.data_queue, data, 0) == pdFALSE) {
+    // one producer like the backpressure check, the queue copies the item before it returns
+    memcpy(mem.send_item, data, data_size);
+    mem.send_item[data_size] = backpressure_get_decimation(&mem.backpressure);
+
+    // accepted also while the card is remounted, the sd task keeps it in the spill buffer
+    BaseType_t ret = xQueueSend(mem.data_queue, mem.send_item, 0);
+    if (ret == pdFALSE && backpressure_get_policy(&mem.backpressure) == BACKPRESSURE_DROP_OLDEST &&
+        xQueueReceive(mem.data_queue, mem.discarded_item, 0) == pdTRUE) {
+        backpressure_count_dropped(&mem.backpressure);
+        ret = xQueueSend(mem.data_queue, mem.send_item, 0);
+    }
+    if (ret == pdFALSE) {
+        backpressure_count_dropped(&mem.backpressure);
         ESP_LOGW(TAG, "Unable to add data to sd mem.queue");
         return false;
     }
 
+    backpressure_count_queued(&mem.backpressure);
     return true;
 }
 
 bool SDT_send_log(char *data, size_t data_size) {
-    if (mem.log_queue == NULL) {
+    if (mem.log_ring.buffer == NULL) {
         return false;
     }
 
-    if (data_size > SD_DATA_BUFFER_MAX_SIZE) {
+    // no logging here, it could be called from the log output itself, drops are counted by the ring
+    size_t length = strnlen(data, data_size);
+    if (length > SD_LOG_BUFFER_MAX_SIZE) {
         return false;
     }
 
-    if (xQueueSend(mem.log_queue, data, 0) == pdFALSE) {
-        ESP_LOGW(TAG, "Unable to add data to sd mem.queue");
+    return log_ring_push(&mem.log_ring, data, length);
+}
+
+bool SDT_reserve_log(size_t log_size, log_ring_reservation_t *reservation) {
+    if (mem.log_ring.buffer == NULL || log_size > SD_LOG_BUFFER_MAX_SIZE) {
         return false;
     }
 
-    return true;
+    return log_ring_reserve(&mem.log_ring, log_size, reservation);
+}
+
+void SDT_commit_log(const log_ring_reservation_t *reservation, size_t log_size) {
+    log_ring_commit(&mem.log_ring, reservation, log_size);
 }
 
 bool SDT_change_data_path(char *new_path, size_t path_size) {
@@ -421,12 +1941,80 @@ bool SDT_change_data_path(char *new_path, size_t path_size) {
         return false;
     }
 
-    memcpy(mem.data_path, new_path, path_size);
-    if (create_unique_path(mem.data_path, sizeof(mem.data_path)) == false) {
-        ESP_LOGE(TAG, "Unable to create unique path");
+    finish_segment();
+    index_close();
+    ring_close();
+    store_open_session(NULL);
+    bool ret = start_session(new_path, path_size);
+
+    xSemaphoreGive(mem.data_write_mutex);
+    return ret;
+}
+
+void SDT_request_sync(void) { mem.sync_requested = true; }
+
+bool SDT_freeze_recent(void) {
+    if (mem.ring.block_count == 0) {
+        return false;
+    }
+
+    mem.freeze_requested = true;
+    return true;
+}
+
+void SDT_set_backpressure_policy(backpressure_policy_t policy) {
+    backpressure_set_policy(&mem.backpressure, policy);
+    ESP_LOGI(TAG, "Backpressure policy %s", backpressure_policy_name(policy));
+}
+
+void SDT_get_stats(sd_task_stats_t *stats) {
+    *stats = mem.stats;
+    spill_buffer_get_stats(&mem.spill, &stats->spill);
+    backpressure_get_counters(&mem.backpressure, &stats->samples);
+    stats->policy = backpressure_get_policy(&mem.backpressure);
+    stats->decimation = backpressure_get_decimation(&mem.backpressure);
+}
+
+static void lock_spi(void) { xSemaphoreTake(mem.spi_mutex, portMAX_DELAY); }
+
+static void unlock_spi(void) { xSemaphoreGive(mem.spi_mutex); }
+
+bool SDT_run_benchmark(sd_bench_cfg_t *cfg, sd_bench_result_t *result) {
+    if (mem.data_write_mutex == NULL || mem.sd_card.mounted == false) {
+        return false;
+    }
+
+    mem.benchmark_running = true;
+    if (xSemaphoreTake(mem.data_write_mutex, 100) == pdFALSE) {
+        mem.benchmark_running = false;
+        return false;
     }
 
+    cfg->dir = SD_MOUNT_POINT;
+    cfg->lock = lock_spi;
+    cfg->unlock = unlock_spi;
+    bool ret = sd_bench_run(cfg, result);
+
     xSemaphoreGive(mem.data_write_mutex);
+    mem.benchmark_running = false;
+    return ret;
+}
+
+void SDT_reset_stats(void) {
+    memset(&mem.stats, 0, sizeof(mem.stats));
+    mem.stats.since_us = esp_timer_get_time();
+    spill_buffer_reset_stats(&mem.spill);
+    if (mem.log_ring.buffer != NULL) {
+        log_ring_reset_stats(&mem.log_ring);
+    }
+}
+
+bool SDT_get_log_stats(log_ring_stats_t *stats) {
+    if (mem.log_ring.buffer == NULL) {
+        return false;
+    }
+
+    log_ring_get_stats(&mem.log_ring, stats);
     return true;
 }
 
@@ -4,23 +4,70 @@
 
 #include <stdint.h>
 #include "sdcard.h"
+#include "log_ring.h"
+#include "spill_buffer.h"
+#include "backpressure.h"
+#include "latency_hist.h"
+#include "sd_bench.h"
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/projdefs.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
 
-#define SD_LOG_BUFFER_MAX_SIZE 256
-#define SD_DATA_BUFFER_MAX_SIZE 512
+#define SD_LOG_BUFFER_MAX_SIZE 256  // longest log record
+#define SD_LOG_RING_SIZE 8192
+#define SD_DATA_BUFFER_MAX_SIZE 2048  // has to fit the data file header
 #define SD_MOUNT_POINT "/sdcard"
 
 #define SD_DATA_QUEUE_SIZE 20
-#define SD_LOG_QUEUE_SIZE 20
 #define SD_MAX_DATA_RECEIVE 25
 #define SD_TRY_TO_REMOUNT_DELAY 1000
 #define SD_DATA_DROP_VALUE 10
+#define SD_DATA_ITEM_MAX_SIZE 256  // data with its decimation byte
+#define SD_ACCOUNTING_INTERVAL_MS 1000  // backpressure frame written at least this often
+#define SD_BACKPRESSURE_POLICY CONFIG_SD_BACKPRESSURE_POLICY
+
+#define SD_DATA_WRITE_BUFFER_SIZE CONFIG_SD_WRITE_BUFFER_SIZE
+#define SD_LOG_WRITE_BUFFER_SIZE 1024
+#define SD_SYNC_INTERVAL_MS CONFIG_SD_SYNC_INTERVAL_MS
+#ifdef CONFIG_SD_PREALLOCATE_DATA_FILE
+#define SD_DATA_PREALLOCATE_SIZE (CONFIG_SD_PREALLOCATE_SIZE_KB * 1024)
+#else
+#define SD_DATA_PREALLOCATE_SIZE 0
+#endif
+#ifdef CONFIG_SD_COMPRESS_DATA
+#define SD_DATA_KEYFRAME_INTERVAL CONFIG_SD_COMPRESS_KEYFRAME_INTERVAL
+#else
+#define SD_DATA_KEYFRAME_INTERVAL 0
+#endif
+#ifdef CONFIG_SD_COMPRESS_LZ
+#define SD_DATA_COMPRESS_LZ true
+#else
+#define SD_DATA_COMPRESS_LZ false
+#endif
+#define SD_SPILL_BUFFER_SIZE (CONFIG_SD_SPILL_BUFFER_KB * 1024)
+#define SD_SPILL_DRAIN_MAX 100  // spilled records written in one sd task cycle
+#ifdef CONFIG_SD_TWO_TIER
+#define SD_RECENT_SIZE (CONFIG_SD_RECENT_SIZE_KB * 1024)
+#define SD_SUMMARY_INTERVAL_MS CONFIG_SD_SUMMARY_INTERVAL_MS
+#else
+#define SD_RECENT_SIZE 0
+#define SD_SUMMARY_INTERVAL_MS 0
+#endif
+#define SD_FREEZE_BLOCKS_PER_CYCLE 4  // recent blocks copied to the frozen file in one sd task cycle
+#define SD_SEGMENT_SIZE (CONFIG_SD_SEGMENT_SIZE_KB * 1024)
+#define SD_SEGMENT_DURATION_MS (CONFIG_SD_SEGMENT_DURATION_S * 1000)
+#define SD_RECOVERY_SCAN_SIZE 65536  // tail of the unclosed segment checked at boot
+#define SD_RECOVERY_BUFFER_SIZE 8192  // has to fit the longest frame
 
 #define SD_PATH_SIZE 40
+#define SD_DATA_FILE_EXTENSION ".bin"
+#define SD_LOG_FILE_EXTENSION ".txt"
+#define SD_HWM_FILE_EXTENSION ".hwm"
+#define SD_SESSION_PREFIX_MAX_SIZE 5  // session directory keeps a 8.3 name with the number
+#define SD_NVS_NAMESPACE "sd_task"
+#define SD_NVS_OPEN_SESSION_KEY "open_session"  // path of the session not closed yet
 
 typedef enum {
     SD_INIT,
@@ -32,6 +79,8 @@ typedef enum {
 
 typedef void (*error_handler)(SD_TASK_ERR error_code);
 typedef size_t (*create_sd_frame)(char *buffer, size_t buffer_size, void* data, size_t size);
+typedef size_t (*create_sd_header)(char *buffer, size_t buffer_size);
+typedef bool (*get_sd_data_info)(void *data, uint32_t *timestamp_ms, uint8_t *state);
 
 
 typedef struct {
@@ -49,11 +98,55 @@ typedef struct {
     UBaseType_t priority;
 
     SemaphoreHandle_t spi_mutex;
+    uint32_t sync_interval_ms;
+    size_t preallocate_size;  // 0 to let the data file grow while writing
+    size_t segment_size;  // data segment is rotated after this size
+    uint32_t segment_duration_ms;  // or after this time, 0 to rotate by size only
+    uint16_t keyframe_interval;  // records per compressed block, 0 to write the frames as they are
+    bool compress_lz;
+    size_t spill_size;  // RAM for the data while the card is remounted, 0 to drop it
+    backpressure_policy_t backpressure_policy;
+    const backpressure_group_t *backpressure_groups;  // watched by BACKPRESSURE_CHANGED, can be NULL
+    size_t backpressure_group_count;
+    size_t recent_size;  // circular file of the full-rate records, 0 to write them to the segments
+    uint32_t summary_interval_ms;  // summaries written to the segments instead of the records
 
     error_handler error_handler_fnc;
     create_sd_frame create_sd_frame_fnc;
+    create_sd_header create_sd_header_fnc;  // written at the beginning of every data file, can be NULL
+    get_sd_data_info get_data_info_fnc;  // timestamp and state for the segment index, can be NULL
 } sd_task_cfg_t;
 
+typedef struct {
+    uint64_t bytes_written;
+    uint32_t error_count;
+    uint32_t segment_count;
+    uint32_t compress_records;
+    uint64_t compress_bytes_in;
+    uint64_t compress_bytes_out;
+    uint64_t compress_us;
+    latency_hist_t queue_wait;  // from the sample timestamp to the sd task
+    latency_hist_t serialize;  // frame encoding, the codec time is in compress_us
+    latency_hist_t write;  // one chunk write
+    latency_hist_t sync;  // all files
+    spill_buffer_stats_t spill;
+    backpressure_counters_t samples;  // since boot, not cleared by the reset
+    backpressure_policy_t policy;
+    uint8_t decimation;
+    uint32_t recent_blocks;  // written to the circular file
+    uint32_t summaries;
+    uint32_t frozen_blocks;
+    int64_t since_us;  // time of the last reset
+} sd_task_stats_t;
+
+typedef struct {
+    uint32_t iterations;
+    float csv_us_per_record;
+    uint32_t csv_bytes_per_record;
+    float binary_us_per_record;
+    uint32_t binary_bytes_per_record;
+} sd_frame_benchmark_t;
+
 /**
  * @brief Initalize sd card task
  * 
@@ -62,6 +155,16 @@ typedef struct {
  */
 bool init_sd_card(void);
 
+/**
+ * @brief Compare the encode cost and size of the CSV line and the binary record
+ *
+ * @param iterations number of encoded frames of each format
+ * @param result pointer to the benchmark result
+ * @return true :)
+ * @return false :C
+ */
+bool sd_frame_benchmark(uint32_t iterations, sd_frame_benchmark_t *result);
+
 /**
  * @brief Initialzie sd task
  *
@@ -78,21 +181,45 @@ bool SDT_init(sd_task_cfg_t *cfg);
  * @param data_size data string size
  * @return true :)
  * @return false :C
+ * @note Called from a single producer task, the item is staged in a buffer of the SD task
  */
 bool SDT_send_data(void *data, size_t data_size);
 
 /**
  * @brief Send log to save
  *
+ * @note Copies only the string, does not block, safe to call from any task.
+ *
  * @param log pointer to log string
  * @param log_size log stirng size
  * @return true :)
- * @return false :C
+ * @return false :C the log ring is full
  */
 bool SDT_send_log(char *log, size_t log_size);
 
 /**
- * @brief Change path for data saving
+ * @brief Reserve a log record in the log ring, the caller writes the line in place
+ *
+ * @note Does not block, safe to call from any task. Commit the record right after writing it,
+ *       the SD task does not write the later logs until then.
+ *
+ * @param log_size longest line, at most SD_LOG_BUFFER_MAX_SIZE
+ * @return true :)
+ * @return false :C the log ring is full
+ */
+bool SDT_reserve_log(size_t log_size, log_ring_reservation_t *reservation);
+
+/**
+ * @brief Save the reserved log record
+ *
+ * @param log_size length of the line, 0 drops the record
+ */
+void SDT_commit_log(const log_ring_reservation_t *reservation, size_t log_size);
+
+/**
+ * @brief Finish the current session and start a new one
+ *
+ * @note Every session is a directory with numbered data segments and the index file.
  * 
  * @param new_path new path string
  * @param path_size new path size 
@@ -101,6 +228,64 @@ bool SDT_send_log(char *log, size_t log_size);
  */
 bool SDT_change_data_path(char *new_path, size_t path_size);
 
+/**
+ * @brief Write the buffered data and sync the files in the next sd task cycle
+ *
+ */
+void SDT_request_sync(void);
+
+/**
+ * @brief Copy the circular file of the recent full-rate data to a permanent file
+ *
+ * @note The copy is done by the sd task a few blocks per cycle, the blocks the writer would
+ *       overwrite are copied first. Safe to call from any task.
+ *
+ * @return true :)
+ * @return false :C the two-tier logging is disabled
+ */
+bool SDT_freeze_recent(void);
+
+/**
+ * @brief Change the policy used when the data comes faster than it is written
+ *
+ * @param policy backpressure policy
+ */
+void SDT_set_backpressure_policy(backpressure_policy_t policy);
+
+/**
+ * @brief Get the write statistics of the sd task
+ *
+ * @param stats pointer to the statistics copy
+ */
+void SDT_get_stats(sd_task_stats_t *stats);
+
+/**
+ * @brief Run the SD card benchmark in the mount point directory
+ *
+ * @note Data saving is paused for the whole benchmark, the samples wait in the spill buffer.
+ *
+ * @param cfg benchmark config, the directory and locks are set by the sd task
+ * @param result pointer to the result
+ * @return true :)
+ * @return false :C card not mounted or the benchmark failed
+ */
+bool SDT_run_benchmark(sd_bench_cfg_t *cfg, sd_bench_result_t *result);
+
+/**
+ * @brief Get the statistics of the log ring, including dropped logs
+ *
+ * @param stats pointer to the statistics copy
+ * @return true :)
+ * @return false :C sd task is not initialized
+ */
+bool SDT_get_log_stats(log_ring_stats_t *stats);
+
+/**
+ * @brief Clear the write statistics
+ *
+ */
+void SDT_reset_stats(void);
+
 /**
  * @brief Terminate sd task
  *
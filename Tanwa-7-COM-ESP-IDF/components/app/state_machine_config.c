@@ -15,77 +15,106 @@
 #include "TANWA_config.h"
 
 #include "timers_config.h"
+#include "sd_task.h"
+#include "sd_rate.h"
 
 #define TAG "SMC"
 
 extern TANWA_utility_t TANWA_utility;
 
 static void on_init(void *arg) {
+    sd_rate_update();
     ESP_LOGI(TAG, "ON INIT");
 }
 
 static void on_idle(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     sys_timer_stop(TIMER_BUZZER);
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_IDLE);
     ESP_LOGI(TAG, "ON IDLE");
 }
 
 static void on_recovery_arm(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_ARMED);
     ESP_LOGI(TAG, "ON ARM");
 }
 
 static void on_fueling(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_FUELING);
     buzzer_timer_start(5000);
     ESP_LOGI(TAG, "ON FUELING");
 }
 
 static void on_armed_to_launch(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_ARMED_TO_LAUNCH);
     buzzer_timer_change_period(3000);
     ESP_LOGI(TAG, "ON ARMED TO LAUNCH");
 }
 
 static void on_ready_to_lauch(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_RDY_TO_LAUNCH);
     buzzer_timer_change_period(2000);
     ESP_LOGI(TAG, "ON READY_TO_LAUNCH");
 }
 
 static void on_countdown(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_COUTDOWN);
     buzzer_timer_change_period(500);
     ESP_LOGI(TAG, "ON COUNTDOWN");
 }
 
 static void on_flight(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_FLIGHT);
     sys_timer_stop(TIMER_BUZZER);
     ESP_LOGI(TAG, "----> ON FLIGHT <----");
 }
 
 static void on_first_stage_recovery(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_FIRST_STAGE);
     ESP_LOGI(TAG, "ON FIRST STAGE RECOVERY");
 }
 
 static void on_second_stage_recovery(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_SECOND_STAGE);
     ESP_LOGI(TAG, "ON FIRST STAGE RECOVERY");
 }
 
 static void on_ground(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_ON_GROUND);
     ESP_LOGI(TAG, "ON GROUND");
 }
 
 static void on_hold(void *arg) {
+    SDT_request_sync();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_HOLD);
     ESP_LOGI(TAG, "ON HOLD");
 }
 
 static void on_abort(void *arg) {
+    SDT_request_sync();
+    // keep the full-rate data before the abort, it is overwritten in the circular file otherwise
+    SDT_freeze_recent();
+    sd_rate_update();
     led_state_display_state_update(&TANWA_utility.led_state_display, LED_STATE_DISPLAY_STATE_ABORT);
     buzzer_timer_change_period(1000);
     ESP_LOGI(TAG, "ON ABORT");
@@ -0,0 +1,353 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "telemetry_compact.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief Layout of the fields: name, width, width of the signed difference of a delta frame (0 if
+ *        the field has none) and the sign, in the order of telemetry_compact_field_t
+ */
+#define FIELD_LAYOUT(X)                 \
+    X(STATE, 4, 0, false)               \
+    X(PRESSURE, 16, 8, false)           \
+    X(FLAGS, 7, 0, false)               \
+    X(HX_REQUEST_RCK, 2, 0, false)      \
+    X(HX_REQUEST_TANK, 2, 0, false)     \
+    X(VBAT, 12, 6, false)               \
+    X(MOTOR_STATE_1, 4, 0, false)       \
+    X(MOTOR_STATE_2, 4, 0, false)       \
+    X(MOTOR_STATE_3, 4, 0, false)       \
+    X(MOTOR_STATE_4, 4, 0, false)       \
+    X(TEMPERATURE_RCK, 16, 6, true)     \
+    X(TEMPERATURE_TANK, 16, 6, true)    \
+    X(WEIGHT_RCK, 18, 10, true)         \
+    X(WEIGHT_TANK, 18, 10, true)        \
+    X(WEIGHT_RAW_RCK, 24, 12, true)     \
+    X(WEIGHT_RAW_TANK, 24, 12, true)
+
+#define LAYOUT_ENTRY(name, width, short_width, is_signed) [TELEMETRY_COMPACT_##name] = {width, short_width, is_signed},
+#define LAYOUT_COUNT(name, width, short_width, is_signed) +1
+#define LAYOUT_WIDTH(name, width, short_width, is_signed) +(width)
+#define LAYOUT_SHORT(name, width, short_width, is_signed) +((short_width) > 0)
+
+#define LAYOUT_FIELDS (0 FIELD_LAYOUT(LAYOUT_COUNT))
+#define LAYOUT_BITS (0 FIELD_LAYOUT(LAYOUT_WIDTH))  // 175
+#define LAYOUT_SHORT_FIELDS (0 FIELD_LAYOUT(LAYOUT_SHORT))  // 8
+#define KEY_HEADER_BITS 8
+#define DELTA_HEADER_BITS (8 + 6 + LAYOUT_FIELDS)  // header, base sequence, mask of the changed fields
+// 27 B, all fields changed and none short, 30 + 175 + 8 bits
+#define DELTA_MAX_SIZE ((DELTA_HEADER_BITS + LAYOUT_BITS + LAYOUT_SHORT_FIELDS + 7) / 8)
+
+#if (KEY_HEADER_BITS + LAYOUT_BITS + 7) / 8 > TELEMETRY_COMPACT_MAX_SIZE
+#error "The key frame does not fit in TELEMETRY_COMPACT_MAX_SIZE"
+#endif
+#if LAYOUT_FIELDS > 32
+#error "The mask of the changed fields has to fit in 32 bits"
+#endif
+
+typedef struct {
+    uint8_t width;
+    uint8_t short_width;  // signed difference of a delta frame, 0 if the field has none
+    bool is_signed;
+} field_layout_t;
+
+_Static_assert(LAYOUT_FIELDS == TELEMETRY_COMPACT_FIELDS, "FIELD_LAYOUT has to list every telemetry_compact_field_t");
+
+static const field_layout_t layout[TELEMETRY_COMPACT_FIELDS] = {FIELD_LAYOUT(LAYOUT_ENTRY)};
+
+typedef struct {
+    uint8_t *buffer;
+    size_t bits;
+} bit_writer_t;
+
+typedef struct {
+    const uint8_t *buffer;
+    size_t size_bits;
+    size_t bits;
+} bit_reader_t;
+
+static void put_bits(bit_writer_t *writer, uint32_t value, uint8_t width) {
+    for (uint8_t i = 0; i < width; ++i, ++writer->bits) {
+        if (value & (1UL << i)) {
+            writer->buffer[writer->bits / 8] |= (uint8_t)(1 << (writer->bits % 8));
+        }
+    }
+}
+
+static bool get_bits(bit_reader_t *reader, uint8_t width, uint32_t *value) {
+    if (reader->bits + width > reader->size_bits) {
+        return false;
+    }
+
+    *value = 0;
+    for (uint8_t i = 0; i < width; ++i, ++reader->bits) {
+        if (reader->buffer[reader->bits / 8] & (1 << (reader->bits % 8))) {
+            *value |= 1UL << i;
+        }
+    }
+    return true;
+}
+
+static int32_t sign_extend(uint32_t value, uint8_t width) {
+    uint32_t sign = 1UL << (width - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+static uint32_t field_mask(uint8_t width) {
+    return width >= 32 ? 0xffffffffUL : (1UL << width) - 1;
+}
+
+static int64_t field_value(const telemetry_compact_t *frame, int field) {
+    return layout[field].is_signed ? (int64_t)(int32_t)frame->field[field] : (int64_t)frame->field[field];
+}
+
+static uint32_t clamp_unsigned(uint32_t value, uint8_t width) {
+    return value > field_mask(width) ? field_mask(width) : value;
+}
+
+static int32_t clamp_signed(int64_t value, uint8_t width) {
+    int64_t max = (1LL << (width - 1)) - 1;
+    if (value > max) {
+        return (int32_t)max;
+    }
+    if (value < -max - 1) {
+        return (int32_t)(-max - 1);
+    }
+    return (int32_t)value;
+}
+
+/**
+ * @brief Round to the fixed point value, NaN is sent as 0, the result fits the int32_t range
+ */
+static int64_t to_fixed(float value, float scale) {
+    float scaled = value * scale;
+    if (isnan(scaled)) {
+        return 0;
+    }
+    if (scaled > 2e9f) {
+        return 2000000000LL;
+    }
+    if (scaled < -2e9f) {
+        return -2000000000LL;
+    }
+    return (int64_t)lroundf(scaled);
+}
+
+void telemetry_compact_from_lora_frame(const LoRaFrame *lora_frame, telemetry_compact_t *frame) {
+    uint32_t *f = frame->field;
+    f[TELEMETRY_COMPACT_STATE] = clamp_unsigned(lora_frame->tanwastate, 4);
+    f[TELEMETRY_COMPACT_PRESSURE] = clamp_unsigned(lora_frame->pressuresensor, 16);
+    f[TELEMETRY_COMPACT_FLAGS] = (lora_frame->solenoid_fill ? TELEMETRY_COMPACT_FLAG_FILL : 0) |
+                                 (lora_frame->solenoid_depr ? TELEMETRY_COMPACT_FLAG_DEPR : 0) |
+                                 (lora_frame->abortbutton ? TELEMETRY_COMPACT_FLAG_ABORT : 0) |
+                                 (lora_frame->ignitercontinouity_1 ? TELEMETRY_COMPACT_FLAG_IGNITER_1 : 0) |
+                                 (lora_frame->ignitercontinouity_2 ? TELEMETRY_COMPACT_FLAG_IGNITER_2 : 0) |
+                                 (lora_frame->interface_rck ? TELEMETRY_COMPACT_FLAG_INTERFACE_RCK : 0) |
+                                 (lora_frame->interface_tank ? TELEMETRY_COMPACT_FLAG_INTERFACE_TANK : 0);
+    f[TELEMETRY_COMPACT_HX_REQUEST_RCK] = clamp_unsigned(lora_frame->hxrequest_rck, 2);
+    f[TELEMETRY_COMPACT_HX_REQUEST_TANK] = clamp_unsigned(lora_frame->hxrequest_tank, 2);
+    int64_t vbat = to_fixed(lora_frame->vbat, 100.0f);
+    f[TELEMETRY_COMPACT_VBAT] = vbat < 0 ? 0 : clamp_unsigned((uint32_t)vbat, 12);
+    f[TELEMETRY_COMPACT_MOTOR_STATE_1] = clamp_unsigned(lora_frame->motorstate_1, 4);
+    f[TELEMETRY_COMPACT_MOTOR_STATE_2] = clamp_unsigned(lora_frame->motorstate_2, 4);
+    f[TELEMETRY_COMPACT_MOTOR_STATE_3] = clamp_unsigned(lora_frame->motorstate_3, 4);
+    f[TELEMETRY_COMPACT_MOTOR_STATE_4] = clamp_unsigned(lora_frame->motorstate_4, 4);
+    f[TELEMETRY_COMPACT_TEMPERATURE_RCK] = (uint32_t)clamp_signed(to_fixed(lora_frame->rocketweight_temp, 1.0f), 16);
+    f[TELEMETRY_COMPACT_TEMPERATURE_TANK] = (uint32_t)clamp_signed(to_fixed(lora_frame->tankweight_temp, 1.0f), 16);
+    f[TELEMETRY_COMPACT_WEIGHT_RCK] = (uint32_t)clamp_signed(to_fixed(lora_frame->rocketweight_val, 100.0f), 18);
+    f[TELEMETRY_COMPACT_WEIGHT_TANK] = (uint32_t)clamp_signed(to_fixed(lora_frame->tankweight_val, 100.0f), 18);
+    // the HX711 is a 24 bit ADC, sent sign extended whether the HX board extends it or not
+    f[TELEMETRY_COMPACT_WEIGHT_RAW_RCK] = (uint32_t)sign_extend(lora_frame->rocketweightraw_val & field_mask(24), 24);
+    f[TELEMETRY_COMPACT_WEIGHT_RAW_TANK] = (uint32_t)sign_extend(lora_frame->tankweightraw_val & field_mask(24), 24);
+}
+
+void telemetry_compact_to_lora_frame(const telemetry_compact_t *frame, LoRaFrame *lora_frame) {
+    const uint32_t *f = frame->field;
+    lo_ra_frame__init(lora_frame);
+    lora_frame->tanwastate = f[TELEMETRY_COMPACT_STATE];
+    lora_frame->pressuresensor = f[TELEMETRY_COMPACT_PRESSURE];
+    uint32_t flags = f[TELEMETRY_COMPACT_FLAGS];
+    lora_frame->solenoid_fill = (flags & TELEMETRY_COMPACT_FLAG_FILL) != 0;
+    lora_frame->solenoid_depr = (flags & TELEMETRY_COMPACT_FLAG_DEPR) != 0;
+    lora_frame->abortbutton = (flags & TELEMETRY_COMPACT_FLAG_ABORT) != 0;
+    lora_frame->ignitercontinouity_1 = (flags & TELEMETRY_COMPACT_FLAG_IGNITER_1) != 0;
+    lora_frame->ignitercontinouity_2 = (flags & TELEMETRY_COMPACT_FLAG_IGNITER_2) != 0;
+    lora_frame->interface_rck = (flags & TELEMETRY_COMPACT_FLAG_INTERFACE_RCK) != 0;
+    lora_frame->interface_tank = (flags & TELEMETRY_COMPACT_FLAG_INTERFACE_TANK) != 0;
+    lora_frame->hxrequest_rck = f[TELEMETRY_COMPACT_HX_REQUEST_RCK];
+    lora_frame->hxrequest_tank = f[TELEMETRY_COMPACT_HX_REQUEST_TANK];
+    lora_frame->vbat = f[TELEMETRY_COMPACT_VBAT] / 100.0f;
+    lora_frame->motorstate_1 = f[TELEMETRY_COMPACT_MOTOR_STATE_1];
+    lora_frame->motorstate_2 = f[TELEMETRY_COMPACT_MOTOR_STATE_2];
+    lora_frame->motorstate_3 = f[TELEMETRY_COMPACT_MOTOR_STATE_3];
+    lora_frame->motorstate_4 = f[TELEMETRY_COMPACT_MOTOR_STATE_4];
+    lora_frame->rocketweight_temp = (int32_t)f[TELEMETRY_COMPACT_TEMPERATURE_RCK];
+    lora_frame->tankweight_temp = (int32_t)f[TELEMETRY_COMPACT_TEMPERATURE_TANK];
+    lora_frame->rocketweight_val = (int32_t)f[TELEMETRY_COMPACT_WEIGHT_RCK] / 100.0f;
+    lora_frame->tankweight_val = (int32_t)f[TELEMETRY_COMPACT_WEIGHT_TANK] / 100.0f;
+    lora_frame->rocketweightraw_val = f[TELEMETRY_COMPACT_WEIGHT_RAW_RCK];
+    lora_frame->tankweightraw_val = f[TELEMETRY_COMPACT_WEIGHT_RAW_TANK];
+    // the COM board itself, the frame is sent only when it runs
+    lora_frame->interface_mcu = true;
+}
+
+static size_t encode_key(const telemetry_compact_t *frame, uint8_t sequence, uint8_t *buffer) {
+    memset(buffer, 0, TELEMETRY_COMPACT_MAX_SIZE);
+    bit_writer_t writer = {buffer, 0};
+    put_bits(&writer, TELEMETRY_COMPACT_MARKER | sequence, KEY_HEADER_BITS);
+    for (int i = 0; i < TELEMETRY_COMPACT_FIELDS; ++i) {
+        put_bits(&writer, frame->field[i] & field_mask(layout[i].width), layout[i].width);
+    }
+    return (writer.bits + 7) / 8;
+}
+
+static size_t encode_delta(const telemetry_compact_t *frame, const telemetry_compact_sent_t *base, uint8_t sequence,
+                           uint8_t *buffer) {
+    memset(buffer, 0, DELTA_MAX_SIZE);
+    bit_writer_t writer = {buffer, 0};
+    put_bits(&writer, TELEMETRY_COMPACT_MARKER | TELEMETRY_COMPACT_DELTA | sequence, 8);
+    put_bits(&writer, base->index % TELEMETRY_COMPACT_SEQUENCES, 6);
+
+    uint32_t changed = 0;
+    for (int i = 0; i < TELEMETRY_COMPACT_FIELDS; ++i) {
+        if (frame->field[i] != base->frame.field[i]) {
+            changed |= 1UL << i;
+        }
+    }
+    put_bits(&writer, changed, TELEMETRY_COMPACT_FIELDS);
+
+    for (int i = 0; i < TELEMETRY_COMPACT_FIELDS; ++i) {
+        if ((changed & (1UL << i)) == 0) {
+            continue;
+        }
+        uint8_t short_width = layout[i].short_width;
+        if (short_width > 0) {
+            int64_t difference = field_value(frame, i) - field_value(&base->frame, i);
+            int64_t limit = 1LL << (short_width - 1);
+            bool is_short = difference >= -limit && difference < limit;
+            put_bits(&writer, is_short ? 1 : 0, 1);
+            if (is_short) {
+                put_bits(&writer, (uint32_t)difference & field_mask(short_width), short_width);
+                continue;
+            }
+        }
+        put_bits(&writer, frame->field[i] & field_mask(layout[i].width), layout[i].width);
+    }
+    return (writer.bits + 7) / 8;
+}
+
+void telemetry_compact_encoder_init(telemetry_compact_encoder_t *encoder, bool use_delta) {
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->use_delta = use_delta;
+}
+
+size_t telemetry_compact_encode(telemetry_compact_encoder_t *encoder, const telemetry_compact_t *frame,
+                                uint8_t *buffer) {
+    uint8_t sequence = encoder->sent % TELEMETRY_COMPACT_SEQUENCES;
+    size_t size = encode_key(frame, sequence, buffer);
+    bool is_delta = false;
+    if (encoder->use_delta && encoder->base_valid &&
+        encoder->sent - encoder->base.index <= TELEMETRY_COMPACT_MAX_BASE_AGE) {
+        uint8_t delta[DELTA_MAX_SIZE];
+        size_t delta_size = encode_delta(frame, &encoder->base, sequence, delta);
+        if (delta_size < size) {
+            memcpy(buffer, delta, delta_size);
+            size = delta_size;
+            is_delta = true;
+        }
+    }
+
+    if (is_delta) {
+        encoder->delta_frames++;
+    } else {
+        encoder->key_frames++;
+    }
+    telemetry_compact_sent_t *sent = &encoder->history[encoder->sent % TELEMETRY_COMPACT_HISTORY];
+    sent->frame = *frame;
+    sent->index = encoder->sent;
+    encoder->sent++;
+    return size;
+}
+
+bool telemetry_compact_ack(telemetry_compact_encoder_t *encoder, uint8_t sequence) {
+    const telemetry_compact_sent_t *sent = &encoder->history[sequence % TELEMETRY_COMPACT_HISTORY];
+    if (sequence >= TELEMETRY_COMPACT_SEQUENCES || sent->index >= encoder->sent ||
+        sent->index % TELEMETRY_COMPACT_SEQUENCES != sequence) {
+        return false;
+    }
+
+    // acknowledgements can come out of order, keep the newest base
+    if (encoder->base_valid == false || sent->index > encoder->base.index) {
+        encoder->base = *sent;
+        encoder->base_valid = true;
+    }
+    return true;
+}
+
+void telemetry_compact_decoder_init(telemetry_compact_decoder_t *decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+bool telemetry_compact_decode(telemetry_compact_decoder_t *decoder, const uint8_t *buffer, size_t size,
+                              telemetry_compact_t *frame, uint8_t *sequence) {
+    bit_reader_t reader = {buffer, size * 8, 0};
+    uint32_t header;
+    if (get_bits(&reader, 8, &header) == false || (header & TELEMETRY_COMPACT_MARKER) == 0) {
+        return false;
+    }
+
+    telemetry_compact_t decoded;
+    uint32_t value;
+    if ((header & TELEMETRY_COMPACT_DELTA) == 0) {
+        for (int i = 0; i < TELEMETRY_COMPACT_FIELDS; ++i) {
+            if (get_bits(&reader, layout[i].width, &value) == false) {
+                return false;
+            }
+            decoded.field[i] = layout[i].is_signed ? (uint32_t)sign_extend(value, layout[i].width) : value;
+        }
+    } else {
+        uint32_t base_sequence, changed;
+        if (get_bits(&reader, 6, &base_sequence) == false || (decoder->valid & (1ULL << base_sequence)) == 0 ||
+            get_bits(&reader, TELEMETRY_COMPACT_FIELDS, &changed) == false) {
+            return false;
+        }
+
+        const telemetry_compact_t *base = &decoder->frames[base_sequence];
+        decoded = *base;
+        for (int i = 0; i < TELEMETRY_COMPACT_FIELDS; ++i) {
+            if ((changed & (1UL << i)) == 0) {
+                continue;
+            }
+            uint8_t short_width = layout[i].short_width;
+            uint32_t is_short = 0;
+            if (short_width > 0 && get_bits(&reader, 1, &is_short) == false) {
+                return false;
+            }
+            if (is_short) {
+                if (get_bits(&reader, short_width, &value) == false) {
+                    return false;
+                }
+                int64_t sum = field_value(base, i) + sign_extend(value, short_width);
+                decoded.field[i] = (uint32_t)sum;
+                continue;
+            }
+            if (get_bits(&reader, layout[i].width, &value) == false) {
+                return false;
+            }
+            decoded.field[i] = layout[i].is_signed ? (uint32_t)sign_extend(value, layout[i].width) : value;
+        }
+    }
+
+    *sequence = header & TELEMETRY_COMPACT_SEQUENCE_MASK;
+    decoder->frames[*sequence] = decoded;
+    decoder->valid |= 1ULL << *sequence;
+    *frame = decoded;
+    return true;
+}
@@ -0,0 +1,141 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the compact LoRa telemetry encoding. The LoRaFrame values are
+/// packed LSB first with fixed bit widths, pressure, battery and weights as fixed point, the
+/// binary states as one flag field. A delta frame carries only the fields that differ from a base
+/// frame the ground station acknowledged, small changes as a short signed difference.
+///
+/// Layout of the first byte: bit 7 set (the LoRaFrame protobuf starts with 0x08), bit 6 delta,
+/// bits 0-5 sequence. Key frame: all fields. Delta frame: base sequence (6 bits), mask of the
+/// changed fields (16 bits), then for each changed field with a short form one bit (1 short,
+/// 0 full) and the value or the difference.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_TELEMETRY_COMPACT_H_
+#define PWRINSPACE_TELEMETRY_COMPACT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lora.pb-c.h"
+
+#define TELEMETRY_COMPACT_MAX_SIZE 23  // key frame, 8 + 175 bits, a delta is sent only if shorter
+#define TELEMETRY_COMPACT_SEQUENCES 64
+#define TELEMETRY_COMPACT_HISTORY 8  // sent frames that can still be acknowledged
+#define TELEMETRY_COMPACT_MAX_BASE_AGE 32  // frames since the base, the decoder slots wrap at 64
+
+#define TELEMETRY_COMPACT_MARKER 0x80
+#define TELEMETRY_COMPACT_DELTA 0x40
+#define TELEMETRY_COMPACT_SEQUENCE_MASK 0x3f
+
+#define TELEMETRY_COMPACT_FLAG_FILL (1 << 0)
+#define TELEMETRY_COMPACT_FLAG_DEPR (1 << 1)
+#define TELEMETRY_COMPACT_FLAG_ABORT (1 << 2)
+#define TELEMETRY_COMPACT_FLAG_IGNITER_1 (1 << 3)
+#define TELEMETRY_COMPACT_FLAG_IGNITER_2 (1 << 4)
+#define TELEMETRY_COMPACT_FLAG_INTERFACE_RCK (1 << 5)
+#define TELEMETRY_COMPACT_FLAG_INTERFACE_TANK (1 << 6)
+
+/**
+ * @brief Fields in the order of the layout, the comment is the width and the unit
+ */
+typedef enum {
+    TELEMETRY_COMPACT_STATE,  // 4 bits
+    TELEMETRY_COMPACT_PRESSURE,  // 16 bits, 0.01 bar like the LoRaFrame, up to 655.35 bar
+    TELEMETRY_COMPACT_FLAGS,  // 7 bits, TELEMETRY_COMPACT_FLAG_x
+    TELEMETRY_COMPACT_HX_REQUEST_RCK,  // 2 bits
+    TELEMETRY_COMPACT_HX_REQUEST_TANK,  // 2 bits
+    TELEMETRY_COMPACT_VBAT,  // 12 bits, 0.01 V, up to 40.95 V
+    TELEMETRY_COMPACT_MOTOR_STATE_1,  // 4 bits each, the FAC status nibbles
+    TELEMETRY_COMPACT_MOTOR_STATE_2,
+    TELEMETRY_COMPACT_MOTOR_STATE_3,
+    TELEMETRY_COMPACT_MOTOR_STATE_4,
+    TELEMETRY_COMPACT_TEMPERATURE_RCK,  // 16 bits signed, the HX status value
+    TELEMETRY_COMPACT_TEMPERATURE_TANK,
+    TELEMETRY_COMPACT_WEIGHT_RCK,  // 18 bits signed, 0.01 kg, +-1310.71 kg
+    TELEMETRY_COMPACT_WEIGHT_TANK,
+    TELEMETRY_COMPACT_WEIGHT_RAW_RCK,  // 24 bits signed, the HX711 reading sign extended
+    TELEMETRY_COMPACT_WEIGHT_RAW_TANK,
+    TELEMETRY_COMPACT_FIELDS,
+} telemetry_compact_field_t;
+
+/**
+ * @brief Frame values in the units of the layout, signed fields as int32_t
+ */
+typedef struct {
+    uint32_t field[TELEMETRY_COMPACT_FIELDS];
+} telemetry_compact_t;
+
+typedef struct {
+    telemetry_compact_t frame;
+    uint32_t index;  // number of the frame since the start
+} telemetry_compact_sent_t;
+
+typedef struct {
+    uint32_t sent;  // frames encoded, the next sequence is sent % TELEMETRY_COMPACT_SEQUENCES
+    telemetry_compact_sent_t history[TELEMETRY_COMPACT_HISTORY];
+    telemetry_compact_sent_t base;
+    bool base_valid;
+    bool use_delta;
+    uint32_t key_frames;
+    uint32_t delta_frames;
+} telemetry_compact_encoder_t;
+
+typedef struct {
+    telemetry_compact_t frames[TELEMETRY_COMPACT_SEQUENCES];  // last frame of every sequence
+    uint64_t valid;  // bit of the sequence
+} telemetry_compact_decoder_t;
+
+/**
+ * @brief Convert the LoRa frame, values out of range are clamped, floats rounded to the units
+ */
+void telemetry_compact_from_lora_frame(const LoRaFrame *lora_frame, telemetry_compact_t *frame);
+
+/**
+ * @brief Initialize and fill the LoRa frame from the compact values
+ */
+void telemetry_compact_to_lora_frame(const telemetry_compact_t *frame, LoRaFrame *lora_frame);
+
+/**
+ * @brief Initialize the encoder
+ *
+ * @param use_delta false to send only the key frames
+ */
+void telemetry_compact_encoder_init(telemetry_compact_encoder_t *encoder, bool use_delta);
+
+/**
+ * @brief Encode the next frame, a delta if there is an acknowledged base and it is shorter
+ *
+ * @param buffer output, at least TELEMETRY_COMPACT_MAX_SIZE bytes
+ * @return size of the frame
+ */
+size_t telemetry_compact_encode(telemetry_compact_encoder_t *encoder, const telemetry_compact_t *frame,
+                                uint8_t *buffer);
+
+/**
+ * @brief The ground station received the frame of the sequence, use it as the delta base
+ *
+ * @return false if the frame is no longer in the history
+ */
+bool telemetry_compact_ack(telemetry_compact_encoder_t *encoder, uint8_t sequence);
+
+void telemetry_compact_decoder_init(telemetry_compact_decoder_t *decoder);
+
+/**
+ * @brief Decode the frame and keep it as the base of the later delta frames
+ *
+ * @param sequence sequence of the frame, acknowledge it to the encoder
+ * @return true :)
+ * @return false :C not a compact frame, too short or the base frame is missing
+ */
+bool telemetry_compact_decode(telemetry_compact_decoder_t *decoder, const uint8_t *buffer, size_t size,
+                              telemetry_compact_t *frame, uint8_t *sequence);
+
+#endif /* PWRINSPACE_TELEMETRY_COMPACT_H_ */
@@ -0,0 +1,64 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "telemetry_frames.h"
+
+void telemetry_fill_now_frame(const tanwa_data_t *data, DataToObc *frame) {
+    frame->vbat = data->com_data.vbat;
+    frame->tanWaState = data->state;
+    frame->rocketWeight_val = data->can_hx_rocket_data.weight;
+    frame->tankWeight_val = data->can_hx_oxidizer_data.weight;
+    frame->fill_temp = data->can_flc_data.temperature_1;
+    frame->preFill_pres = data->com_data.pressure_1;
+    frame->postFill_pres = data->com_data.pressure_2;
+    frame->tank_pres = data->com_data.pressure_3;
+    frame->canHxBtl_con = data->can_connected_slaves.hx_oxidizer;
+    frame->canHxRck_con = data->can_connected_slaves.hx_rocket;
+    frame->canFac_con = data->can_connected_slaves.fac;
+    frame->canFlc_con = data->can_connected_slaves.flc;
+    frame->canTermo_con = data->can_connected_slaves.termo;
+    frame->igniterContinouity_1 = data->com_data.igniter_cont_1;
+    frame->igniterContinouity_2 = data->com_data.igniter_cont_2;
+    frame->limitSwitch_1 = data->can_fac_status.limit_switch_1;
+    frame->limitSwitch_2 = data->can_fac_status.limit_switch_2;
+    frame->facMotorState_1 = data->can_fac_status.motor_state_1;
+    frame->facMotorState_2 = data->can_fac_status.motor_state_2;
+    frame->coolingState = data->can_termo_status.cooling_status;
+    frame->heatingState = data->can_termo_status.heating_status;
+    frame->abortButton = data->com_data.abort_button;
+    frame->fillState = data->com_data.solenoid_state_fill;
+    frame->deprState = data->com_data.solenoid_state_depr;
+}
+
+void telemetry_fill_lora_frame(const tanwa_data_t *data, LoRaFrame *frame) {
+    lo_ra_frame__init(frame);
+    frame->tanwastate = data->state;
+    float pressure = data->com_data.pressure_3 > 0.0f ? data->com_data.pressure_3 : 0.0f;
+    frame->pressuresensor = (uint32_t)(pressure * 100.0f + 0.5f);
+    frame->solenoid_fill = data->com_data.solenoid_state_fill;
+    frame->solenoid_depr = data->com_data.solenoid_state_depr;
+    frame->abortbutton = data->com_data.abort_button;
+    frame->ignitercontinouity_1 = data->com_data.igniter_cont_1;
+    frame->ignitercontinouity_2 = data->com_data.igniter_cont_2;
+    frame->hxrequest_rck = data->can_hx_rocket_status.request;
+    frame->hxrequest_tank = data->can_hx_oxidizer_status.request;
+    frame->vbat = data->com_data.vbat;
+    frame->motorstate_1 = data->can_fac_status.motor_state_1;
+    frame->motorstate_2 = data->can_fac_status.motor_state_2;
+    frame->motorstate_3 = data->can_fac_status.servo_state_1;
+    frame->motorstate_4 = data->can_fac_status.servo_state_2;
+    frame->rocketweight_temp = data->can_hx_rocket_status.temperature;
+    frame->tankweight_temp = data->can_hx_oxidizer_status.temperature;
+    frame->rocketweight_val = data->can_hx_rocket_data.weight;
+    frame->tankweight_val = data->can_hx_oxidizer_data.weight;
+    frame->rocketweightraw_val = data->can_hx_rocket_data.weight_raw;
+    frame->tankweightraw_val = data->can_hx_oxidizer_data.weight_raw;
+    frame->interface_rck = data->can_connected_slaves.hx_rocket;
+    frame->interface_tank = data->can_connected_slaves.hx_oxidizer;
+    // the COM board itself, the frame is sent only when it runs
+    frame->interface_mcu = true;
+}
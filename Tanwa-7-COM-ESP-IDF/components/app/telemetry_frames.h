@@ -0,0 +1,33 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the telemetry serializers, the TANWA data copied to the
+/// ESP-NOW frame of the OBC and to the LoRa protobuf frame. They only read the given snapshot,
+/// so the same code runs in the tasks and in the host replay tool.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_TELEMETRY_FRAMES_H_
+#define PWRINSPACE_TELEMETRY_FRAMES_H_
+
+#include "TANWA_data.h"
+#include "now_structs.h"
+#include "lora.pb-c.h"
+
+/**
+ * @brief Fill the ESP-NOW frame sent to the OBC
+ */
+void telemetry_fill_now_frame(const tanwa_data_t *data, DataToObc *frame);
+
+/**
+ * @brief Initialize and fill the LoRa telemetry frame
+ *
+ * @note The pressure is sent in 0.01 bar, the protobuf field is an integer.
+ */
+void telemetry_fill_lora_frame(const tanwa_data_t *data, LoRaFrame *frame);
+
+#endif /* PWRINSPACE_TELEMETRY_FRAMES_H_ */
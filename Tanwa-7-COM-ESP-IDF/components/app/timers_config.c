@@ -5,21 +5,36 @@
 
 #include "TANWA_config.h"
 #include "TANWA_data.h"
+#include "tanwa_log_format.h"
 
 #include "mcu_gpio_config.h"
 #include "state_machine_config.h"
 
 #include "sd_task.h"
+#include "sd_rate.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #include "esp_log.h"
 
 #define TAG "TIMERS"
 
+#define TEMPERATURE_TASK_STACK_SIZE 2048
+#define TEMPERATURE_TASK_PRIORITY 2
+#define TEMPERATURE_TASK_CORE 0
+
+static TaskHandle_t temperature_task_handle = NULL;
+
 void on_sd_timer(void *arg){
-    tanwa_data_t tanwa_data = tanwa_data_read();
-    if (SDT_send_data(&tanwa_data, sizeof(tanwa_data)) == false) {
+    tanwa_log_sample_t sample = {
+        .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .data = tanwa_data_read(),
+    };
+    if (SDT_send_data(&sample, sizeof(sample)) == false) {
         ESP_LOGE(TAG, "Error while sending data to sd card");
     }
+    sd_rate_on_timer();
 }
 
 void on_buzzer_timer(void *arg){
@@ -37,6 +52,30 @@ void on_buzzer_timer(void *arg){
     }
 }
 
+void on_temperature_timer(void *arg){
+    // the conversion and the read block on the I2C bus, keep them out of the timer task
+    if (temperature_task_handle != NULL) {
+        xTaskNotifyGive(temperature_task_handle);
+    }
+}
+
+static void temperature_task(void *arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        temperature_driver_status_t ret;
+        ret = temperature_driver_start_conversion(&TANWA_utility.temperature_driver);
+        if (ret != TEMPERATURE_DRIVER_OK) {
+            ESP_LOGE(TAG, "Failed to start temperature conversion: %d", ret);
+            continue;
+        }
+        uint32_t conv_time_ms = temperature_driver_get_conv_time_ms(&TANWA_utility.temperature_driver);
+        vTaskDelay(pdMS_TO_TICKS(conv_time_ms) + 1);
+        if (temperature_driver_read_conversion(&TANWA_utility.temperature_driver) != TEMPERATURE_DRIVER_OK) {
+            ESP_LOGE(TAG, "Failed to read temperature");
+        }
+    }
+}
+
 void on_abort_button_timer(void *arg){
     // Check the state of the button pin
     uint8_t level;
@@ -54,8 +93,16 @@ bool initialize_timers(void) {
     sys_timer_t timers[] = {
     {.timer_id = TIMER_SD_DATA, .timer_callback_fnc = on_sd_timer, .timer_arg = NULL},
     {.timer_id = TIMER_BUZZER, .timer_callback_fnc = on_buzzer_timer, .timer_arg = NULL},
-    {.timer_id = TIMER_ABORT_BUTTON, .timer_callback_fnc = on_abort_button_timer, .timer_arg = NULL}
+    {.timer_id = TIMER_ABORT_BUTTON, .timer_callback_fnc = on_abort_button_timer, .timer_arg = NULL},
+    {.timer_id = TIMER_TEMPERATURE, .timer_callback_fnc = on_temperature_timer, .timer_arg = NULL}
     };
+    if (temperature_task_handle == NULL &&
+        xTaskCreatePinnedToCore(temperature_task, "temperature_task", TEMPERATURE_TASK_STACK_SIZE, NULL,
+                                TEMPERATURE_TASK_PRIORITY, &temperature_task_handle,
+                                TEMPERATURE_TASK_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create temperature task");
+        return false;
+    }
     return sys_timer_init(timers, sizeof(timers) / sizeof(timers[0]));
 }
 
@@ -73,4 +120,23 @@ bool buzzer_timer_change_period(uint32_t period_ms) {
 
 bool abort_button_timer_start_once(uint32_t period_ms) {
     return sys_timer_start(TIMER_ABORT_BUTTON, period_ms, TIMER_TYPE_ONE_SHOT);
+}
+
+bool temperature_timer_start(uint32_t period_ms) {
+    uint32_t conv_time_ms = temperature_driver_get_conv_time_ms(&TANWA_utility.temperature_driver);
+    // the next conversion must not start before the task read the previous one
+    uint32_t min_period_ms = conv_time_ms + TEMPERATURE_TIMER_MARGIN_MS;
+    if (period_ms < min_period_ms) {
+        ESP_LOGW(TAG, "Temperature period %d ms shorter than conversion, using %d ms", period_ms, min_period_ms);
+        period_ms = min_period_ms;
+    }
+    return sys_timer_start(TIMER_TEMPERATURE, period_ms, TIMER_TYPE_PERIODIC);
+}
+
+bool temperature_timer_change_period(uint32_t period_ms) {
+    if (!sys_timer_stop(TIMER_TEMPERATURE)) {
+        ESP_LOGE(TAG, "Failed to stop temperature timer");
+        return false;
+    }
+    return temperature_timer_start(period_ms);
 }
\ No newline at end of file
@@ -9,8 +9,12 @@ typedef enum {
     TIMER_SD_DATA = 0,
     TIMER_BUZZER = 1,
     TIMER_ABORT_BUTTON = 2,
+    TIMER_TEMPERATURE = 3,
 } timers_id_def;
 
+#define TEMPERATURE_TIMER_DEFAULT_PERIOD_MS 1000
+#define TEMPERATURE_TIMER_MARGIN_MS 20  // bus queueing and the read after the conversion time
+
 /**
  * @brief Initialize timers
  * 
@@ -25,4 +29,17 @@ bool buzzer_timer_change_period(uint32_t period_ms);
 
 bool abort_button_timer_start_once(uint32_t period_ms);
 
+/**
+ * @brief Start the temperature acquisition, the timer wakes the temperature task every period,
+ *        the task starts the conversions and reads them after the conversion time
+ *
+ * @param period_ms period of the temperature acquisition, at least the conversion time
+ *                  and TEMPERATURE_TIMER_MARGIN_MS
+ * @return true :D
+ * @return false :C
+ */
+bool temperature_timer_start(uint32_t period_ms);
+
+bool temperature_timer_change_period(uint32_t period_ms);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,330 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "calibration.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_log.h"
+
+#define TAG "CALIBRATION"
+
+#define Q_ONE ((double)(1LL << CALIBRATION_FRAC_BITS))
+#define Q_TO_FLOAT (1.0f / (float)(1LL << CALIBRATION_FRAC_BITS))
+// |gain * raw| and |offset| have to fit in int64 after scaling
+#define GAIN_LIMIT ((double)(1LL << (62 - CALIBRATION_FRAC_BITS - 16)))
+#define OFFSET_LIMIT ((double)(1LL << (62 - CALIBRATION_FRAC_BITS)))
+
+static calibration_status_t set_segment(calibration_channel_t *channel, uint8_t segment, int32_t breakpoint, double gain, double offset) {
+    if (fabs(gain) >= GAIN_LIMIT || fabs(offset) >= OFFSET_LIMIT) {
+        return CALIBRATION_INVALID_ARG;
+    }
+    channel->breakpoint[segment] = breakpoint;
+    channel->gain_q[segment] = llround(gain * Q_ONE);
+    channel->offset_q[segment] = llround(offset * Q_ONE);
+    return CALIBRATION_OK;
+}
+
+static calibration_status_t compute_linear(const calibration_table_t *table, calibration_channel_t *channel) {
+    if (table->point_count < 2) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    // least squares fit
+    double n = table->point_count;
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (uint8_t i = 0; i < table->point_count; ++i) {
+        sx += table->raw[i];
+        sy += table->value[i];
+        sxx += (double)table->raw[i] * table->raw[i];
+        sxy += (double)table->raw[i] * table->value[i];
+    }
+    double denom = n * sxx - sx * sx;
+    if (denom == 0.0) {
+        return CALIBRATION_INVALID_ARG;
+    }
+    double gain = (n * sxy - sx * sy) / denom;
+    double offset = (sy - gain * sx) / n;
+
+    channel->segment_count = 1;
+    return set_segment(channel, 0, INT32_MIN, gain, offset);
+}
+
+static calibration_status_t compute_polynomial(const calibration_table_t *table, calibration_channel_t *channel) {
+    uint8_t order = table->poly_order;
+    if (order < 1 || order > CALIBRATION_MAX_POLY_ORDER || table->point_count < order + 1) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    // fit on the normalized raw value to keep the normal equations well conditioned
+    double scale = 1.0;
+    for (uint8_t i = 0; i < table->point_count; ++i) {
+        if (fabs((double)table->raw[i]) > scale) {
+            scale = fabs((double)table->raw[i]);
+        }
+    }
+
+    const uint8_t size = order + 1;
+    double a[CALIBRATION_MAX_POLY_ORDER + 1][CALIBRATION_MAX_POLY_ORDER + 2] = {0};
+    for (uint8_t p = 0; p < table->point_count; ++p) {
+        double t = table->raw[p] / scale;
+        double t_pow[2 * CALIBRATION_MAX_POLY_ORDER + 1];
+        t_pow[0] = 1.0;
+        for (uint8_t k = 1; k <= 2 * order; ++k) {
+            t_pow[k] = t_pow[k - 1] * t;
+        }
+        for (uint8_t row = 0; row < size; ++row) {
+            for (uint8_t col = 0; col < size; ++col) {
+                a[row][col] += t_pow[row + col];
+            }
+            a[row][size] += t_pow[row] * table->value[p];
+        }
+    }
+
+    // gaussian elimination with partial pivoting
+    for (uint8_t col = 0; col < size; ++col) {
+        uint8_t pivot = col;
+        for (uint8_t row = col + 1; row < size; ++row) {
+            if (fabs(a[row][col]) > fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (fabs(a[pivot][col]) < 1e-12) {
+            return CALIBRATION_INVALID_ARG;
+        }
+        if (pivot != col) {
+            for (uint8_t k = 0; k <= size; ++k) {
+                double tmp = a[col][k];
+                a[col][k] = a[pivot][k];
+                a[pivot][k] = tmp;
+            }
+        }
+        for (uint8_t row = 0; row < size; ++row) {
+            if (row == col) {
+                continue;
+            }
+            double factor = a[row][col] / a[col][col];
+            for (uint8_t k = col; k <= size; ++k) {
+                a[row][k] -= factor * a[col][k];
+            }
+        }
+    }
+
+    memset(channel->poly, 0, sizeof(channel->poly));
+    double scale_pow = 1.0;
+    for (uint8_t i = 0; i < size; ++i) {
+        channel->poly[i] = (float)(a[i][size] / a[i][i] / scale_pow);
+        scale_pow *= scale;
+    }
+    channel->segment_count = 0;
+    return CALIBRATION_OK;
+}
+
+static calibration_status_t compute_piecewise(const calibration_table_t *table, calibration_channel_t *channel) {
+    if (table->point_count < 2) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    // sort the points by the raw value
+    int32_t raw[CALIBRATION_MAX_POINTS];
+    float value[CALIBRATION_MAX_POINTS];
+    memcpy(raw, table->raw, sizeof(raw));
+    memcpy(value, table->value, sizeof(value));
+    for (uint8_t i = 1; i < table->point_count; ++i) {
+        for (uint8_t j = i; j > 0 && raw[j - 1] > raw[j]; --j) {
+            int32_t tmp_raw = raw[j];
+            raw[j] = raw[j - 1];
+            raw[j - 1] = tmp_raw;
+            float tmp_value = value[j];
+            value[j] = value[j - 1];
+            value[j - 1] = tmp_value;
+        }
+    }
+
+    for (uint8_t i = 0; i + 1 < table->point_count; ++i) {
+        if (raw[i + 1] == raw[i]) {
+            return CALIBRATION_INVALID_ARG;
+        }
+        double gain = ((double)value[i + 1] - value[i]) / ((double)raw[i + 1] - raw[i]);
+        double offset = value[i] - gain * raw[i];
+        if (set_segment(channel, i, raw[i], gain, offset) != CALIBRATION_OK) {
+            return CALIBRATION_INVALID_ARG;
+        }
+    }
+    channel->segment_count = table->point_count - 1;
+    return CALIBRATION_OK;
+}
+
+calibration_status_t calibration_compute(const calibration_table_t *table, calibration_channel_t *channel) {
+    if (table == NULL || channel == NULL || table->point_count > CALIBRATION_MAX_POINTS) {
+        return CALIBRATION_INVALID_ARG;
+    }
+    for (uint8_t i = 0; i < table->point_count; ++i) {
+        if (table->raw[i] <= -CALIBRATION_RAW_LIMIT || table->raw[i] >= CALIBRATION_RAW_LIMIT) {
+            return CALIBRATION_INVALID_ARG;
+        }
+    }
+
+    calibration_channel_t computed = {0};
+    calibration_status_t ret;
+    switch (table->type) {
+        case CALIBRATION_TYPE_LINEAR:
+            ret = compute_linear(table, &computed);
+            break;
+        case CALIBRATION_TYPE_POLYNOMIAL:
+            ret = compute_polynomial(table, &computed);
+            break;
+        case CALIBRATION_TYPE_PIECEWISE:
+            ret = compute_piecewise(table, &computed);
+            break;
+        default:
+            return CALIBRATION_INVALID_ARG;
+    }
+    if (ret != CALIBRATION_OK) {
+        return ret;
+    }
+
+    computed.type = (calibration_type_t)table->type;
+    memcpy(channel, &computed, sizeof(calibration_channel_t));
+    return CALIBRATION_OK;
+}
+
+calibration_status_t calibration_set_linear(calibration_channel_t *channel, float gain, float offset) {
+    if (channel == NULL) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    calibration_channel_t computed = {0};
+    if (set_segment(&computed, 0, INT32_MIN, gain, offset) != CALIBRATION_OK) {
+        return CALIBRATION_INVALID_ARG;
+    }
+    computed.type = CALIBRATION_TYPE_LINEAR;
+    computed.segment_count = 1;
+    memcpy(channel, &computed, sizeof(calibration_channel_t));
+    return CALIBRATION_OK;
+}
+
+calibration_status_t calibration_apply(const calibration_channel_t *channel, int32_t raw, float *value) {
+    if (channel == NULL || value == NULL) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    switch (channel->type) {
+        case CALIBRATION_TYPE_LINEAR:
+        case CALIBRATION_TYPE_PIECEWISE: {
+            uint8_t segment = 0;
+            while (segment + 1 < channel->segment_count && raw >= channel->breakpoint[segment + 1]) {
+                segment++;
+            }
+            int64_t acc = channel->gain_q[segment] * raw + channel->offset_q[segment];
+            *value = (float)acc * Q_TO_FLOAT;
+            return CALIBRATION_OK;
+        }
+        case CALIBRATION_TYPE_POLYNOMIAL: {
+            float x = (float)raw;
+            float acc = channel->poly[CALIBRATION_MAX_POLY_ORDER];
+            for (int i = CALIBRATION_MAX_POLY_ORDER - 1; i >= 0; --i) {
+                acc = acc * x + channel->poly[i];
+            }
+            *value = acc;
+            return CALIBRATION_OK;
+        }
+        default:
+            return CALIBRATION_FAIL;
+    }
+}
+
+bool calibration_is_valid(const calibration_channel_t *channel) {
+    return channel != NULL && channel->type != CALIBRATION_TYPE_NONE;
+}
+
+calibration_status_t calibration_load(const char *key, calibration_channel_t *channel, calibration_table_t *table) {
+    if (key == NULL || channel == NULL) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return CALIBRATION_NOT_FOUND;
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return CALIBRATION_NVS_ERR;
+    }
+
+    calibration_table_t loaded;
+    size_t size = sizeof(loaded);
+    err = nvs_get_blob(handle, key, &loaded, &size);
+    nvs_close(handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return CALIBRATION_NOT_FOUND;
+    } else if (err != ESP_OK || size != sizeof(loaded) || loaded.version != CALIBRATION_TABLE_VERSION) {
+        ESP_LOGE(TAG, "Invalid calibration table %s", key);
+        return CALIBRATION_NVS_ERR;
+    }
+
+    calibration_status_t ret = calibration_compute(&loaded, channel);
+    if (ret != CALIBRATION_OK) {
+        ESP_LOGE(TAG, "Calibration table %s can not be applied", key);
+        return ret;
+    }
+    if (table != NULL) {
+        memcpy(table, &loaded, sizeof(loaded));
+    }
+    return CALIBRATION_OK;
+}
+
+calibration_status_t calibration_save(const char *key, const calibration_table_t *table) {
+    if (key == NULL || table == NULL) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    calibration_table_t stored;
+    memcpy(&stored, table, sizeof(stored));
+    stored.version = CALIBRATION_TABLE_VERSION;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(err));
+        return CALIBRATION_NVS_ERR;
+    }
+    err = nvs_set_blob(handle, key, &stored, sizeof(stored));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Saving calibration table %s failed: %s", key, esp_err_to_name(err));
+        return CALIBRATION_NVS_ERR;
+    }
+    return CALIBRATION_OK;
+}
+
+calibration_status_t calibration_erase(const char *key) {
+    if (key == NULL) {
+        return CALIBRATION_INVALID_ARG;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CALIBRATION_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return CALIBRATION_NVS_ERR;
+    }
+    err = nvs_erase_key(handle, key);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return CALIBRATION_NOT_FOUND;
+    }
+    return err == ESP_OK ? CALIBRATION_OK : CALIBRATION_NVS_ERR;
+}
@@ -0,0 +1,114 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the sensor calibration utility. A calibration table maps
+/// raw ADC counts to the physical value with a linear, polynomial or piecewise-linear function.
+/// The tables are stored in NVS, the coefficients are precomputed when a table is loaded so
+/// applying the calibration to a sample needs only multiplications and additions.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_CALIBRATION_H_
+#define PWRINSPACE_CALIBRATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CALIBRATION_MAX_POINTS 8
+#define CALIBRATION_MAX_POLY_ORDER 3
+#define CALIBRATION_TABLE_VERSION 1
+
+// linear segments are evaluated in Q40.24 fixed point, raw values have to fit in +-2^16
+#define CALIBRATION_FRAC_BITS 24
+#define CALIBRATION_RAW_LIMIT 65536
+
+#define CALIBRATION_NVS_NAMESPACE "calib"
+
+typedef enum {
+    CALIBRATION_TYPE_NONE = 0,
+    CALIBRATION_TYPE_LINEAR,
+    CALIBRATION_TYPE_POLYNOMIAL,
+    CALIBRATION_TYPE_PIECEWISE,
+} calibration_type_t;
+
+typedef enum {
+    CALIBRATION_OK = 0,
+    CALIBRATION_FAIL,
+    CALIBRATION_INVALID_ARG,
+    CALIBRATION_NOT_FOUND,
+    CALIBRATION_NVS_ERR,
+} calibration_status_t;
+
+/**
+ * @brief Calibration table as stored in NVS
+ *
+ * @note raw[i] is the raw ADC value measured for the reference value[i]
+ */
+typedef struct {
+    uint8_t version;
+    uint8_t type;
+    uint8_t point_count;
+    uint8_t poly_order;
+    int32_t raw[CALIBRATION_MAX_POINTS];
+    float value[CALIBRATION_MAX_POINTS];
+} calibration_table_t;
+
+/**
+ * @brief Calibration ready to be applied to samples
+ *
+ * @note For the linear and piecewise-linear types segment i covers raw values from
+ *       breakpoint[i] up to breakpoint[i + 1], the first and the last segment are extrapolated.
+ */
+typedef struct {
+    calibration_type_t type;
+    uint8_t segment_count;
+    int32_t breakpoint[CALIBRATION_MAX_POINTS];
+    int64_t gain_q[CALIBRATION_MAX_POINTS];
+    int64_t offset_q[CALIBRATION_MAX_POINTS];
+    float poly[CALIBRATION_MAX_POLY_ORDER + 1];
+} calibration_channel_t;
+
+/**
+ * @brief Fit the table and precompute the coefficients of the channel
+ *
+ * @param table calibration points and requested type
+ * @param[out] channel calibration ready to be applied
+ * @return `calibration_status_t`
+ * @retval `CALIBRATION_OK` on success
+ * @retval `CALIBRATION_INVALID_ARG` if the points can not be fitted
+ */
+calibration_status_t calibration_compute(const calibration_table_t *table, calibration_channel_t *channel);
+
+/**
+ * @brief Set the channel to a single linear function, value = gain * raw + offset
+ */
+calibration_status_t calibration_set_linear(calibration_channel_t *channel, float gain, float offset);
+
+/**
+ * @brief Convert the raw value with the calibration of the channel
+ *
+ * @note Does not divide, safe to call for every sample.
+ */
+calibration_status_t calibration_apply(const calibration_channel_t *channel, int32_t raw, float *value);
+
+bool calibration_is_valid(const calibration_channel_t *channel);
+
+/**
+ * @brief Load the table from NVS and precompute the coefficients
+ *
+ * @param key NVS key of the table, at most 15 characters
+ * @param[out] channel calibration ready to be applied
+ * @param[out] table loaded table, can be NULL
+ * @retval `CALIBRATION_NOT_FOUND` if there is no table stored under the key
+ */
+calibration_status_t calibration_load(const char *key, calibration_channel_t *channel, calibration_table_t *table);
+
+calibration_status_t calibration_save(const char *key, const calibration_table_t *table);
+
+calibration_status_t calibration_erase(const char *key);
+
+#endif /* PWRINSPACE_CALIBRATION_H_ */
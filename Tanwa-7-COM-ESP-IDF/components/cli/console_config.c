@@ -6,18 +6,27 @@
 ///===-----------------------------------------------------------------------------------------===//
 #include "console_config.h"
 
+#include <string.h>
+
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 
 #include "console.h"
 
 #include "TANWA_config.h"
 #include "TANWA_data.h"
 #include "mcu_adc_config.h"
+#include "mcu_i2c_config.h"
 #include "mcu_twai_config.h"
 #include "state_machine_config.h"
 
+#include "log_capture.h"
+#include "lora_task.h"
 #include "measure_task.h"
+#include "sd_task.h"
+#include "sd_rate.h"
+#include "timers_config.h"
 
 #define TAG "CONSOLE_CONFIG"
 
@@ -734,6 +743,20 @@ static int change_measure_period(int argc, char **argv) {
     return 0;
 }
 
+static int change_temperature_period(int argc, char **argv) {
+    if (argc < 2) {
+        return -1;
+    }
+
+    uint32_t period = atoi(argv[1]);
+    if (!temperature_timer_change_period(period)) {
+        CONSOLE_WRITE_E("Failed to change temperature period");
+        return -1;
+    }
+
+    return 0;
+}
+
 int get_tanwa_data(int argc, char **argv) {
     tanwa_data_t tanwa_data = tanwa_data_read();
     CONSOLE_WRITE("TANWA Data:");
@@ -838,6 +861,341 @@ static int connected_slaves(int argc, char **argv) {
     return 0;
 }
 
+static int sd_frame_bench(int argc, char **argv) {
+    uint32_t iterations = 1000;
+    if (argc >= 2) {
+        iterations = atoi(argv[1]);
+    }
+
+    sd_frame_benchmark_t result;
+    if (sd_frame_benchmark(iterations, &result) == false) {
+        CONSOLE_WRITE_E("SD frame benchmark failed");
+        return -1;
+    }
+    CONSOLE_WRITE("SD frame benchmark, %u records:", result.iterations);
+    CONSOLE_WRITE("  csv:    %.2f us/record, %u bytes/record", result.csv_us_per_record, result.csv_bytes_per_record);
+    CONSOLE_WRITE("  binary: %.2f us/record, %u bytes/record", result.binary_us_per_record, result.binary_bytes_per_record);
+    return 0;
+}
+
+static void print_latency(const char *name, const latency_hist_t *hist) {
+    CONSOLE_WRITE("  %-10s n %u, avg %.0f us, p50 < %u us, p90 < %u us, p99 < %u us, p99.9 < %u us, max %u us",
+                  name, hist->count, latency_hist_average(hist), latency_hist_percentile(hist, 50.0f),
+                  latency_hist_percentile(hist, 90.0f), latency_hist_percentile(hist, 99.0f),
+                  latency_hist_percentile(hist, 99.9f), hist->max_us);
+}
+
+static int sd_bench(int argc, char **argv) {
+    sd_bench_cfg_t cfg;
+    sd_bench_default_config(&cfg, SD_MOUNT_POINT);
+    if (argc >= 2) {
+        cfg.file_size = atoi(argv[1]) * 1024;
+    }
+
+    sd_bench_result_t *result = malloc(sizeof(sd_bench_result_t));
+    if (result == NULL) {
+        CONSOLE_WRITE_E("No memory for the benchmark result");
+        return -1;
+    }
+
+    CONSOLE_WRITE("SD benchmark, %u kB per pass, data saving paused...", cfg.file_size / 1024);
+    if (SDT_run_benchmark(&cfg, result) == false) {
+        CONSOLE_WRITE_E("SD benchmark failed");
+        free(result);
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < result->write_count; ++i) {
+        const sd_bench_write_t *write = &result->write[i];
+        CONSOLE_WRITE("  %5u B: sequential %.1f kB/s, p99 < %u us, max %u us; random %.1f kB/s, p99 < %u us, max %u us",
+                      write->buffer_size, write->sequential_kbps, latency_hist_percentile(&write->sequential, 99.0f),
+                      write->sequential.max_us, write->random_kbps, latency_hist_percentile(&write->random, 99.0f),
+                      write->random.max_us);
+    }
+    print_latency("open+close", &result->open_close);
+    print_latency("sync", &result->sync);
+    free(result);
+    return 0;
+}
+
+static int sd_stats(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+        SDT_reset_stats();
+        CONSOLE_WRITE("SD statistics cleared");
+        return 0;
+    }
+
+    sd_task_stats_t stats;
+    SDT_get_stats(&stats);
+    int64_t elapsed_us = esp_timer_get_time() - stats.since_us;
+    float sustained_kbps = elapsed_us > 0 ? (float)stats.bytes_written * 1000.0f / elapsed_us : 0.0f;
+    float write_kbps = stats.write.total_us > 0 ? (float)stats.bytes_written * 1000.0f / stats.write.total_us : 0.0f;
+    CONSOLE_WRITE("SD write statistics:");
+    CONSOLE_WRITE("  written %llu B in %u writes, %u syncs, %u errors",
+                  stats.bytes_written, stats.write.count, stats.sync.count, stats.error_count);
+    CONSOLE_WRITE("  sustained %.2f kB/s, during writes %.2f kB/s", sustained_kbps, write_kbps);
+    print_latency("queue wait", &stats.queue_wait);
+    print_latency("serialize", &stats.serialize);
+    print_latency("write", &stats.write);
+    print_latency("sync", &stats.sync);
+    CONSOLE_WRITE("  rotated segments %u", stats.segment_count);
+    if (stats.compress_records > 0) {
+        float ratio = stats.compress_bytes_out > 0 ? (float)stats.compress_bytes_in / stats.compress_bytes_out : 0.0f;
+        CONSOLE_WRITE("  compression: %llu B -> %llu B, ratio %.2f, %.1f us per record",
+                      stats.compress_bytes_in, stats.compress_bytes_out, ratio,
+                      (float)stats.compress_us / stats.compress_records);
+    }
+    CONSOLE_WRITE("  spill buffer: spilled %u, lost %u, used %u/%u records, max used %u",
+                  stats.spill.spilled, stats.spill.lost, stats.spill.count, stats.spill.capacity,
+                  stats.spill.max_count);
+    CONSOLE_WRITE("  samples: produced %u, queued %u, decimated %u, dropped %u, written %u",
+                  stats.samples.produced, stats.samples.queued, stats.samples.decimated,
+                  stats.samples.dropped, stats.samples.written);
+    CONSOLE_WRITE("  backpressure %s, decimation 1/%u", backpressure_policy_name(stats.policy),
+                  1u << stats.decimation);
+    if (stats.recent_blocks > 0 || stats.summaries > 0) {
+        CONSOLE_WRITE("  two-tier: recent blocks %u, summaries %u, frozen blocks %u",
+                      stats.recent_blocks, stats.summaries, stats.frozen_blocks);
+    }
+
+    log_ring_stats_t log_stats;
+    if (SDT_get_log_stats(&log_stats) == true) {
+        CONSOLE_WRITE("  log ring: pushed %u, dropped %u (%u B), used %u/%u B, max used %u B",
+                      log_stats.pushed, log_stats.dropped, log_stats.dropped_bytes,
+                      log_stats.used, log_stats.size, log_stats.max_used);
+    }
+    return 0;
+}
+
+static int sd_rate(int argc, char **argv) {
+    if (argc == 3) {
+        if (sd_rate_set_period(atoi(argv[1]), strtoul(argv[2], NULL, 10)) == false) {
+            CONSOLE_WRITE_E("Invalid state or period, %u - %u ms", SD_RATE_MIN_PERIOD_MS, SD_RATE_MAX_PERIOD_MS);
+            return -1;
+        }
+        return 0;
+    }
+
+    char text[32];
+    CONSOLE_WRITE("SD data period %u ms", sd_rate_get_current_period());
+    for (uint8_t state = 0; state < SD_RATE_STATE_COUNT; ++state) {
+        get_state_text(state, text);
+        CONSOLE_WRITE("  %u %s: %u ms", state, text, sd_rate_get_period(state));
+    }
+    return 0;
+}
+
+static int sd_policy(int argc, char **argv) {
+    if (argc < 2) {
+        sd_task_stats_t stats;
+        SDT_get_stats(&stats);
+        CONSOLE_WRITE("Backpressure policy %s, decimation 1/%u", backpressure_policy_name(stats.policy),
+                      1u << stats.decimation);
+        return 0;
+    }
+
+    backpressure_policy_t policy = backpressure_policy_from_name(argv[1]);
+    if (policy == BACKPRESSURE_POLICY_COUNT) {
+        CONSOLE_WRITE_E("Unknown policy %s", argv[1]);
+        return -1;
+    }
+    SDT_set_backpressure_policy(policy);
+    return 0;
+}
+
+static int sd_freeze(int argc, char **argv) {
+    if (SDT_freeze_recent() == false) {
+        CONSOLE_WRITE_E("Two-tier logging is disabled");
+        return -1;
+    }
+
+    CONSOLE_WRITE("Freezing the recent data, check sd-stats for the copied blocks");
+    return 0;
+}
+
+static int lora_stats(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+        lora_task_reset_stats();
+        CONSOLE_WRITE("LoRa statistics cleared");
+        return 0;
+    }
+
+    lora_task_stats_t stats;
+    lora_task_get_stats(&stats);
+    int64_t elapsed_us = esp_timer_get_time() - stats.since_us;
+    float tx_duty = elapsed_us > 0 ? 100.0f * stats.tx_us / elapsed_us : 0.0f;
+    float rx_duty = elapsed_us > 0 ? 100.0f * stats.rx_us / elapsed_us : 0.0f;
+    CONSOLE_WRITE("LoRa link statistics:");
+    CONSOLE_WRITE("  tx %u packets, %u B, %u errors (%u timeouts), %u skipped, %u deferred",
+                  stats.tx_count, stats.tx_bytes, stats.tx_errors, stats.tx_timeouts, stats.tx_skipped,
+                  stats.tx_deferred);
+    CONSOLE_WRITE("  rx %u packets, decode arena max used %u B, %u failed allocations", stats.rx_count,
+                  stats.arena_max_used, stats.arena_failures);
+    print_latency("fifo write", &stats.fifo_write);
+    print_latency("airtime", &stats.airtime);
+    CONSOLE_WRITE("  tx duty cycle %.2f %%, rx availability %.2f %%", tx_duty, rx_duty);
+    if (stats.telemetry_frames > 0) {
+        uint32_t frames = stats.telemetry_frames;
+        CONSOLE_WRITE("  telemetry %u frames (%u delta), avg %.1f B, %.2f ms on air", frames, stats.telemetry_delta,
+                      (float)stats.telemetry_bytes / frames, stats.telemetry_time_on_air_us / 1000.0f / frames);
+        CONSOLE_WRITE("  as protobuf avg %.1f B, %.2f ms on air", (float)stats.telemetry_protobuf_bytes / frames,
+                      stats.telemetry_protobuf_time_on_air_us / 1000.0f / frames);
+    }
+    return 0;
+}
+
+static int log_sd(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "uart") == 0) {
+        log_capture_set_uart_output(atoi(argv[2]) != 0);
+        return 0;
+    }
+
+    if (argc == 3) {
+        int level = atoi(argv[2]);
+        if (level < ESP_LOG_NONE || level > ESP_LOG_VERBOSE) {
+            CONSOLE_WRITE_E("Invalid level %d", level);
+            return -1;
+        }
+        if (log_capture_set_level(argv[1], (esp_log_level_t)level) != ESP_OK) {
+            CONSOLE_WRITE_E("Unable to set level of %s", argv[1]);
+            return -1;
+        }
+        return 0;
+    }
+
+    log_capture_stats_t stats;
+    log_capture_get_stats(&stats);
+    CONSOLE_WRITE("Log capture: captured %u, filtered %u, dropped %u, uart %s",
+                  stats.captured, stats.filtered, stats.dropped,
+                  log_capture_get_uart_output() == true ? "on" : "off");
+    return 0;
+}
+
+static int i2c_stats(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0) {
+        mcu_i2c_reset_stats();
+        CONSOLE_WRITE("I2C statistics cleared");
+        return 0;
+    }
+
+    mcu_i2c_bus_stats_t stats;
+    mcu_i2c_get_stats(&stats);
+    CONSOLE_WRITE("I2C bus statistics:");
+    for (uint8_t i = 0; i < MCU_I2C_DEVICE_COUNT; ++i) {
+        mcu_i2c_device_stats_t *dev = &stats.devices[i];
+        uint32_t avg_latency_us = dev->transactions > 0 ? (uint32_t)(dev->total_latency_us / dev->transactions) : 0;
+        CONSOLE_WRITE("  %s: trans %u, err %u, avg %u us, max %u us, max wait %u us",
+                      mcu_i2c_get_device_name(i), dev->transactions, dev->errors,
+                      avg_latency_us, dev->max_latency_us, dev->max_queue_wait_us);
+    }
+    CONSOLE_WRITE("  batches %u, max batch %u, queue full %u",
+                  stats.batches, stats.max_batch_size, stats.queue_full);
+    return 0;
+}
+
+static calibration_table_t calib_pending[TANWA_CALIBRATION_COUNT];
+
+static bool parse_calib_channel(const char *name, TANWA_calibration_channel_t *channel) {
+    for (int i = 0; i < TANWA_CALIBRATION_COUNT; ++i) {
+        if (strcmp(name, TANWA_calibration_get_name(i)) == 0) {
+            *channel = i;
+            return true;
+        }
+    }
+    CONSOLE_WRITE_E("Unknown channel %s, use pressure_1..4 or vbat", name);
+    return false;
+}
+
+static int calib_point(int argc, char **argv) {
+    TANWA_calibration_channel_t channel;
+    if (argc < 3 || !parse_calib_channel(argv[1], &channel)) {
+        return -1;
+    }
+    calibration_table_t *table = &calib_pending[channel];
+    if (table->point_count >= CALIBRATION_MAX_POINTS) {
+        CONSOLE_WRITE_E("Too many calibration points");
+        return -1;
+    }
+
+    int32_t raw;
+    if (TANWA_calibration_read_raw(channel, &raw) != ESP_OK) {
+        CONSOLE_WRITE_E("Failed to read %s", argv[1]);
+        return -1;
+    }
+    table->raw[table->point_count] = raw;
+    table->value[table->point_count] = atof(argv[2]);
+    table->point_count++;
+    CONSOLE_WRITE("%s point #%d => raw: %d, value: %f", argv[1], table->point_count, raw, atof(argv[2]));
+    return 0;
+}
+
+static int calib_commit(int argc, char **argv) {
+    TANWA_calibration_channel_t channel;
+    if (argc < 3 || !parse_calib_channel(argv[1], &channel)) {
+        return -1;
+    }
+    calibration_table_t *table = &calib_pending[channel];
+    if (strcmp(argv[2], "linear") == 0) {
+        table->type = CALIBRATION_TYPE_LINEAR;
+    } else if (strcmp(argv[2], "poly") == 0) {
+        table->type = CALIBRATION_TYPE_POLYNOMIAL;
+        table->poly_order = argc >= 4 ? atoi(argv[3]) : 2;
+    } else if (strcmp(argv[2], "piecewise") == 0) {
+        table->type = CALIBRATION_TYPE_PIECEWISE;
+    } else {
+        CONSOLE_WRITE_E("Unknown type %s, use linear|poly|piecewise", argv[2]);
+        return -1;
+    }
+
+    if (TANWA_calibration_commit(channel, table) != ESP_OK) {
+        CONSOLE_WRITE_E("Failed to commit %s calibration", argv[1]);
+        return -1;
+    }
+    memset(table, 0, sizeof(calibration_table_t));
+    CONSOLE_WRITE("Calibration %s committed", argv[1]);
+    return 0;
+}
+
+static int calib_show(int argc, char **argv) {
+    TANWA_calibration_channel_t channel;
+    if (argc < 2 || !parse_calib_channel(argv[1], &channel)) {
+        return -1;
+    }
+    calibration_table_t table;
+    esp_err_t ret = TANWA_calibration_get_table(channel, &table);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        CONSOLE_WRITE("%s: default calibration", argv[1]);
+    } else if (ret != ESP_OK) {
+        CONSOLE_WRITE_E("Failed to read %s calibration", argv[1]);
+        return -1;
+    } else {
+        CONSOLE_WRITE("%s: type %d, order %d, points %d", argv[1], table.type, table.poly_order, table.point_count);
+        for (int i = 0; i < table.point_count; ++i) {
+            CONSOLE_WRITE("  #%d => raw: %d, value: %f", i + 1, table.raw[i], table.value[i]);
+        }
+    }
+    CONSOLE_WRITE("pending points: %d", calib_pending[channel].point_count);
+    return 0;
+}
+
+static int calib_clear(int argc, char **argv) {
+    TANWA_calibration_channel_t channel;
+    if (argc < 2 || !parse_calib_channel(argv[1], &channel)) {
+        return -1;
+    }
+    memset(&calib_pending[channel], 0, sizeof(calibration_table_t));
+    if (argc >= 3 && strcmp(argv[2], "points") == 0) {
+        CONSOLE_WRITE("Pending %s points cleared", argv[1]);
+        return 0;
+    }
+    if (TANWA_calibration_clear(channel) != ESP_OK) {
+        CONSOLE_WRITE_E("Failed to clear %s calibration", argv[1]);
+        return -1;
+    }
+    CONSOLE_WRITE("Calibration %s cleared", argv[1]);
+    return 0;
+}
+
 static esp_console_cmd_t cmd[] = {
     // system commands
     {"reset-dev", "restart device", NULL, reset_device, NULL},
@@ -884,6 +1242,7 @@ static esp_console_cmd_t cmd[] = {
     {"termo-set-min", "set termo min pressure", "min_pressure", termo_set_min_pressure, NULL},
     // measument task commands
     {"measure-period", "change measurement period", "period", change_measure_period, NULL},
+    {"temp-period", "change temperature acquisition period", "period", change_temperature_period, NULL},
     // tanwa data commands
     {"tanwa-data", "get tanwa data", NULL, get_tanwa_data, NULL},
     {"com-data", "get com data", NULL, get_com_board_data, NULL},
@@ -892,6 +1251,23 @@ static esp_console_cmd_t cmd[] = {
     {"flc-data", "get flc data", NULL, get_flc_data, NULL},
     {"termo-data", "get termo data", NULL, get_termo_data, NULL},
     {"connected-slaves", "show connected slaves", NULL, connected_slaves, NULL},
+    // calibration commands
+    {"calib-point", "add calibration point at the current raw value", "channel value", calib_point, NULL},
+    {"calib-commit", "fit, save and apply calibration", "channel linear|poly|piecewise [order]", calib_commit, NULL},
+    {"calib-show", "show stored calibration", "channel", calib_show, NULL},
+    {"calib-clear", "clear stored calibration or pending points", "channel [points]", calib_clear, NULL},
+    // sd card commands
+    {"sd-stats", "show sd card write statistics", "reset", sd_stats, NULL},
+    {"sd-bench", "sd card write benchmark, pauses data saving", "file_kb", sd_bench, NULL},
+    {"sd-rate", "show or set the sd data period of the state", "state period_ms", sd_rate, NULL},
+    {"sd-policy", "show or set the sd backpressure policy", "drop-newest|drop-oldest|decimate|changed", sd_policy, NULL},
+    {"sd-freeze", "copy the recent full-rate sd data to a permanent file", NULL, sd_freeze, NULL},
+    {"log-sd", "set sd log capture level or uart output, show statistics", "tag|* level / uart 0|1", log_sd, NULL},
+    {"sd-frame-bench", "compare csv and binary sd frame encoding", "iterations", sd_frame_bench, NULL},
+    // lora commands
+    {"lora-stats", "show lora link statistics", "reset", lora_stats, NULL},
+    // i2c bus commands
+    {"i2c-stats", "show i2c bus statistics", "reset", i2c_stats, NULL},
 };
 
 esp_err_t console_config_init() {
@@ -0,0 +1,136 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "backpressure.h"
+
+#include <string.h>
+
+static const char *policy_names[BACKPRESSURE_POLICY_COUNT] = {
+    "drop-newest",
+    "drop-oldest",
+    "decimate",
+    "changed",
+};
+
+void backpressure_init(backpressure_t *bp, backpressure_policy_t policy, uint32_t queue_size,
+                       const backpressure_group_t *groups, size_t group_count) {
+    memset(bp, 0, sizeof(*bp));
+    bp->policy = policy < BACKPRESSURE_POLICY_COUNT ? policy : BACKPRESSURE_DROP_NEWEST;
+    bp->high_level = queue_size * 3 / 4;
+    bp->low_level = queue_size / 4;
+    if (groups != NULL) {
+        bp->group_count = group_count < BACKPRESSURE_MAX_GROUPS ? group_count : BACKPRESSURE_MAX_GROUPS;
+        memcpy(bp->groups, groups, bp->group_count * sizeof(groups[0]));
+    }
+}
+
+void backpressure_set_policy(backpressure_t *bp, backpressure_policy_t policy) {
+    if (policy < BACKPRESSURE_POLICY_COUNT) {
+        bp->policy = policy;
+    }
+}
+
+backpressure_policy_t backpressure_get_policy(const backpressure_t *bp) {
+    return bp->policy;
+}
+
+/**
+ * @note The factor changes by one step at most once per 2^k samples, so at least one sample of
+ *       every factor is queued and the level has time to follow.
+ */
+static void update_decimation(backpressure_t *bp, uint32_t queue_used) {
+    if (bp->policy != BACKPRESSURE_DECIMATE && bp->policy != BACKPRESSURE_CHANGED) {
+        bp->decimation = 0;
+        return;
+    }
+
+    bp->since_change++;
+    if (bp->since_change < (1u << bp->decimation)) {
+        return;
+    }
+
+    if (queue_used >= bp->high_level && bp->decimation < BACKPRESSURE_MAX_DECIMATION) {
+        bp->decimation++;
+    } else if (queue_used <= bp->low_level && bp->decimation > 0) {
+        bp->decimation--;
+    } else {
+        return;
+    }
+    bp->since_change = 0;
+    bp->phase = 0;
+}
+
+static bool group_changed(backpressure_t *bp, const uint8_t *sample, size_t size) {
+    if (size > sizeof(bp->previous)) {
+        return false;
+    }
+
+    bool changed = bp->previous_valid == false;
+    for (size_t i = 0; i < bp->group_count && changed == false; ++i) {
+        const backpressure_group_t *group = &bp->groups[i];
+        if ((size_t)group->offset + group->size <= size &&
+            memcmp(sample + group->offset, bp->previous + group->offset, group->size) != 0) {
+            changed = true;
+        }
+    }
+    memcpy(bp->previous, sample, size);
+    bp->previous_valid = true;
+    return changed;
+}
+
+bool backpressure_check(backpressure_t *bp, const void *sample, size_t size, uint32_t queue_used) {
+    __atomic_add_fetch(&bp->counters.produced, 1, __ATOMIC_RELAXED);
+    update_decimation(bp, queue_used);
+
+    bool keep = (bp->phase & ((1u << bp->decimation) - 1)) == 0;
+    bp->phase++;
+    if (bp->policy == BACKPRESSURE_CHANGED && group_changed(bp, sample, size) == true) {
+        keep = true;
+    }
+
+    if (keep == false) {
+        __atomic_add_fetch(&bp->counters.decimated, 1, __ATOMIC_RELAXED);
+    }
+    return keep;
+}
+
+uint8_t backpressure_get_decimation(const backpressure_t *bp) {
+    return bp->decimation;
+}
+
+void backpressure_count_queued(backpressure_t *bp) {
+    __atomic_add_fetch(&bp->counters.queued, 1, __ATOMIC_RELAXED);
+}
+
+void backpressure_count_dropped(backpressure_t *bp) {
+    __atomic_add_fetch(&bp->counters.dropped, 1, __ATOMIC_RELAXED);
+}
+
+void backpressure_count_written(backpressure_t *bp) {
+    __atomic_add_fetch(&bp->counters.written, 1, __ATOMIC_RELAXED);
+}
+
+void backpressure_get_counters(backpressure_t *bp, backpressure_counters_t *counters) {
+    counters->produced = __atomic_load_n(&bp->counters.produced, __ATOMIC_RELAXED);
+    counters->queued = __atomic_load_n(&bp->counters.queued, __ATOMIC_RELAXED);
+    counters->decimated = __atomic_load_n(&bp->counters.decimated, __ATOMIC_RELAXED);
+    counters->dropped = __atomic_load_n(&bp->counters.dropped, __ATOMIC_RELAXED);
+    counters->written = __atomic_load_n(&bp->counters.written, __ATOMIC_RELAXED);
+}
+
+const char *backpressure_policy_name(backpressure_policy_t policy) {
+    return policy < BACKPRESSURE_POLICY_COUNT ? policy_names[policy] : "unknown";
+}
+
+backpressure_policy_t backpressure_policy_from_name(const char *name) {
+    for (int i = 0; i < BACKPRESSURE_POLICY_COUNT; ++i) {
+        if (strcmp(policy_names[i], name) == 0) {
+            return (backpressure_policy_t)i;
+        }
+    }
+    return BACKPRESSURE_POLICY_COUNT;
+}
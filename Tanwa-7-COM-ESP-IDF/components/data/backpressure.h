@@ -0,0 +1,114 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the backpressure policy of the SD data queue. The producer
+/// asks the policy about every sample before it is queued. Under load the samples are decimated
+/// by 2^k instead of being lost at random, the factor follows the queue level with hysteresis.
+/// All samples are counted, so the log shows exactly how many were produced, skipped and lost.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_BACKPRESSURE_H_
+#define PWRINSPACE_BACKPRESSURE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BACKPRESSURE_MAX_DECIMATION 5  // log2, every 32nd sample
+#define BACKPRESSURE_MAX_GROUPS 16
+#define BACKPRESSURE_MAX_SAMPLE_SIZE 256
+
+typedef enum {
+    BACKPRESSURE_DROP_NEWEST = 0,  // the sample that does not fit in the queue is lost
+    BACKPRESSURE_DROP_OLDEST,  // the oldest queued sample makes room for the new one
+    BACKPRESSURE_DECIMATE,  // every 2^k-th sample is queued under load
+    BACKPRESSURE_CHANGED,  // decimate, but keep every sample in which a watched group changed
+    BACKPRESSURE_POLICY_COUNT,
+} backpressure_policy_t;
+
+/**
+ * @brief Bytes of the sample watched by the BACKPRESSURE_CHANGED policy, e.g. a status struct
+ */
+typedef struct {
+    uint16_t offset;
+    uint16_t size;
+} backpressure_group_t;
+
+typedef struct {
+    uint32_t produced;
+    uint32_t queued;
+    uint32_t decimated;
+    uint32_t dropped;
+    uint32_t written;
+} backpressure_counters_t;
+
+/**
+ * @note backpressure_check is called by the producer task, the counters are atomic and can be
+ *       updated and read from any task.
+ */
+typedef struct {
+    volatile backpressure_policy_t policy;
+    uint32_t high_level;  // queue usage that raises the decimation
+    uint32_t low_level;  // queue usage that lowers it
+    uint8_t decimation;
+    uint32_t since_change;  // samples since the last decimation change
+    uint32_t phase;
+    backpressure_group_t groups[BACKPRESSURE_MAX_GROUPS];
+    size_t group_count;
+    uint8_t previous[BACKPRESSURE_MAX_SAMPLE_SIZE];
+    bool previous_valid;
+    backpressure_counters_t counters;
+} backpressure_t;
+
+/**
+ * @brief Initialize the policy
+ *
+ * @param queue_size capacity of the queue in samples
+ * @param groups groups watched by BACKPRESSURE_CHANGED, can be NULL
+ * @param group_count number of groups, the ones over BACKPRESSURE_MAX_GROUPS are ignored
+ */
+void backpressure_init(backpressure_t *bp, backpressure_policy_t policy, uint32_t queue_size,
+                       const backpressure_group_t *groups, size_t group_count);
+
+void backpressure_set_policy(backpressure_t *bp, backpressure_policy_t policy);
+
+backpressure_policy_t backpressure_get_policy(const backpressure_t *bp);
+
+/**
+ * @brief Decide if the sample goes to the queue
+ *
+ * @note Counts the sample as produced, and as decimated if it is skipped.
+ *
+ * @param sample sample to check
+ * @param size sample size
+ * @param queue_used samples waiting in the queue
+ * @return true if the sample should be queued
+ */
+bool backpressure_check(backpressure_t *bp, const void *sample, size_t size, uint32_t queue_used);
+
+/**
+ * @brief Current decimation, log2 of the factor
+ */
+uint8_t backpressure_get_decimation(const backpressure_t *bp);
+
+void backpressure_count_queued(backpressure_t *bp);
+
+void backpressure_count_dropped(backpressure_t *bp);
+
+void backpressure_count_written(backpressure_t *bp);
+
+void backpressure_get_counters(backpressure_t *bp, backpressure_counters_t *counters);
+
+const char *backpressure_policy_name(backpressure_policy_t policy);
+
+/**
+ * @return BACKPRESSURE_POLICY_COUNT if the name is not known
+ */
+backpressure_policy_t backpressure_policy_from_name(const char *name);
+
+#endif /* PWRINSPACE_BACKPRESSURE_H_ */
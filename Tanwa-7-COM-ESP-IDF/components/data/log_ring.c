@@ -0,0 +1,181 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "log_ring.h"
+
+#include <string.h>
+
+#define HEADER_COMMIT (1UL << 31)
+#define HEADER_PADDING (1UL << 30)
+#define HEADER_LENGTH_MASK 0xFFFFUL
+
+static inline uint32_t record_size(uint32_t length) {
+    return (LOG_RING_HEADER_SIZE + length + 3) & ~3UL;
+}
+
+static inline uint32_t *header_at(log_ring_t *ring, uint32_t position) {
+    return (uint32_t*)(ring->buffer + (position & (ring->size - 1)));
+}
+
+static void update_max_used(log_ring_t *ring, uint32_t used) {
+    uint32_t max_used = __atomic_load_n(&ring->max_used, __ATOMIC_RELAXED);
+    while (used > max_used) {
+        if (__atomic_compare_exchange_n(&ring->max_used, &max_used, used, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+log_ring_status_t log_ring_init(log_ring_t *ring, uint8_t *buffer, uint32_t size) {
+    if (ring == NULL || buffer == NULL) {
+        return LOG_RING_INVALID_ARG;
+    }
+    if (size < LOG_RING_MIN_SIZE || size > LOG_RING_MAX_SIZE || (size & (size - 1)) != 0) {
+        return LOG_RING_INVALID_ARG;
+    }
+    if (((uintptr_t)buffer & 3) != 0) {
+        return LOG_RING_INVALID_ARG;
+    }
+
+    memset(buffer, 0, size);
+    ring->buffer = buffer;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+    log_ring_reset_stats(ring);
+    return LOG_RING_OK;
+}
+
+static void count_dropped(log_ring_t *ring, size_t length) {
+    __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ring->dropped_bytes, length, __ATOMIC_RELAXED);
+}
+
+static inline void write_padding(log_ring_t *ring, uint32_t position, uint32_t size) {
+    __atomic_store_n(header_at(ring, position), HEADER_COMMIT | HEADER_PADDING | (size - LOG_RING_HEADER_SIZE),
+                     __ATOMIC_RELEASE);
+}
+
+bool log_ring_reserve(log_ring_t *ring, size_t length, log_ring_reservation_t *reservation) {
+    uint32_t size = record_size(length);
+    // a record longer than half of the ring could never fit behind the padding
+    if (length == 0 || size > ring->size / 2) {
+        count_dropped(ring, length);
+        return false;
+    }
+
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t padding;
+    uint32_t used;
+    do {
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        uint32_t to_end = ring->size - (head & (ring->size - 1));
+        // records are never split, the rest of the buffer is skipped with a padding record
+        padding = size > to_end ? to_end : 0;
+        used = head - tail + padding + size;
+        if (used > ring->size) {
+            count_dropped(ring, length);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + padding + size, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    // the reserved space is owned by this producer now
+    if (padding > 0) {
+        write_padding(ring, head, padding);
+        head += padding;
+    }
+    reservation->data = (uint8_t*)(header_at(ring, head) + 1);
+    reservation->length = length;
+    reservation->position = head;
+    update_max_used(ring, used);
+    return true;
+}
+
+void log_ring_commit(log_ring_t *ring, const log_ring_reservation_t *reservation, size_t length) {
+    if (length > reservation->length) {
+        length = reservation->length;
+    }
+    uint32_t reserved_size = record_size(reservation->length);
+    uint32_t size = length > 0 ? record_size(length) : 0;
+    if (size < reserved_size) {
+        // free space has to be zero, the payload written past the record could look like a header
+        uint32_t end = reservation->position + reserved_size;
+        memset(header_at(ring, reservation->position + size), 0, reserved_size - size);
+        // give the rest back if nothing was reserved behind, otherwise the consumer skips it
+        if (!__atomic_compare_exchange_n(&ring->head, &end, reservation->position + size, false,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            write_padding(ring, reservation->position + size, reserved_size - size);
+        }
+    }
+
+    if (length == 0) {
+        count_dropped(ring, 0);
+        return;
+    }
+    __atomic_store_n(header_at(ring, reservation->position), HEADER_COMMIT | length, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&ring->pushed, 1, __ATOMIC_RELAXED);
+}
+
+bool log_ring_push(log_ring_t *ring, const void *data, size_t length) {
+    log_ring_reservation_t reservation;
+    if (log_ring_reserve(ring, length, &reservation) == false) {
+        return false;
+    }
+    memcpy(reservation.data, data, length);
+    log_ring_commit(ring, &reservation, length);
+    return true;
+}
+
+size_t log_ring_peek(log_ring_t *ring, const uint8_t **data) {
+    while (1) {
+        uint32_t tail = ring->tail;
+        if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+            return 0;
+        }
+
+        uint32_t *header = header_at(ring, tail);
+        uint32_t value = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+        if ((value & HEADER_COMMIT) == 0) {
+            // reserved, but the producer did not finish copying yet
+            return 0;
+        }
+
+        if ((value & HEADER_PADDING) == 0) {
+            *data = (const uint8_t*)(header + 1);
+            return value & HEADER_LENGTH_MASK;
+        }
+
+        log_ring_release(ring);
+    }
+}
+
+void log_ring_release(log_ring_t *ring) {
+    uint32_t tail = ring->tail;
+    uint32_t *header = header_at(ring, tail);
+    uint32_t size = record_size(*header & HEADER_LENGTH_MASK);
+    // producers rely on free space being zero, a stale header would look committed
+    memset(header, 0, size);
+    __atomic_store_n(&ring->tail, tail + size, __ATOMIC_RELEASE);
+}
+
+void log_ring_get_stats(log_ring_t *ring, log_ring_stats_t *stats) {
+    stats->pushed = __atomic_load_n(&ring->pushed, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    stats->dropped_bytes = __atomic_load_n(&ring->dropped_bytes, __ATOMIC_RELAXED);
+    stats->used = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    stats->max_used = __atomic_load_n(&ring->max_used, __ATOMIC_RELAXED);
+    stats->size = ring->size;
+}
+
+void log_ring_reset_stats(log_ring_t *ring) {
+    __atomic_store_n(&ring->pushed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->dropped_bytes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->max_used, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,125 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the byte ring for variable-length log records. Any number of
+/// tasks (or interrupts) can push records without locks and without blocking, a single consumer
+/// reads them in order. A record that does not fit is dropped and counted.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_LOG_RING_H_
+#define PWRINSPACE_LOG_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// size has to be a power of two, the record header keeps the length on 16 bits
+#define LOG_RING_MIN_SIZE 64
+#define LOG_RING_MAX_SIZE 32768
+#define LOG_RING_HEADER_SIZE 4
+
+typedef enum {
+    LOG_RING_OK = 0,
+    LOG_RING_FAIL,
+    LOG_RING_INVALID_ARG,
+} log_ring_status_t;
+
+/**
+ * @brief Ring of length-prefixed records
+ *
+ * @note head and tail grow without wrapping to the buffer, producers reserve space by moving
+ *       the head with compare-and-swap, the record is published by setting the commit bit of
+ *       its header. The consumer clears consumed records, so free space is always zeroed.
+ */
+typedef struct {
+    uint8_t *buffer;
+    uint32_t size;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t dropped_bytes;
+    uint32_t max_used;
+} log_ring_t;
+
+/**
+ * @brief Space reserved for one record, the producer writes the payload in place
+ */
+typedef struct {
+    uint8_t *data;  // payload, length bytes
+    uint32_t length;
+    uint32_t position;  // of the record header
+} log_ring_reservation_t;
+
+typedef struct {
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t dropped_bytes;
+    uint32_t used;
+    uint32_t max_used;
+    uint32_t size;
+} log_ring_stats_t;
+
+/**
+ * @brief Initialize the ring on the buffer
+ *
+ * @param ring pointer to the ring
+ * @param buffer 4 byte aligned buffer, power of two size
+ * @param size buffer size in bytes
+ * @return `log_ring_status_t`
+ * @retval `LOG_RING_OK` on success
+ * @retval `LOG_RING_INVALID_ARG` if the buffer size or alignment is wrong
+ */
+log_ring_status_t log_ring_init(log_ring_t *ring, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Copy the record to the ring
+ *
+ * @note Safe to call from any task or interrupt, never blocks.
+ *
+ * @return false if the record was dropped because the ring is full
+ */
+bool log_ring_push(log_ring_t *ring, const void *data, size_t length);
+
+/**
+ * @brief Reserve a record of up to length bytes, publish it with log_ring_commit
+ *
+ * @note Safe to call from any task or interrupt, never blocks. The consumer stops at the
+ *       reserved record until it is committed, so commit it right after writing the payload.
+ *
+ * @return false if the record was dropped because the ring is full
+ */
+bool log_ring_reserve(log_ring_t *ring, size_t length, log_ring_reservation_t *reservation);
+
+/**
+ * @brief Publish the reserved record, the unused end of the reservation is given back
+ *
+ * @param length final length, at most the reserved one, 0 drops the record
+ */
+void log_ring_commit(log_ring_t *ring, const log_ring_reservation_t *reservation, size_t length);
+
+/**
+ * @brief Get the oldest committed record without copying it
+ *
+ * @note Consumer only. The record stays valid until log_ring_release is called.
+ *
+ * @param[out] data pointer to the record payload
+ * @return record length, 0 if there is no committed record
+ */
+size_t log_ring_peek(log_ring_t *ring, const uint8_t **data);
+
+/**
+ * @brief Free the record returned by the last log_ring_peek
+ */
+void log_ring_release(log_ring_t *ring);
+
+void log_ring_get_stats(log_ring_t *ring, log_ring_stats_t *stats);
+
+void log_ring_reset_stats(log_ring_t *ring);
+
+#endif /* PWRINSPACE_LOG_RING_H_ */
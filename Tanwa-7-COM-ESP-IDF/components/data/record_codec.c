@@ -0,0 +1,322 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "record_codec.h"
+
+#include <string.h>
+
+#include "tanwa_log_format.h"
+
+#define GROUP_SIZE 8
+#define LZ_WINDOW_SIZE 256
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (LZ_MIN_MATCH + 255)
+
+static size_t group_count(size_t record_size) {
+    return (record_size + GROUP_SIZE - 1) / GROUP_SIZE;
+}
+
+/**
+ * @brief Worst case size of the packed record, every byte changed
+ */
+static size_t max_packed_size(size_t record_size) {
+    size_t groups = group_count(record_size);
+    return (groups + 7) / 8 + groups + record_size;
+}
+
+///===-----------------------------------------------------------------------------------------===//
+/// XOR and zero byte packing
+///===-----------------------------------------------------------------------------------------===//
+
+/**
+ * @note Group mask has one bit per 8 bytes of the record, every set group is followed by its byte
+ *       mask and the nonzero bytes. An unchanged record takes only the group mask.
+ */
+static size_t pack_record(const uint8_t *record, const uint8_t *previous, size_t size, uint8_t *out) {
+    size_t groups = group_count(size);
+    size_t mask_size = (groups + 7) / 8;
+    memset(out, 0, mask_size);
+
+    size_t pos = mask_size;
+    for (size_t group = 0; group < groups; ++group) {
+        size_t start = group * GROUP_SIZE;
+        size_t end = start + GROUP_SIZE < size ? start + GROUP_SIZE : size;
+        size_t mask_pos = pos;
+        uint8_t mask = 0;
+        pos++;
+        for (size_t i = start; i < end; ++i) {
+            uint8_t value = record[i] ^ previous[i];
+            if (value != 0) {
+                mask |= (uint8_t)(1 << (i - start));
+                out[pos++] = value;
+            }
+        }
+
+        if (mask == 0) {
+            pos--;
+            continue;
+        }
+        out[group / 8] |= (uint8_t)(1 << (group % 8));
+        out[mask_pos] = mask;
+    }
+    return pos;
+}
+
+static size_t unpack_record(const uint8_t *in, size_t in_size, uint8_t *record, const uint8_t *previous,
+                            size_t size) {
+    size_t groups = group_count(size);
+    size_t mask_size = (groups + 7) / 8;
+    if (in_size < mask_size) {
+        return 0;
+    }
+
+    memcpy(record, previous, size);
+    size_t pos = mask_size;
+    for (size_t group = 0; group < groups; ++group) {
+        if ((in[group / 8] & (1 << (group % 8))) == 0) {
+            continue;
+        }
+        if (pos >= in_size) {
+            return 0;
+        }
+
+        uint8_t mask = in[pos++];
+        size_t start = group * GROUP_SIZE;
+        for (size_t bit = 0; bit < GROUP_SIZE; ++bit) {
+            if ((mask & (1 << bit)) == 0) {
+                continue;
+            }
+            if (pos >= in_size || start + bit >= size) {
+                return 0;
+            }
+            record[start + bit] ^= in[pos++];
+        }
+    }
+    return pos;
+}
+
+///===-----------------------------------------------------------------------------------------===//
+/// LZSS, one control byte per 8 items, a match is distance - 1 and length - LZ_MIN_MATCH
+///===-----------------------------------------------------------------------------------------===//
+
+/**
+ * @return compressed size, 0 if the output would not be smaller than the input
+ */
+static size_t lz_compress(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size) {
+    size_t pos = 0;
+    size_t out_pos = 0;
+    size_t control_pos = 0;
+    uint8_t control_bit = 8;
+    while (pos < in_size) {
+        if (control_bit >= 8) {
+            if (out_pos >= out_size) {
+                return 0;
+            }
+            control_pos = out_pos++;
+            out[control_pos] = 0;
+            control_bit = 0;
+        }
+
+        size_t best_length = 0;
+        size_t best_distance = 0;
+        size_t max_length = in_size - pos < LZ_MAX_MATCH ? in_size - pos : LZ_MAX_MATCH;
+        size_t window = pos < LZ_WINDOW_SIZE ? pos : LZ_WINDOW_SIZE;
+        for (size_t distance = 1; distance <= window && max_length >= LZ_MIN_MATCH; ++distance) {
+            const uint8_t *match = in + pos - distance;
+            if (match[0] != in[pos] || match[best_length] != in[pos + best_length]) {
+                continue;
+            }
+            size_t length = 0;
+            while (length < max_length && match[length] == in[pos + length]) {
+                length++;
+            }
+            if (length > best_length) {
+                best_length = length;
+                best_distance = distance;
+                if (length == max_length) {
+                    break;
+                }
+            }
+        }
+
+        if (best_length >= LZ_MIN_MATCH) {
+            if (out_pos + 2 > out_size) {
+                return 0;
+            }
+            out[control_pos] |= (uint8_t)(1 << control_bit);
+            out[out_pos++] = (uint8_t)(best_distance - 1);
+            out[out_pos++] = (uint8_t)(best_length - LZ_MIN_MATCH);
+            pos += best_length;
+        } else {
+            if (out_pos >= out_size) {
+                return 0;
+            }
+            out[out_pos++] = in[pos++];
+        }
+        control_bit++;
+    }
+    return out_pos < in_size ? out_pos : 0;
+}
+
+static size_t lz_decompress(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size) {
+    size_t pos = 0;
+    size_t out_pos = 0;
+    uint8_t control = 0;
+    uint8_t control_bit = 8;
+    while (pos < in_size) {
+        if (control_bit >= 8) {
+            control = in[pos++];
+            control_bit = 0;
+            continue;
+        }
+
+        if ((control & (1 << control_bit++)) == 0) {
+            if (out_pos >= out_size) {
+                return 0;
+            }
+            out[out_pos++] = in[pos++];
+            continue;
+        }
+
+        if (pos + 2 > in_size) {
+            return 0;
+        }
+        size_t distance = in[pos++] + 1;
+        size_t length = in[pos++] + LZ_MIN_MATCH;
+        if (distance > out_pos || out_pos + length > out_size) {
+            return 0;
+        }
+        // byte by byte, the match may overlap the output
+        for (size_t i = 0; i < length; ++i, ++out_pos) {
+            out[out_pos] = out[out_pos - distance];
+        }
+    }
+    return out_pos;
+}
+
+///===-----------------------------------------------------------------------------------------===//
+
+static void put_u16(uint8_t *buffer, uint16_t value) {
+    buffer[0] = (uint8_t)value;
+    buffer[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *buffer) {
+    return (uint16_t)(buffer[0] | (buffer[1] << 8));
+}
+
+void record_codec_init(record_codec_t *codec, uint16_t keyframe_interval, bool lz) {
+    codec->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : 1;
+    codec->lz = lz;
+    memset(&codec->stats, 0, sizeof(codec->stats));
+    record_codec_reset(codec);
+}
+
+void record_codec_reset(record_codec_t *codec) {
+    codec->record_size = 0;
+    codec->record_count = 0;
+    codec->block_used = 0;
+    memset(codec->previous, 0, sizeof(codec->previous));
+}
+
+size_t record_codec_flush(record_codec_t *codec, const uint8_t **block) {
+    if (codec->record_count == 0) {
+        return 0;
+    }
+
+    uint8_t *payload = codec->output + RECORD_CODEC_HEADER_SIZE;
+    size_t payload_size = 0;
+    uint8_t flags = 0;
+    if (codec->lz == true) {
+        payload_size = lz_compress(codec->block, codec->block_used, payload, RECORD_CODEC_BLOCK_SIZE);
+        flags = payload_size > 0 ? RECORD_CODEC_FLAG_LZ : 0;
+    }
+    if (payload_size == 0) {
+        memcpy(payload, codec->block, codec->block_used);
+        payload_size = codec->block_used;
+    }
+
+    codec->output[0] = RECORD_CODEC_MARKER;
+    codec->output[1] = flags;
+    put_u16(codec->output + 2, codec->record_count);
+    put_u16(codec->output + 4, codec->record_size);
+    put_u16(codec->output + 6, (uint16_t)payload_size);
+    size_t size = RECORD_CODEC_HEADER_SIZE + payload_size;
+    put_u16(codec->output + size, tanwa_log_crc16(codec->output, size));
+    size += RECORD_CODEC_CRC_SIZE;
+
+    codec->stats.blocks++;
+    codec->stats.bytes_out += size;
+    record_codec_reset(codec);
+    *block = codec->output;
+    return size;
+}
+
+size_t record_codec_push(record_codec_t *codec, const uint8_t *record, size_t size, const uint8_t **block) {
+    if (size == 0 || size > RECORD_CODEC_MAX_RECORD_SIZE) {
+        return 0;
+    }
+
+    size_t closed = 0;
+    if (codec->record_count >= codec->keyframe_interval || (codec->record_count > 0 &&
+        (size != codec->record_size || codec->block_used + max_packed_size(size) > RECORD_CODEC_BLOCK_SIZE))) {
+        closed = record_codec_flush(codec, block);
+    }
+
+    codec->record_size = (uint16_t)size;
+    codec->block_used += pack_record(record, codec->previous, size, codec->block + codec->block_used);
+    memcpy(codec->previous, record, size);
+    codec->record_count++;
+
+    codec->stats.records++;
+    codec->stats.bytes_in += size;
+    return closed;
+}
+
+size_t record_codec_decode_block(const uint8_t *data, size_t size, uint8_t *records, size_t records_size,
+                                 size_t *block_size, uint16_t *record_size) {
+    if (size < RECORD_CODEC_HEADER_SIZE + RECORD_CODEC_CRC_SIZE || data[0] != RECORD_CODEC_MARKER) {
+        return 0;
+    }
+
+    uint16_t count = get_u16(data + 2);
+    uint16_t record = get_u16(data + 4);
+    size_t payload_size = get_u16(data + 6);
+    size_t total = RECORD_CODEC_HEADER_SIZE + payload_size + RECORD_CODEC_CRC_SIZE;
+    if (total > size || payload_size > RECORD_CODEC_BLOCK_SIZE || record == 0 ||
+        record > RECORD_CODEC_MAX_RECORD_SIZE || (size_t)count * record > records_size) {
+        return 0;
+    }
+    size_t crc_pos = total - RECORD_CODEC_CRC_SIZE;
+    if (tanwa_log_crc16(data, crc_pos) != get_u16(data + crc_pos)) {
+        return 0;
+    }
+
+    const uint8_t *packed = data + RECORD_CODEC_HEADER_SIZE;
+    uint8_t unpacked[RECORD_CODEC_BLOCK_SIZE];
+    if (data[1] & RECORD_CODEC_FLAG_LZ) {
+        payload_size = lz_decompress(packed, payload_size, unpacked, sizeof(unpacked));
+        packed = unpacked;
+    }
+
+    static const uint8_t keyframe[RECORD_CODEC_MAX_RECORD_SIZE] = {0};
+    const uint8_t *previous = keyframe;
+    size_t pos = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        uint8_t *out = records + (size_t)i * record;
+        size_t used = unpack_record(packed + pos, payload_size - pos, out, previous, record);
+        if (used == 0) {
+            return 0;
+        }
+        pos += used;
+        previous = out;
+    }
+
+    *block_size = total;
+    *record_size = record;
+    return count;
+}
@@ -0,0 +1,112 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the record codec. Fixed-size records are XORed with the
+/// previous record, the zero bytes are dropped with a two-level bitmap, and the packed block is
+/// optionally compressed with a small LZSS (256 B window). Every block starts with a keyframe
+/// (XOR with zeros), so it can be decoded on its own. All memory is in the codec structure, the
+/// file does not depend on ESP-IDF and is also compiled into the host side decoder.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_RECORD_CODEC_H_
+#define PWRINSPACE_RECORD_CODEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECORD_CODEC_MAX_RECORD_SIZE 128
+#define RECORD_CODEC_BLOCK_SIZE 2048  // packed records of one block, before LZ
+#define RECORD_CODEC_HEADER_SIZE 8
+#define RECORD_CODEC_CRC_SIZE 2
+#define RECORD_CODEC_OUTPUT_SIZE (RECORD_CODEC_HEADER_SIZE + RECORD_CODEC_BLOCK_SIZE + RECORD_CODEC_CRC_SIZE)
+#define RECORD_CODEC_MARKER 0xC5
+
+#define RECORD_CODEC_FLAG_LZ 0x01
+
+typedef struct {
+    uint32_t records;
+    uint32_t blocks;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+} record_codec_stats_t;
+
+/**
+ * @brief Codec state of one data file
+ *
+ * @note Block: marker, flags, u16 record count, u16 record size, u16 payload size, payload,
+ *       CRC16 of everything before it. All little-endian.
+ */
+typedef struct {
+    uint16_t keyframe_interval;
+    bool lz;
+    uint16_t record_size;
+    uint16_t record_count;
+    size_t block_used;
+    uint8_t previous[RECORD_CODEC_MAX_RECORD_SIZE];
+    uint8_t block[RECORD_CODEC_BLOCK_SIZE];
+    uint8_t output[RECORD_CODEC_OUTPUT_SIZE];
+    record_codec_stats_t stats;
+} record_codec_t;
+
+/**
+ * @brief Initialize the codec
+ *
+ * @param codec pointer to the codec
+ * @param keyframe_interval maximum number of records in one block
+ * @param lz compress the packed block with LZSS
+ */
+void record_codec_init(record_codec_t *codec, uint16_t keyframe_interval, bool lz);
+
+/**
+ * @brief Add the record to the current block
+ *
+ * @note The current block is closed first if it is full or the record does not fit, then the
+ *       closed block is returned and has to be written before the next call.
+ *
+ * @param[out] block closed block, valid until the next push or flush
+ * @return size of the closed block, 0 if no block was closed
+ */
+size_t record_codec_push(record_codec_t *codec, const uint8_t *record, size_t size, const uint8_t **block);
+
+/**
+ * @brief Close the current block
+ *
+ * @param[out] block closed block, valid until the next push or flush
+ * @return size of the closed block, 0 if the block is empty
+ */
+size_t record_codec_flush(record_codec_t *codec, const uint8_t **block);
+
+/**
+ * @brief Start the next block from a keyframe and drop the buffered records
+ */
+void record_codec_reset(record_codec_t *codec);
+
+/**
+ * @brief Decode one block to the records
+ *
+ * @param data pointer to the beginning of the block
+ * @param size available bytes
+ * @param records output buffer for the decoded records
+ * @param records_size output buffer size
+ * @param[out] block_size size of the block in the input
+ * @param[out] record_size size of one record
+ * @return number of decoded records, 0 if the block is not valid
+ */
+size_t record_codec_decode_block(const uint8_t *data, size_t size, uint8_t *records, size_t records_size,
+                                 size_t *block_size, uint16_t *record_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PWRINSPACE_RECORD_CODEC_H_ */
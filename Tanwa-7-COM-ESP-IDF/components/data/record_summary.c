@@ -0,0 +1,139 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "record_summary.h"
+
+#include <string.h>
+
+static void put_u32(uint8_t *buffer, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *buffer) {
+    return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static void put_f32(uint8_t *buffer, float value) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    put_u32(buffer, raw);
+}
+
+static float get_f32(const uint8_t *buffer) {
+    uint32_t raw = get_u32(buffer);
+    float value;
+    memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+static float value_to_float(uint8_t type, tanwa_log_value_t value) {
+    switch (type) {
+        case TANWA_LOG_TYPE_I16:
+            return (float)value.i;
+        case TANWA_LOG_TYPE_F32:
+            return value.f;
+        default:
+            return (float)value.u;
+    }
+}
+
+static void reset(record_summary_t *summary) {
+    summary->count = 0;
+    memset(summary->sum, 0, sizeof(summary->sum));
+}
+
+bool record_summary_init(record_summary_t *summary, const uint8_t *header, size_t header_size) {
+    if (tanwa_log_parse_header(header, header_size, &summary->schema) == false) {
+        return false;
+    }
+
+    reset(summary);
+    return true;
+}
+
+bool record_summary_is_due(const record_summary_t *summary, const uint8_t *record, uint32_t interval_ms) {
+    // timestamp_ms is the first field of every record
+    return summary->count > 0 && get_u32(record) - summary->first_timestamp_ms >= interval_ms;
+}
+
+bool record_summary_add(record_summary_t *summary, const uint8_t *record) {
+    tanwa_log_value_t values[TANWA_LOG_MAX_FIELDS];
+    if (tanwa_log_decode_record(&summary->schema, record, values) == false) {
+        return false;
+    }
+
+    uint32_t timestamp_ms = get_u32(record);
+    if (summary->count == 0) {
+        summary->first_timestamp_ms = timestamp_ms;
+    }
+    summary->last_timestamp_ms = timestamp_ms;
+
+    for (uint8_t i = 0; i < summary->schema.field_count; ++i) {
+        float value = value_to_float(summary->schema.fields[i].type, values[i]);
+        if (summary->count == 0 || value < summary->min[i]) {
+            summary->min[i] = value;
+        }
+        if (summary->count == 0 || value > summary->max[i]) {
+            summary->max[i] = value;
+        }
+        summary->sum[i] += value;
+    }
+    summary->count++;
+    return true;
+}
+
+size_t record_summary_flush(record_summary_t *summary, const uint8_t **payload) {
+    if (summary->count == 0) {
+        return 0;
+    }
+
+    uint8_t *out = summary->output;
+    put_u32(out, summary->first_timestamp_ms);
+    put_u32(out + 4, summary->last_timestamp_ms);
+    uint16_t count = summary->count > UINT16_MAX ? UINT16_MAX : (uint16_t)summary->count;
+    out[8] = (uint8_t)count;
+    out[9] = (uint8_t)(count >> 8);
+    out[10] = summary->schema.field_count;
+    out[11] = 0;
+
+    size_t pos = RECORD_SUMMARY_HEADER_SIZE;
+    for (uint8_t i = 0; i < summary->schema.field_count; ++i) {
+        put_f32(out + pos, summary->min[i]);
+        put_f32(out + pos + 4, summary->max[i]);
+        put_f32(out + pos + 8, (float)(summary->sum[i] / summary->count));
+        pos += RECORD_SUMMARY_FIELD_SIZE;
+    }
+
+    reset(summary);
+    *payload = out;
+    return pos;
+}
+
+bool record_summary_decode(const uint8_t *payload, size_t size, record_summary_values_t *values) {
+    if (size < RECORD_SUMMARY_HEADER_SIZE) {
+        return false;
+    }
+
+    values->first_timestamp_ms = get_u32(payload);
+    values->last_timestamp_ms = get_u32(payload + 4);
+    values->count = (uint16_t)(payload[8] | (payload[9] << 8));
+    values->field_count = payload[10];
+    if (values->field_count > TANWA_LOG_MAX_FIELDS ||
+        size != RECORD_SUMMARY_HEADER_SIZE + (size_t)values->field_count * RECORD_SUMMARY_FIELD_SIZE) {
+        return false;
+    }
+
+    const uint8_t *field = payload + RECORD_SUMMARY_HEADER_SIZE;
+    for (uint8_t i = 0; i < values->field_count; ++i, field += RECORD_SUMMARY_FIELD_SIZE) {
+        values->min[i] = get_f32(field);
+        values->max[i] = get_f32(field + 4);
+        values->mean[i] = get_f32(field + 8);
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the record summary, minimum, maximum and mean of every
+/// schema field over an interval. It is the long-term stream of the two-tier logger, the full
+/// rate records are kept only in the circular file. Flags are summarized as 0/1, so their mean
+/// is the part of the interval they were set. The file does not depend on ESP-IDF and is also
+/// compiled into the host side decoder.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_RECORD_SUMMARY_H_
+#define PWRINSPACE_RECORD_SUMMARY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tanwa_log_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// u32 first timestamp, u32 last timestamp, u16 record count, u8 field count, u8 reserved, then
+// f32 minimum, maximum and mean of every field, little-endian
+#define RECORD_SUMMARY_HEADER_SIZE 12
+#define RECORD_SUMMARY_FIELD_SIZE 12
+#define RECORD_SUMMARY_MAX_SIZE (RECORD_SUMMARY_HEADER_SIZE + TANWA_LOG_MAX_FIELDS * RECORD_SUMMARY_FIELD_SIZE)
+
+typedef struct {
+    tanwa_log_schema_t schema;
+    uint32_t count;
+    uint32_t first_timestamp_ms;
+    uint32_t last_timestamp_ms;
+    float min[TANWA_LOG_MAX_FIELDS];
+    float max[TANWA_LOG_MAX_FIELDS];
+    double sum[TANWA_LOG_MAX_FIELDS];
+    uint8_t output[RECORD_SUMMARY_MAX_SIZE];
+} record_summary_t;
+
+typedef struct {
+    uint32_t first_timestamp_ms;
+    uint32_t last_timestamp_ms;
+    uint16_t count;
+    uint8_t field_count;
+    float min[TANWA_LOG_MAX_FIELDS];
+    float max[TANWA_LOG_MAX_FIELDS];
+    float mean[TANWA_LOG_MAX_FIELDS];
+} record_summary_values_t;
+
+/**
+ * @brief Initialize the summary for the records of the header
+ *
+ * @param header schema header of the data file
+ * @param header_size header size
+ * @return false if the header is not valid
+ */
+bool record_summary_init(record_summary_t *summary, const uint8_t *header, size_t header_size);
+
+/**
+ * @brief Check if the record is past the interval of the summarized records
+ *
+ * @return true if the summary has to be written before the record is added
+ */
+bool record_summary_is_due(const record_summary_t *summary, const uint8_t *record, uint32_t interval_ms);
+
+/**
+ * @brief Add the record to the summary
+ *
+ * @return false if the record CRC does not match, the record is not added
+ */
+bool record_summary_add(record_summary_t *summary, const uint8_t *record);
+
+/**
+ * @brief Encode the summary and start the next one
+ *
+ * @param[out] payload encoded summary, valid until the next flush
+ * @return payload size, 0 if there are no records
+ */
+size_t record_summary_flush(record_summary_t *summary, const uint8_t **payload);
+
+/**
+ * @return false if the payload is not a valid summary
+ */
+bool record_summary_decode(const uint8_t *payload, size_t size, record_summary_values_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PWRINSPACE_RECORD_SUMMARY_H_ */
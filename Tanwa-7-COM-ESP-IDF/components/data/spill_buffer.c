@@ -0,0 +1,70 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "spill_buffer.h"
+
+#include <string.h>
+
+void spill_buffer_init(spill_buffer_t *spill, uint8_t *buffer, size_t size, size_t record_size) {
+    memset(spill, 0, sizeof(*spill));
+    spill->buffer = buffer;
+    spill->record_size = record_size;
+    if (buffer != NULL && record_size > 0) {
+        spill->capacity = size / record_size;
+    }
+}
+
+bool spill_buffer_push(spill_buffer_t *spill, const void *record) {
+    if (spill->count >= spill->capacity) {
+        spill->lost++;
+        return false;
+    }
+
+    uint32_t index = (spill->head + spill->count) % spill->capacity;
+    memcpy(spill->buffer + (size_t)index * spill->record_size, record, spill->record_size);
+    spill->count++;
+    spill->spilled++;
+    if (spill->count > spill->max_count) {
+        spill->max_count = spill->count;
+    }
+    return true;
+}
+
+uint8_t *spill_buffer_peek(spill_buffer_t *spill) {
+    if (spill->count == 0) {
+        return NULL;
+    }
+
+    return spill->buffer + (size_t)spill->head * spill->record_size;
+}
+
+void spill_buffer_pop(spill_buffer_t *spill) {
+    if (spill->count == 0) {
+        return;
+    }
+
+    spill->head = (spill->head + 1) % spill->capacity;
+    spill->count--;
+}
+
+uint32_t spill_buffer_count(const spill_buffer_t *spill) {
+    return spill->count;
+}
+
+void spill_buffer_get_stats(const spill_buffer_t *spill, spill_buffer_stats_t *stats) {
+    stats->count = spill->count;
+    stats->capacity = spill->capacity;
+    stats->spilled = spill->spilled;
+    stats->lost = spill->lost;
+    stats->max_count = spill->max_count;
+}
+
+void spill_buffer_reset_stats(spill_buffer_t *spill) {
+    spill->spilled = 0;
+    spill->lost = 0;
+    spill->max_count = spill->count;
+}
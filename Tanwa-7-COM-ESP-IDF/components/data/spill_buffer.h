@@ -0,0 +1,81 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the spill buffer, a ring of fixed-size records kept in RAM
+/// while the SD card can not be written. Records are copied in and read back in order. When the
+/// buffer is full the new records are lost and counted. Single task only, there are no locks.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_SPILL_BUFFER_H_
+#define PWRINSPACE_SPILL_BUFFER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t *buffer;
+    size_t record_size;
+    uint32_t capacity;  // in records
+    uint32_t head;  // oldest record
+    uint32_t count;
+    uint32_t spilled;
+    uint32_t lost;
+    uint32_t max_count;
+} spill_buffer_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t spilled;
+    uint32_t lost;
+    uint32_t max_count;
+} spill_buffer_stats_t;
+
+/**
+ * @brief Initialize the spill buffer on the memory
+ *
+ * @note A NULL buffer or a buffer smaller than one record gives zero capacity, every record
+ *       pushed is then counted as lost.
+ *
+ * @param spill pointer to the spill buffer
+ * @param buffer record memory
+ * @param size buffer size in bytes
+ * @param record_size size of one record
+ */
+void spill_buffer_init(spill_buffer_t *spill, uint8_t *buffer, size_t size, size_t record_size);
+
+/**
+ * @brief Copy the record to the end of the buffer
+ *
+ * @return false if the buffer is full and the record was lost
+ */
+bool spill_buffer_push(spill_buffer_t *spill, const void *record);
+
+/**
+ * @brief Get the oldest record without removing it
+ *
+ * @return pointer to the record, NULL if the buffer is empty
+ */
+uint8_t *spill_buffer_peek(spill_buffer_t *spill);
+
+/**
+ * @brief Remove the oldest record
+ */
+void spill_buffer_pop(spill_buffer_t *spill);
+
+uint32_t spill_buffer_count(const spill_buffer_t *spill);
+
+void spill_buffer_get_stats(const spill_buffer_t *spill, spill_buffer_stats_t *stats);
+
+/**
+ * @brief Clear the counters, the high-water mark starts from the current count
+ */
+void spill_buffer_reset_stats(spill_buffer_t *spill);
+
+#endif /* PWRINSPACE_SPILL_BUFFER_H_ */
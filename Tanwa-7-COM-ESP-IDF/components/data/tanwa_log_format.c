@@ -0,0 +1,745 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "tanwa_log_format.h"
+
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    uint8_t type;
+} schema_field_t;
+
+// Record layout, the order has to match tanwa_log_encode_record
+static const schema_field_t schema[] = {
+    {"timestamp_ms", TANWA_LOG_TYPE_U32},
+    {"state", TANWA_LOG_TYPE_U8},
+    // COM
+    {"vbat", TANWA_LOG_TYPE_F32},
+    {"abort_button", TANWA_LOG_TYPE_FLAG},
+    {"solenoid_fill", TANWA_LOG_TYPE_FLAG},
+    {"solenoid_depr", TANWA_LOG_TYPE_FLAG},
+    {"igniter_cont_1", TANWA_LOG_TYPE_FLAG},
+    {"igniter_cont_2", TANWA_LOG_TYPE_FLAG},
+    {"pressure_1", TANWA_LOG_TYPE_F32},
+    {"pressure_2", TANWA_LOG_TYPE_F32},
+    {"pressure_3", TANWA_LOG_TYPE_F32},
+    {"pressure_4", TANWA_LOG_TYPE_F32},
+    {"temperature_1", TANWA_LOG_TYPE_F32},
+    {"temperature_2", TANWA_LOG_TYPE_F32},
+    // connected slaves
+    {"slave_hx_rocket", TANWA_LOG_TYPE_FLAG},
+    {"slave_hx_oxidizer", TANWA_LOG_TYPE_FLAG},
+    {"slave_fac", TANWA_LOG_TYPE_FLAG},
+    {"slave_flc", TANWA_LOG_TYPE_FLAG},
+    {"slave_termo", TANWA_LOG_TYPE_FLAG},
+    // HX rocket
+    {"hx_rck_status", TANWA_LOG_TYPE_U16},
+    {"hx_rck_request", TANWA_LOG_TYPE_U8},
+    {"hx_rck_temperature", TANWA_LOG_TYPE_I16},
+    {"hx_rck_weight", TANWA_LOG_TYPE_F32},
+    {"hx_rck_weight_raw", TANWA_LOG_TYPE_U32},
+    // HX oxidizer
+    {"hx_oxi_status", TANWA_LOG_TYPE_U16},
+    {"hx_oxi_request", TANWA_LOG_TYPE_U8},
+    {"hx_oxi_temperature", TANWA_LOG_TYPE_I16},
+    {"hx_oxi_weight", TANWA_LOG_TYPE_F32},
+    {"hx_oxi_weight_raw", TANWA_LOG_TYPE_U32},
+    // FAC
+    {"fac_status", TANWA_LOG_TYPE_U16},
+    {"fac_request", TANWA_LOG_TYPE_U8},
+    {"fac_motor_state_1", TANWA_LOG_TYPE_U8},
+    {"fac_motor_state_2", TANWA_LOG_TYPE_U8},
+    {"fac_limit_switch_1", TANWA_LOG_TYPE_U8},
+    {"fac_limit_switch_2", TANWA_LOG_TYPE_U8},
+    {"fac_limit_switch_3", TANWA_LOG_TYPE_U8},
+    {"fac_limit_switch_4", TANWA_LOG_TYPE_U8},
+    {"fac_servo_state_1", TANWA_LOG_TYPE_U8},
+    {"fac_servo_state_2", TANWA_LOG_TYPE_U8},
+    // FLC
+    {"flc_status", TANWA_LOG_TYPE_U16},
+    {"flc_request", TANWA_LOG_TYPE_U8},
+    {"flc_temperature", TANWA_LOG_TYPE_I16},
+    {"flc_temperature_1", TANWA_LOG_TYPE_I16},
+    {"flc_temperature_2", TANWA_LOG_TYPE_I16},
+    {"flc_temperature_3", TANWA_LOG_TYPE_I16},
+    {"flc_temperature_4", TANWA_LOG_TYPE_I16},
+    {"flc_pressure_1", TANWA_LOG_TYPE_I16},
+    {"flc_pressure_2", TANWA_LOG_TYPE_I16},
+    {"flc_pressure_3", TANWA_LOG_TYPE_I16},
+    {"flc_pressure_4", TANWA_LOG_TYPE_I16},
+    // TERMO
+    {"termo_status", TANWA_LOG_TYPE_U16},
+    {"termo_request", TANWA_LOG_TYPE_U8},
+    {"termo_cooling", TANWA_LOG_TYPE_FLAG},
+    {"termo_heating", TANWA_LOG_TYPE_FLAG},
+    {"termo_max_pressure", TANWA_LOG_TYPE_U8},
+    {"termo_min_pressure", TANWA_LOG_TYPE_U8},
+    {"termo_pressure", TANWA_LOG_TYPE_F32},
+    {"termo_temperature", TANWA_LOG_TYPE_F32},
+    // ESP-Now main valve
+    {"mv_pressure_1", TANWA_LOG_TYPE_F32},
+    {"mv_pressure_2", TANWA_LOG_TYPE_F32},
+    {"mv_temperature_1", TANWA_LOG_TYPE_F32},
+    {"mv_temperature_2", TANWA_LOG_TYPE_F32},
+};
+
+#define SCHEMA_FIELD_COUNT (sizeof(schema) / sizeof(schema[0]))
+
+///===-----------------------------------------------------------------------------------------===//
+/// Little-endian writer and reader, flags are packed the same way in both
+///===-----------------------------------------------------------------------------------------===//
+
+typedef struct {
+    uint8_t *buf;
+    size_t pos;
+    size_t flag_pos;
+    uint8_t flag_bit;  // 8 when there is no open flag byte
+} writer_t;
+
+static void put_bytes(writer_t *w, uint32_t value, uint8_t size) {
+    w->flag_bit = 8;
+    for (uint8_t i = 0; i < size; ++i) {
+        w->buf[w->pos++] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void put_u8(writer_t *w, uint8_t value) { put_bytes(w, value, 1); }
+static void put_u16(writer_t *w, uint16_t value) { put_bytes(w, value, 2); }
+static void put_i16(writer_t *w, int16_t value) { put_bytes(w, (uint16_t)value, 2); }
+static void put_u32(writer_t *w, uint32_t value) { put_bytes(w, value, 4); }
+
+static void put_f32(writer_t *w, float value) {
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    put_bytes(w, raw, 4);
+}
+
+static void put_flag(writer_t *w, bool value) {
+    if (w->flag_bit >= 8) {
+        w->flag_pos = w->pos;
+        w->buf[w->pos++] = 0;
+        w->flag_bit = 0;
+    }
+    if (value) {
+        w->buf[w->flag_pos] |= (uint8_t)(1 << w->flag_bit);
+    }
+    w->flag_bit++;
+}
+
+static uint32_t get_bytes(const uint8_t *buf, size_t pos, uint8_t size) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < size; ++i) {
+        value |= (uint32_t)buf[pos + i] << (8 * i);
+    }
+    return value;
+}
+
+typedef struct {
+    const uint8_t *buf;
+    size_t pos;
+    size_t flag_pos;
+    uint8_t flag_bit;
+} reader_t;
+
+static uint32_t take_bytes(reader_t *r, uint8_t size) {
+    r->flag_bit = 8;
+    uint32_t value = get_bytes(r->buf, r->pos, size);
+    r->pos += size;
+    return value;
+}
+
+static uint8_t take_u8(reader_t *r) { return (uint8_t)take_bytes(r, 1); }
+static uint16_t take_u16(reader_t *r) { return (uint16_t)take_bytes(r, 2); }
+static int16_t take_i16(reader_t *r) { return (int16_t)take_bytes(r, 2); }
+static uint32_t take_u32(reader_t *r) { return take_bytes(r, 4); }
+
+static float take_f32(reader_t *r) {
+    uint32_t raw = take_bytes(r, 4);
+    float value;
+    memcpy(&value, &raw, sizeof(value));
+    return value;
+}
+
+static bool take_flag(reader_t *r) {
+    if (r->flag_bit >= 8) {
+        r->flag_pos = r->pos++;
+        r->flag_bit = 0;
+    }
+    return (r->buf[r->flag_pos] >> r->flag_bit++) & 0x01;
+}
+
+static uint8_t type_size(uint8_t type) {
+    switch (type) {
+        case TANWA_LOG_TYPE_U8:
+            return 1;
+        case TANWA_LOG_TYPE_U16:
+        case TANWA_LOG_TYPE_I16:
+            return 2;
+        case TANWA_LOG_TYPE_U32:
+        case TANWA_LOG_TYPE_F32:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+///===-----------------------------------------------------------------------------------------===//
+
+uint16_t tanwa_log_crc16(const uint8_t *data, size_t size) {
+    return tanwa_log_crc16_update(0xFFFF, data, size);
+}
+
+uint16_t tanwa_log_crc16_update(uint16_t crc, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t tanwa_log_schema_record_size(void) {
+    size_t size = 0;
+    uint8_t flag_bit = 8;
+    for (size_t i = 0; i < SCHEMA_FIELD_COUNT; ++i) {
+        if (schema[i].type == TANWA_LOG_TYPE_FLAG) {
+            if (flag_bit >= 8) {
+                size++;
+                flag_bit = 0;
+            }
+            flag_bit++;
+        } else {
+            size += type_size(schema[i].type);
+            flag_bit = 8;
+        }
+    }
+    return size + TANWA_LOG_CRC_SIZE;
+}
+
+size_t tanwa_log_write_header(uint8_t *buffer, size_t buffer_size, uint8_t flags) {
+    // magic, version, header size, record size, field count, flags
+    size_t size = TANWA_LOG_MAGIC_SIZE + 1 + 2 + 2 + 1 + 1;
+    for (size_t i = 0; i < SCHEMA_FIELD_COUNT; ++i) {
+        size += 2 + strlen(schema[i].name);
+    }
+    size += TANWA_LOG_CRC_SIZE;
+    if (size > buffer_size) {
+        return 0;
+    }
+
+    writer_t w = {buffer, 0, 0, 8};
+    memcpy(buffer, TANWA_LOG_MAGIC, TANWA_LOG_MAGIC_SIZE);
+    w.pos = TANWA_LOG_MAGIC_SIZE;
+    put_u8(&w, TANWA_LOG_VERSION);
+    put_u16(&w, (uint16_t)size);
+    put_u16(&w, (uint16_t)tanwa_log_schema_record_size());
+    put_u8(&w, (uint8_t)SCHEMA_FIELD_COUNT);
+    put_u8(&w, flags);
+    for (size_t i = 0; i < SCHEMA_FIELD_COUNT; ++i) {
+        uint8_t name_len = (uint8_t)strlen(schema[i].name);
+        put_u8(&w, schema[i].type);
+        put_u8(&w, name_len);
+        memcpy(buffer + w.pos, schema[i].name, name_len);
+        w.pos += name_len;
+    }
+    put_u16(&w, tanwa_log_crc16(buffer, w.pos));
+
+    return w.pos;
+}
+
+size_t tanwa_log_encode_record(uint8_t *buffer, size_t buffer_size, const tanwa_log_sample_t *sample) {
+    if (buffer_size < TANWA_LOG_RECORD_SIZE) {
+        return 0;
+    }
+
+    const tanwa_data_t *d = &sample->data;
+    writer_t w = {buffer, 0, 0, 8};
+    put_u32(&w, sample->timestamp_ms);
+    put_u8(&w, d->state);
+    // COM
+    put_f32(&w, d->com_data.vbat);
+    put_flag(&w, d->com_data.abort_button);
+    put_flag(&w, d->com_data.solenoid_state_fill);
+    put_flag(&w, d->com_data.solenoid_state_depr);
+    put_flag(&w, d->com_data.igniter_cont_1);
+    put_flag(&w, d->com_data.igniter_cont_2);
+    put_f32(&w, d->com_data.pressure_1);
+    put_f32(&w, d->com_data.pressure_2);
+    put_f32(&w, d->com_data.pressure_3);
+    put_f32(&w, d->com_data.pressure_4);
+    put_f32(&w, d->com_data.temperature_1);
+    put_f32(&w, d->com_data.temperature_2);
+    // connected slaves
+    put_flag(&w, d->can_connected_slaves.hx_rocket);
+    put_flag(&w, d->can_connected_slaves.hx_oxidizer);
+    put_flag(&w, d->can_connected_slaves.fac);
+    put_flag(&w, d->can_connected_slaves.flc);
+    put_flag(&w, d->can_connected_slaves.termo);
+    // HX rocket
+    put_u16(&w, d->can_hx_rocket_status.status);
+    put_u8(&w, d->can_hx_rocket_status.request);
+    put_i16(&w, d->can_hx_rocket_status.temperature);
+    put_f32(&w, d->can_hx_rocket_data.weight);
+    put_u32(&w, d->can_hx_rocket_data.weight_raw);
+    // HX oxidizer
+    put_u16(&w, d->can_hx_oxidizer_status.status);
+    put_u8(&w, d->can_hx_oxidizer_status.request);
+    put_i16(&w, d->can_hx_oxidizer_status.temperature);
+    put_f32(&w, d->can_hx_oxidizer_data.weight);
+    put_u32(&w, d->can_hx_oxidizer_data.weight_raw);
+    // FAC
+    put_u16(&w, d->can_fac_status.status);
+    put_u8(&w, d->can_fac_status.request);
+    put_u8(&w, d->can_fac_status.motor_state_1);
+    put_u8(&w, d->can_fac_status.motor_state_2);
+    put_u8(&w, d->can_fac_status.limit_switch_1);
+    put_u8(&w, d->can_fac_status.limit_switch_2);
+    put_u8(&w, d->can_fac_status.limit_switch_3);
+    put_u8(&w, d->can_fac_status.limit_switch_4);
+    put_u8(&w, d->can_fac_status.servo_state_1);
+    put_u8(&w, d->can_fac_status.servo_state_2);
+    // FLC
+    put_u16(&w, d->can_flc_status.status);
+    put_u8(&w, d->can_flc_status.request);
+    put_i16(&w, d->can_flc_status.temperature);
+    put_i16(&w, d->can_flc_data.temperature_1);
+    put_i16(&w, d->can_flc_data.temperature_2);
+    put_i16(&w, d->can_flc_data.temperature_3);
+    put_i16(&w, d->can_flc_data.temperature_4);
+    put_i16(&w, d->can_flc_pressure_data.pressure_1);
+    put_i16(&w, d->can_flc_pressure_data.pressure_2);
+    put_i16(&w, d->can_flc_pressure_data.pressure_3);
+    put_i16(&w, d->can_flc_pressure_data.pressure_4);
+    // TERMO
+    put_u16(&w, d->can_termo_status.status);
+    put_u8(&w, d->can_termo_status.request);
+    put_flag(&w, d->can_termo_status.cooling_status);
+    put_flag(&w, d->can_termo_status.heating_status);
+    put_u8(&w, d->can_termo_status.max_pressure);
+    put_u8(&w, d->can_termo_status.min_pressure);
+    put_f32(&w, d->can_termo_data.pressure);
+    put_f32(&w, d->can_termo_data.temperature);
+    // ESP-Now main valve
+    put_f32(&w, d->now_main_valve_pressure_data.pressure_1);
+    put_f32(&w, d->now_main_valve_pressure_data.pressure_2);
+    put_f32(&w, d->now_main_valve_temperature_data.temperature_1);
+    put_f32(&w, d->now_main_valve_temperature_data.temperature_2);
+
+    put_u16(&w, tanwa_log_crc16(buffer, w.pos));
+    return w.pos;
+}
+
+bool tanwa_log_schema_is_builtin(const tanwa_log_schema_t *schema_in) {
+    if (schema_in->field_count != SCHEMA_FIELD_COUNT || schema_in->record_size != tanwa_log_schema_record_size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < SCHEMA_FIELD_COUNT; ++i) {
+        if (schema_in->fields[i].type != schema[i].type || strcmp(schema_in->fields[i].name, schema[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool tanwa_log_decode_sample(const uint8_t *record, tanwa_log_sample_t *sample) {
+    size_t crc_pos = TANWA_LOG_RECORD_SIZE - TANWA_LOG_CRC_SIZE;
+    if (tanwa_log_crc16(record, crc_pos) != (uint16_t)get_bytes(record, crc_pos, 2)) {
+        return false;
+    }
+
+    // the same order as tanwa_log_encode_record
+    memset(sample, 0, sizeof(*sample));
+    tanwa_data_t *d = &sample->data;
+    reader_t r = {record, 0, 0, 8};
+    sample->timestamp_ms = take_u32(&r);
+    d->state = take_u8(&r);
+    // COM
+    d->com_data.vbat = take_f32(&r);
+    d->com_data.abort_button = take_flag(&r);
+    d->com_data.solenoid_state_fill = take_flag(&r);
+    d->com_data.solenoid_state_depr = take_flag(&r);
+    d->com_data.igniter_cont_1 = take_flag(&r);
+    d->com_data.igniter_cont_2 = take_flag(&r);
+    d->com_data.pressure_1 = take_f32(&r);
+    d->com_data.pressure_2 = take_f32(&r);
+    d->com_data.pressure_3 = take_f32(&r);
+    d->com_data.pressure_4 = take_f32(&r);
+    d->com_data.temperature_1 = take_f32(&r);
+    d->com_data.temperature_2 = take_f32(&r);
+    // connected slaves
+    d->can_connected_slaves.hx_rocket = take_flag(&r);
+    d->can_connected_slaves.hx_oxidizer = take_flag(&r);
+    d->can_connected_slaves.fac = take_flag(&r);
+    d->can_connected_slaves.flc = take_flag(&r);
+    d->can_connected_slaves.termo = take_flag(&r);
+    // HX rocket
+    d->can_hx_rocket_status.status = take_u16(&r);
+    d->can_hx_rocket_status.request = take_u8(&r);
+    d->can_hx_rocket_status.temperature = take_i16(&r);
+    d->can_hx_rocket_data.weight = take_f32(&r);
+    d->can_hx_rocket_data.weight_raw = take_u32(&r);
+    // HX oxidizer
+    d->can_hx_oxidizer_status.status = take_u16(&r);
+    d->can_hx_oxidizer_status.request = take_u8(&r);
+    d->can_hx_oxidizer_status.temperature = take_i16(&r);
+    d->can_hx_oxidizer_data.weight = take_f32(&r);
+    d->can_hx_oxidizer_data.weight_raw = take_u32(&r);
+    // FAC
+    d->can_fac_status.status = take_u16(&r);
+    d->can_fac_status.request = take_u8(&r);
+    d->can_fac_status.motor_state_1 = take_u8(&r);
+    d->can_fac_status.motor_state_2 = take_u8(&r);
+    d->can_fac_status.limit_switch_1 = take_u8(&r);
+    d->can_fac_status.limit_switch_2 = take_u8(&r);
+    d->can_fac_status.limit_switch_3 = take_u8(&r);
+    d->can_fac_status.limit_switch_4 = take_u8(&r);
+    d->can_fac_status.servo_state_1 = take_u8(&r);
+    d->can_fac_status.servo_state_2 = take_u8(&r);
+    // FLC
+    d->can_flc_status.status = take_u16(&r);
+    d->can_flc_status.request = take_u8(&r);
+    d->can_flc_status.temperature = take_i16(&r);
+    d->can_flc_data.temperature_1 = take_i16(&r);
+    d->can_flc_data.temperature_2 = take_i16(&r);
+    d->can_flc_data.temperature_3 = take_i16(&r);
+    d->can_flc_data.temperature_4 = take_i16(&r);
+    d->can_flc_pressure_data.pressure_1 = take_i16(&r);
+    d->can_flc_pressure_data.pressure_2 = take_i16(&r);
+    d->can_flc_pressure_data.pressure_3 = take_i16(&r);
+    d->can_flc_pressure_data.pressure_4 = take_i16(&r);
+    // TERMO
+    d->can_termo_status.status = take_u16(&r);
+    d->can_termo_status.request = take_u8(&r);
+    d->can_termo_status.cooling_status = take_flag(&r);
+    d->can_termo_status.heating_status = take_flag(&r);
+    d->can_termo_status.max_pressure = take_u8(&r);
+    d->can_termo_status.min_pressure = take_u8(&r);
+    d->can_termo_data.pressure = take_f32(&r);
+    d->can_termo_data.temperature = take_f32(&r);
+    // ESP-Now main valve
+    d->now_main_valve_pressure_data.pressure_1 = take_f32(&r);
+    d->now_main_valve_pressure_data.pressure_2 = take_f32(&r);
+    d->now_main_valve_temperature_data.temperature_1 = take_f32(&r);
+    d->now_main_valve_temperature_data.temperature_2 = take_f32(&r);
+    return true;
+}
+
+bool tanwa_log_parse_header(const uint8_t *buffer, size_t size, tanwa_log_schema_t *schema_out) {
+    const size_t fixed_size = TANWA_LOG_MAGIC_SIZE + 1 + 2 + 2 + 1;
+    if (size < fixed_size + TANWA_LOG_CRC_SIZE || memcmp(buffer, TANWA_LOG_MAGIC, TANWA_LOG_MAGIC_SIZE) != 0) {
+        return false;
+    }
+
+    size_t pos = TANWA_LOG_MAGIC_SIZE;
+    schema_out->version = buffer[pos++];
+    schema_out->header_size = (uint16_t)get_bytes(buffer, pos, 2);
+    pos += 2;
+    schema_out->record_size = (uint16_t)get_bytes(buffer, pos, 2);
+    pos += 2;
+    schema_out->field_count = buffer[pos++];
+    // version 1 has no flags
+    schema_out->flags = schema_out->version >= 2 ? buffer[pos++] : 0;
+    if (schema_out->header_size > size || schema_out->header_size < fixed_size + TANWA_LOG_CRC_SIZE ||
+        schema_out->field_count > TANWA_LOG_MAX_FIELDS) {
+        return false;
+    }
+
+    size_t crc_pos = schema_out->header_size - TANWA_LOG_CRC_SIZE;
+    if (tanwa_log_crc16(buffer, crc_pos) != (uint16_t)get_bytes(buffer, crc_pos, 2)) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < schema_out->field_count; ++i) {
+        if (pos + 2 > crc_pos) {
+            return false;
+        }
+        uint8_t type = buffer[pos++];
+        uint8_t name_len = buffer[pos++];
+        if (pos + name_len > crc_pos || name_len > TANWA_LOG_MAX_NAME_LEN) {
+            return false;
+        }
+        schema_out->fields[i].type = type;
+        memcpy(schema_out->fields[i].name, buffer + pos, name_len);
+        schema_out->fields[i].name[name_len] = '\0';
+        pos += name_len;
+    }
+
+    return true;
+}
+
+bool tanwa_log_decode_record(const tanwa_log_schema_t *schema_in, const uint8_t *record, tanwa_log_value_t *values) {
+    size_t crc_pos = schema_in->record_size - TANWA_LOG_CRC_SIZE;
+    if (tanwa_log_crc16(record, crc_pos) != (uint16_t)get_bytes(record, crc_pos, 2)) {
+        return false;
+    }
+
+    size_t pos = 0;
+    size_t flag_pos = 0;
+    uint8_t flag_bit = 8;
+    for (uint8_t i = 0; i < schema_in->field_count; ++i) {
+        uint8_t type = schema_in->fields[i].type;
+        if (type == TANWA_LOG_TYPE_FLAG) {
+            if (flag_bit >= 8) {
+                flag_pos = pos++;
+                flag_bit = 0;
+            }
+            values[i].u = (record[flag_pos] >> flag_bit) & 0x01;
+            flag_bit++;
+            continue;
+        }
+
+        flag_bit = 8;
+        uint8_t size = type_size(type);
+        if (size == 0 || pos + size > crc_pos) {
+            return false;
+        }
+        uint32_t raw = get_bytes(record, pos, size);
+        pos += size;
+        switch (type) {
+            case TANWA_LOG_TYPE_I16:
+                values[i].i = (int16_t)raw;
+                break;
+            case TANWA_LOG_TYPE_F32:
+                memcpy(&values[i].f, &raw, sizeof(float));
+                break;
+            default:
+                values[i].u = raw;
+                break;
+        }
+    }
+
+    return true;
+}
+
+///===-----------------------------------------------------------------------------------------===//
+/// Frames
+///===-----------------------------------------------------------------------------------------===//
+
+void tanwa_log_frame_begin(uint8_t *header, uint8_t type, uint32_t sequence, uint16_t length) {
+    writer_t w = {header, 0, 0, 8};
+    put_u16(&w, TANWA_LOG_FRAME_SYNC);
+    put_u8(&w, type);
+    put_u8(&w, 0);
+    put_u32(&w, sequence);
+    put_u16(&w, length);
+}
+
+void tanwa_log_frame_end(const uint8_t *header, const uint8_t *payload, uint16_t length, uint8_t *trailer) {
+    // the sync word is left out, it is the same in every frame
+    uint16_t crc = tanwa_log_crc16(header + 2, TANWA_LOG_FRAME_HEADER_SIZE - 2);
+    crc = tanwa_log_crc16_update(crc, payload, length);
+    writer_t w = {trailer, 0, 0, 8};
+    put_u16(&w, crc);
+}
+
+void tanwa_log_scanner_init(tanwa_log_scanner_t *scanner, size_t offset, tanwa_log_frame_handler_t handler,
+                            void *context) {
+    memset(scanner, 0, sizeof(*scanner));
+    scanner->offset = offset;
+    scanner->handler = handler;
+    scanner->context = context;
+}
+
+size_t tanwa_log_scanner_feed(tanwa_log_scanner_t *scanner, const uint8_t *data, size_t size, bool end) {
+    size_t pos = 0;
+    while (pos < size) {
+        size_t left = size - pos;
+        const uint8_t *frame = data + pos;
+        if (left >= 2 && get_bytes(frame, 0, 2) != TANWA_LOG_FRAME_SYNC) {
+            scanner->skipped_bytes++;
+            pos++;
+            continue;
+        }
+
+        size_t length = left >= TANWA_LOG_FRAME_HEADER_SIZE ? get_bytes(frame, 8, 2) : 0;
+        size_t total = TANWA_LOG_FRAME_OVERHEAD + length;
+        if (left < TANWA_LOG_FRAME_HEADER_SIZE || (length <= TANWA_LOG_FRAME_MAX_PAYLOAD && left < total)) {
+            if (end == false) {
+                break;
+            }
+            scanner->skipped_bytes++;
+            pos++;
+            continue;
+        }
+
+        uint8_t trailer[TANWA_LOG_CRC_SIZE];
+        if (length <= TANWA_LOG_FRAME_MAX_PAYLOAD) {
+            tanwa_log_frame_end(frame, frame + TANWA_LOG_FRAME_HEADER_SIZE, (uint16_t)length, trailer);
+        }
+        if (length > TANWA_LOG_FRAME_MAX_PAYLOAD ||
+            memcmp(trailer, frame + TANWA_LOG_FRAME_HEADER_SIZE + length, TANWA_LOG_CRC_SIZE) != 0) {
+            scanner->skipped_bytes++;
+            pos++;
+            continue;
+        }
+
+        tanwa_log_frame_t valid = {
+            .type = frame[2],
+            .sequence = get_bytes(frame, 4, 4),
+            .length = (uint16_t)length,
+            .payload = frame + TANWA_LOG_FRAME_HEADER_SIZE,
+        };
+        if (scanner->frames == 0) {
+            scanner->first_sequence = valid.sequence;
+        } else if (valid.sequence > scanner->last_sequence + 1) {
+            scanner->sequence_gaps += valid.sequence - scanner->last_sequence - 1;
+        }
+        scanner->last_sequence = valid.sequence;
+        scanner->frames++;
+        if (scanner->handler != NULL) {
+            scanner->handler(scanner->context, &valid, scanner->offset + pos);
+        }
+        pos += total;
+        scanner->valid_end = scanner->offset + pos;
+    }
+
+    scanner->offset += pos;
+    return pos;
+}
+
+///===-----------------------------------------------------------------------------------------===//
+/// Session index
+///===-----------------------------------------------------------------------------------------===//
+
+size_t tanwa_log_write_index_header(uint8_t *buffer, size_t buffer_size) {
+    if (buffer_size < TANWA_LOG_INDEX_HEADER_SIZE) {
+        return 0;
+    }
+
+    memset(buffer, 0, TANWA_LOG_INDEX_HEADER_SIZE);
+    memcpy(buffer, TANWA_LOG_INDEX_MAGIC, TANWA_LOG_MAGIC_SIZE);
+    writer_t w = {buffer, TANWA_LOG_MAGIC_SIZE, 0, 8};
+    put_u8(&w, TANWA_LOG_INDEX_VERSION);
+    put_u8(&w, TANWA_LOG_INDEX_ENTRY_SIZE);
+    w.pos = TANWA_LOG_INDEX_HEADER_SIZE - TANWA_LOG_CRC_SIZE;
+    put_u16(&w, tanwa_log_crc16(buffer, w.pos));
+    return TANWA_LOG_INDEX_HEADER_SIZE;
+}
+
+bool tanwa_log_check_index_header(const uint8_t *buffer, size_t size) {
+    if (size < TANWA_LOG_INDEX_HEADER_SIZE || memcmp(buffer, TANWA_LOG_INDEX_MAGIC, TANWA_LOG_MAGIC_SIZE) != 0) {
+        return false;
+    }
+    if (buffer[TANWA_LOG_MAGIC_SIZE + 1] != TANWA_LOG_INDEX_ENTRY_SIZE) {
+        return false;
+    }
+
+    size_t crc_pos = TANWA_LOG_INDEX_HEADER_SIZE - TANWA_LOG_CRC_SIZE;
+    return tanwa_log_crc16(buffer, crc_pos) == (uint16_t)get_bytes(buffer, crc_pos, 2);
+}
+
+size_t tanwa_log_encode_index_entry(uint8_t *buffer, size_t buffer_size, const tanwa_log_index_entry_t *entry) {
+    if (buffer_size < TANWA_LOG_INDEX_ENTRY_SIZE) {
+        return 0;
+    }
+
+    memset(buffer, 0, TANWA_LOG_INDEX_ENTRY_SIZE);
+    writer_t w = {buffer, 0, 0, 8};
+    put_u32(&w, entry->segment);
+    put_u32(&w, entry->record_count);
+    put_u32(&w, entry->first_timestamp_ms);
+    put_u32(&w, entry->last_timestamp_ms);
+    put_u32(&w, entry->size);
+    put_u8(&w, entry->first_state);
+    put_u8(&w, entry->last_state);
+    put_u8(&w, entry->flags);
+    // the rest is reserved
+    w.pos = TANWA_LOG_INDEX_ENTRY_SIZE - TANWA_LOG_CRC_SIZE;
+    put_u16(&w, tanwa_log_crc16(buffer, w.pos));
+    return TANWA_LOG_INDEX_ENTRY_SIZE;
+}
+
+bool tanwa_log_decode_index_entry(const uint8_t *buffer, tanwa_log_index_entry_t *entry) {
+    size_t crc_pos = TANWA_LOG_INDEX_ENTRY_SIZE - TANWA_LOG_CRC_SIZE;
+    if (tanwa_log_crc16(buffer, crc_pos) != (uint16_t)get_bytes(buffer, crc_pos, 2)) {
+        return false;
+    }
+
+    entry->segment = get_bytes(buffer, 0, 4);
+    entry->record_count = get_bytes(buffer, 4, 4);
+    entry->first_timestamp_ms = get_bytes(buffer, 8, 4);
+    entry->last_timestamp_ms = get_bytes(buffer, 12, 4);
+    entry->size = get_bytes(buffer, 16, 4);
+    entry->first_state = buffer[20];
+    entry->last_state = buffer[21];
+    entry->flags = buffer[22];
+    return true;
+}
+
+size_t tanwa_log_encode_backpressure(uint8_t *buffer, size_t buffer_size, const tanwa_log_backpressure_t *backpressure) {
+    if (buffer_size < TANWA_LOG_BACKPRESSURE_SIZE) {
+        return 0;
+    }
+
+    writer_t w = {buffer, 0, 0, 8};
+    put_u32(&w, backpressure->timestamp_ms);
+    put_u32(&w, backpressure->interval_ms);
+    put_u8(&w, backpressure->policy);
+    put_u8(&w, backpressure->decimation);
+    put_u16(&w, 0);
+    put_u32(&w, backpressure->produced);
+    put_u32(&w, backpressure->decimated);
+    put_u32(&w, backpressure->dropped);
+    put_u32(&w, backpressure->written);
+    return w.pos;
+}
+
+bool tanwa_log_decode_backpressure(const uint8_t *buffer, size_t size, tanwa_log_backpressure_t *backpressure) {
+    if (size != TANWA_LOG_BACKPRESSURE_SIZE) {
+        return false;
+    }
+
+    backpressure->timestamp_ms = get_bytes(buffer, 0, 4);
+    backpressure->interval_ms = get_bytes(buffer, 4, 4);
+    backpressure->policy = (uint8_t)get_bytes(buffer, 8, 1);
+    backpressure->decimation = (uint8_t)get_bytes(buffer, 9, 1);
+    backpressure->produced = get_bytes(buffer, 12, 4);
+    backpressure->decimated = get_bytes(buffer, 16, 4);
+    backpressure->dropped = get_bytes(buffer, 20, 4);
+    backpressure->written = get_bytes(buffer, 24, 4);
+    return true;
+}
+
+void tanwa_log_encode_ring_block(uint8_t *buffer, const tanwa_log_ring_block_t *block) {
+    writer_t w = {buffer, 0, 0, 8};
+    put_u16(&w, TANWA_LOG_RING_BLOCK_MAGIC);
+    put_u16(&w, block->used);
+    put_u32(&w, block->ring_id);
+    put_u32(&w, block->sequence);
+    put_u16(&w, 0);
+    put_u16(&w, tanwa_log_crc16(buffer, w.pos));
+}
+
+bool tanwa_log_decode_ring_block(const uint8_t *buffer, tanwa_log_ring_block_t *block) {
+    size_t crc_pos = TANWA_LOG_RING_BLOCK_HEADER_SIZE - TANWA_LOG_CRC_SIZE;
+    if (get_bytes(buffer, 0, 2) != TANWA_LOG_RING_BLOCK_MAGIC ||
+        tanwa_log_crc16(buffer, crc_pos) != (uint16_t)get_bytes(buffer, crc_pos, 2)) {
+        return false;
+    }
+
+    block->used = (uint16_t)get_bytes(buffer, 2, 2);
+    block->ring_id = get_bytes(buffer, 4, 4);
+    block->sequence = get_bytes(buffer, 8, 4);
+    return block->used <= TANWA_LOG_RING_BLOCK_SIZE;
+}
+
+size_t tanwa_log_index_find(const tanwa_log_index_entry_t *entries, size_t count, uint32_t timestamp_ms) {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (entries[mid].last_timestamp_ms < timestamp_ms) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
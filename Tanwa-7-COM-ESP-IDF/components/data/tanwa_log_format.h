@@ -0,0 +1,314 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the binary telemetry log format. Every data file starts with
+/// a self-describing schema header, followed by fixed-size little-endian records of the TANWA
+/// data, each with a timestamp and CRC16-CCITT. Since version 3 every record (or compressed
+/// block) is wrapped in a frame with a sync word, sequence number and CRC, so a torn write can be
+/// found and skipped. The file does not depend on ESP-IDF, so it is also compiled into the host
+/// side decoder in the tools directory.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_TANWA_LOG_FORMAT_H_
+#define PWRINSPACE_TANWA_LOG_FORMAT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "TANWA_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TANWA_LOG_MAGIC "TNWLOG"
+#define TANWA_LOG_MAGIC_SIZE 6
+#define TANWA_LOG_VERSION 5  // version 2 adds the flags byte, version 3 the frames, version 4 the backpressure frames,
+                             // version 5 the summary frames
+
+#define TANWA_LOG_MAX_FIELDS 96
+#define TANWA_LOG_MAX_NAME_LEN 31
+#define TANWA_LOG_HEADER_MAX_SIZE 2048
+
+// timestamp + payload + CRC16, checked against the schema at runtime
+#define TANWA_LOG_RECORD_SIZE 125
+#define TANWA_LOG_CRC_SIZE 2
+
+// records follow the header in record_codec blocks instead of one by one
+#define TANWA_LOG_FLAG_COMPRESSED 0x01
+
+// Frame: u16 sync word, u8 type, u8 reserved, u32 sequence, u16 length, payload, CRC16 of all
+// but the sync word
+#define TANWA_LOG_FRAME_SYNC 0xA55A
+#define TANWA_LOG_FRAME_HEADER_SIZE 10
+#define TANWA_LOG_FRAME_OVERHEAD (TANWA_LOG_FRAME_HEADER_SIZE + TANWA_LOG_CRC_SIZE)
+#define TANWA_LOG_FRAME_MAX_PAYLOAD 4096
+#define TANWA_LOG_FRAME_RECORD 1
+#define TANWA_LOG_FRAME_BLOCK 2  // record_codec block
+#define TANWA_LOG_FRAME_BACKPRESSURE 3  // tanwa_log_backpressure_t
+#define TANWA_LOG_FRAME_SUMMARY 4  // record_summary of an interval
+#define TANWA_LOG_BACKPRESSURE_SIZE 28
+
+// Session directory layout, one index entry per data segment
+#define TANWA_LOG_SEGMENT_NAME "seg%04u.bin"
+#define TANWA_LOG_INDEX_NAME "index.bin"
+#define TANWA_LOG_INDEX_MAGIC "TNWIDX"
+#define TANWA_LOG_INDEX_VERSION 1
+#define TANWA_LOG_INDEX_HEADER_SIZE 32
+#define TANWA_LOG_INDEX_ENTRY_SIZE 32
+#define TANWA_LOG_INDEX_FLAG_CLOSED 0x01
+
+// Circular file of the recent full-rate records. Block 0 starts with the schema header and ends
+// with the ring descriptor (a block header with no frames, its sequence is the number of ring
+// blocks). Block sequence s is written to block 1 + s % count. Block: u16 magic, u16 used bytes
+// including the header, u32 ring id, u32 block sequence, u16 reserved, u16 CRC16 of the header,
+// frames, zero padding.
+#define TANWA_LOG_RING_NAME "recent.bin"
+#define TANWA_LOG_FROZEN_NAME "frz%04u.bin"
+#define TANWA_LOG_RING_BLOCK_SIZE 4096
+#define TANWA_LOG_RING_BLOCK_HEADER_SIZE 16
+#define TANWA_LOG_RING_BLOCK_MAGIC 0x5254
+
+typedef enum {
+    TANWA_LOG_TYPE_U8 = 1,
+    TANWA_LOG_TYPE_U16 = 2,
+    TANWA_LOG_TYPE_I16 = 3,
+    TANWA_LOG_TYPE_U32 = 4,
+    TANWA_LOG_TYPE_F32 = 5,
+    // single bit, consecutive flags share one byte (up to 8), any other field closes the byte
+    TANWA_LOG_TYPE_FLAG = 6,
+} tanwa_log_type_t;
+
+typedef struct {
+    uint8_t type;
+    char name[TANWA_LOG_MAX_NAME_LEN + 1];
+} tanwa_log_field_t;
+
+typedef struct {
+    uint8_t version;
+    uint16_t header_size;
+    uint16_t record_size;
+    uint8_t field_count;
+    uint8_t flags;
+    tanwa_log_field_t fields[TANWA_LOG_MAX_FIELDS];
+} tanwa_log_schema_t;
+
+typedef union {
+    uint32_t u;
+    int32_t i;
+    float f;
+} tanwa_log_value_t;
+
+/**
+ * @brief Sample queued for the SD card, the TANWA data with the time it was taken
+ */
+typedef struct {
+    uint32_t timestamp_ms;
+    tanwa_data_t data;
+} tanwa_log_sample_t;
+
+/**
+ * @brief Index entry of one data segment
+ *
+ * @note Entry i is stored at TANWA_LOG_INDEX_HEADER_SIZE + i * TANWA_LOG_INDEX_ENTRY_SIZE and is
+ *       rewritten in place while the segment grows, the closed flag is set after the last write.
+ */
+typedef struct {
+    uint32_t segment;
+    uint32_t record_count;
+    uint32_t first_timestamp_ms;
+    uint32_t last_timestamp_ms;
+    uint32_t size;
+    uint8_t first_state;
+    uint8_t last_state;
+    uint8_t flags;
+} tanwa_log_index_entry_t;
+
+/**
+ * @brief Sample accounting since the previous backpressure frame
+ *
+ * @note Written when the decimation changes, before the first record taken with the new factor,
+ *       and about once per second. Sums of all frames of the session are the session totals.
+ */
+typedef struct {
+    uint32_t timestamp_ms;
+    uint32_t interval_ms;
+    uint8_t policy;
+    uint8_t decimation;  // log2 of the factor of the records that follow
+    uint32_t produced;
+    uint32_t decimated;  // skipped by the policy
+    uint32_t dropped;  // lost on the full queue or spill buffer
+    uint32_t written;
+} tanwa_log_backpressure_t;
+
+typedef struct {
+    uint16_t used;
+    uint32_t ring_id;
+    uint32_t sequence;
+} tanwa_log_ring_block_t;
+
+typedef struct {
+    uint8_t type;
+    uint32_t sequence;
+    uint16_t length;
+    const uint8_t *payload;
+} tanwa_log_frame_t;
+
+/**
+ * @brief Called for every valid frame found by the scanner
+ * @param offset file offset of the frame
+ */
+typedef void (*tanwa_log_frame_handler_t)(void *context, const tanwa_log_frame_t *frame, size_t offset);
+
+/**
+ * @brief Frame scanner, fed with consecutive parts of the file
+ *
+ * @note Bytes that are not a part of a valid frame are skipped one by one until the next sync
+ *       word with a matching CRC, so the scanner can also start in the middle of the file.
+ */
+typedef struct {
+    size_t offset;  // file offset of the next byte fed
+    size_t valid_end;  // file offset after the last valid frame, 0 if there was none
+    uint32_t frames;
+    uint32_t first_sequence;
+    uint32_t last_sequence;
+    uint32_t sequence_gaps;  // frames missing between the valid ones
+    uint32_t skipped_bytes;
+    tanwa_log_frame_handler_t handler;
+    void *context;
+} tanwa_log_scanner_t;
+
+uint16_t tanwa_log_crc16(const uint8_t *data, size_t size);
+
+uint16_t tanwa_log_crc16_update(uint16_t crc, const uint8_t *data, size_t size);
+
+/**
+ * @brief Size of the record described by the built-in schema
+ */
+size_t tanwa_log_schema_record_size(void);
+
+/**
+ * @brief Write the schema header of the built-in record layout
+ * @param flags TANWA_LOG_FLAG_x
+ * @return number of bytes written, 0 if the buffer is too small
+ */
+size_t tanwa_log_write_header(uint8_t *buffer, size_t buffer_size, uint8_t flags);
+
+/**
+ * @brief Encode the sample to the record
+ * @return TANWA_LOG_RECORD_SIZE, 0 if the buffer is too small
+ */
+size_t tanwa_log_encode_record(uint8_t *buffer, size_t buffer_size, const tanwa_log_sample_t *sample);
+
+/**
+ * @brief Check if the schema is the built-in record layout, only its records decode to samples
+ */
+bool tanwa_log_schema_is_builtin(const tanwa_log_schema_t *schema);
+
+/**
+ * @brief Decode the record of the built-in layout back to the sample
+ * @return false if the CRC does not match
+ */
+bool tanwa_log_decode_sample(const uint8_t *record, tanwa_log_sample_t *sample);
+
+/**
+ * @brief Parse the schema header from the beginning of the file
+ * @return false if the header is not valid
+ */
+bool tanwa_log_parse_header(const uint8_t *buffer, size_t size, tanwa_log_schema_t *schema);
+
+/**
+ * @brief Check the CRC of the record and decode all fields of the schema
+ * @param values array of schema->field_count values
+ * @return false if the CRC does not match
+ */
+bool tanwa_log_decode_record(const tanwa_log_schema_t *schema, const uint8_t *record, tanwa_log_value_t *values);
+
+/**
+ * @brief Write the frame header
+ * @param header buffer of TANWA_LOG_FRAME_HEADER_SIZE
+ */
+void tanwa_log_frame_begin(uint8_t *header, uint8_t type, uint32_t sequence, uint16_t length);
+
+/**
+ * @brief Write the frame CRC, the payload does not have to be next to the header
+ * @param trailer buffer of TANWA_LOG_CRC_SIZE
+ */
+void tanwa_log_frame_end(const uint8_t *header, const uint8_t *payload, uint16_t length, uint8_t *trailer);
+
+/**
+ * @param offset file offset of the first byte that will be fed
+ * @param handler can be NULL
+ */
+void tanwa_log_scanner_init(tanwa_log_scanner_t *scanner, size_t offset, tanwa_log_frame_handler_t handler,
+                            void *context);
+
+/**
+ * @brief Scan the next part of the file
+ *
+ * @note A frame that continues past the data is left for the next call, keep the rest of the data
+ *       and append the next part to it. The buffer has to fit the longest frame.
+ *
+ * @param end no more data follows, an unfinished frame is garbage
+ * @return number of consumed bytes
+ */
+size_t tanwa_log_scanner_feed(tanwa_log_scanner_t *scanner, const uint8_t *data, size_t size, bool end);
+
+/**
+ * @brief Write the header of the session index file
+ * @return TANWA_LOG_INDEX_HEADER_SIZE, 0 if the buffer is too small
+ */
+size_t tanwa_log_write_index_header(uint8_t *buffer, size_t buffer_size);
+
+bool tanwa_log_check_index_header(const uint8_t *buffer, size_t size);
+
+/**
+ * @brief Encode the index entry with its CRC16
+ * @return TANWA_LOG_INDEX_ENTRY_SIZE, 0 if the buffer is too small
+ */
+size_t tanwa_log_encode_index_entry(uint8_t *buffer, size_t buffer_size, const tanwa_log_index_entry_t *entry);
+
+/**
+ * @return false if the CRC does not match
+ */
+bool tanwa_log_decode_index_entry(const uint8_t *buffer, tanwa_log_index_entry_t *entry);
+
+/**
+ * @brief Encode the payload of the backpressure frame
+ * @return TANWA_LOG_BACKPRESSURE_SIZE, 0 if the buffer is too small
+ */
+size_t tanwa_log_encode_backpressure(uint8_t *buffer, size_t buffer_size, const tanwa_log_backpressure_t *backpressure);
+
+/**
+ * @return false if the payload size does not match
+ */
+bool tanwa_log_decode_backpressure(const uint8_t *buffer, size_t size, tanwa_log_backpressure_t *backpressure);
+
+/**
+ * @brief Encode the header of the ring block
+ * @param buffer buffer of TANWA_LOG_RING_BLOCK_HEADER_SIZE
+ */
+void tanwa_log_encode_ring_block(uint8_t *buffer, const tanwa_log_ring_block_t *block);
+
+/**
+ * @return false if the magic or CRC does not match
+ */
+bool tanwa_log_decode_ring_block(const uint8_t *buffer, tanwa_log_ring_block_t *block);
+
+/**
+ * @brief Binary search of the first segment that ends at or after the timestamp
+ * @return index of the entry, count if all segments end before the timestamp
+ */
+size_t tanwa_log_index_find(const tanwa_log_index_entry_t *entries, size_t count, uint32_t timestamp_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PWRINSPACE_TANWA_LOG_FORMAT_H_ */
@@ -7,6 +7,9 @@
 
 #include "TANWA_config.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "esp_log.h"
 
 #include "mcu_gpio_config.h"
@@ -22,6 +25,22 @@
 
 #define IOEXP_MODE (IOCON_INTCC | IOCON_INTPOL | IOCON_ODR | IOCON_MIRROR)
 
+// NVS keys of the calibration tables, indexed by TANWA_calibration_channel_t
+static const char* calibration_keys[TANWA_CALIBRATION_COUNT] = {
+    "pressure_1",
+    "pressure_2",
+    "pressure_3",
+    "pressure_4",
+    "vbat",
+};
+
+// Battery voltage calibration, raw ADC value to volts, the divider is used when not calibrated
+static calibration_channel_t vbat_calibration = {
+    .type = CALIBRATION_TYPE_NONE,
+};
+// Guards vbat_calibration, the measure task reads it while the console task replaces it
+static SemaphoreHandle_t vbat_calibration_mutex = NULL;
+
 TANWA_hardware_t TANWA_hardware = {
     .esp_led = {
         ._gpio_set_level = _mcu_gpio_set_level,
@@ -73,6 +92,9 @@ TANWA_hardware_t TANWA_hardware = {
             .gpio_num_fire = FIRE_1_GPIO_INDEX,
             .drive = IGNITER_DRIVE_POSITIVE,
             .state = IGNITER_STATE_WAITING,
+            .continuity = IGNITER_CONTINUITY_FAIL,
+            .continuity_debounce = 0,
+            .continuity_raw = 0,
         },
         {
             ._adc_analog_read_raw = _mcu_adc_read_raw,
@@ -83,6 +105,9 @@ TANWA_hardware_t TANWA_hardware = {
             .gpio_num_fire = FIRE_2_GPIO_INDEX,
             .drive = IGNITER_DRIVE_POSITIVE,
             .state = IGNITER_STATE_WAITING,
+            .continuity = IGNITER_CONTINUITY_FAIL,
+            .continuity_debounce = 0,
+            .continuity_raw = 0,
         },
     },
     .buzzer = {
@@ -101,6 +126,7 @@ TANWA_utility_t TANWA_utility = {
     },
     .pressure_driver = PRESSURE_DRIVER_TANWA_CONFIG(&TANWA_hardware.ads1115),
     .solenoid_driver = SOLENOID_DRIVER_TANWA_CONFIG(&TANWA_hardware.pca9574),
+    .temperature_driver = TEMPERATURE_DRIVER_TANWA_CONFIG(&TANWA_hardware.tmp1075[0], &TANWA_hardware.tmp1075[1]),
 };
 
 esp_err_t TANWA_mcu_config_init() {
@@ -185,6 +211,11 @@ esp_err_t TANWA_hardware_init() {
 
 esp_err_t TANWA_utility_init() {
     uint8_t ret = 0;
+    vbat_calibration_mutex = xSemaphoreCreateMutex();
+    if (vbat_calibration_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create VBAT calibration mutex");
+        return ESP_FAIL;
+    }
     ret = led_state_display_state_update(&(TANWA_utility.led_state_display), LED_STATE_DISPLAY_STATE_IDLE);
     if (ret != LED_STATE_DISPLAY_OK) {
         ESP_LOGE(TAG, "Failed to initialize LED state display");
@@ -206,6 +237,13 @@ esp_err_t TANWA_utility_init() {
     } else {
         ESP_LOGI(TAG, "Solenoid driver initialized");
     }
+    ret = temperature_driver_init(&(TANWA_utility.temperature_driver));
+    if (ret != TEMPERATURE_DRIVER_OK) {
+        ESP_LOGE(TAG, "Failed to initialize temperature driver");
+        return ESP_FAIL;
+    } else {
+        ESP_LOGI(TAG, "Temperature driver initialized");
+    }
     return ESP_OK;
 }
 
@@ -279,6 +317,19 @@ esp_err_t TANWA_esp_now_init() {
 // }
 
 esp_err_t TANWA_get_vbat(float* vbat){
+    // the console task can replace the calibration, apply a consistent copy
+    calibration_channel_t calibration;
+    xSemaphoreTake(vbat_calibration_mutex, portMAX_DELAY);
+    memcpy(&calibration, &vbat_calibration, sizeof(calibration_channel_t));
+    xSemaphoreGive(vbat_calibration_mutex);
+    if (calibration_is_valid(&calibration)) {
+        uint16_t raw;
+        if (!_mcu_adc_read_raw(VBAT_CHANNEL_INDEX, &raw)) {
+            ESP_LOGE(TAG, "Failed to read VBAT voltage");
+            return ESP_FAIL;
+        }
+        return calibration_apply(&calibration, raw, vbat) == CALIBRATION_OK ? ESP_OK : ESP_FAIL;
+    }
     float voltage;
     if (!_mcu_adc_read_voltage(VBAT_CHANNEL_INDEX, &voltage)) {
         ESP_LOGE(TAG, "Failed to read VBAT voltage");
@@ -286,4 +337,107 @@ esp_err_t TANWA_get_vbat(float* vbat){
     }
     *vbat = voltage * 11.0f; // (10k + 50k) / 10k (voltage divider)
     return ESP_OK;
+}
+
+static esp_err_t TANWA_calibration_apply(TANWA_calibration_channel_t channel, const calibration_channel_t* calibration) {
+    if (channel == TANWA_CALIBRATION_VBAT) {
+        xSemaphoreTake(vbat_calibration_mutex, portMAX_DELAY);
+        if (calibration == NULL) {
+            vbat_calibration.type = CALIBRATION_TYPE_NONE;
+        } else {
+            memcpy(&vbat_calibration, calibration, sizeof(calibration_channel_t));
+        }
+        xSemaphoreGive(vbat_calibration_mutex);
+        return ESP_OK;
+    }
+    pressure_driver_sensor_t sensor = (pressure_driver_sensor_t)(channel - TANWA_CALIBRATION_PRESSURE_1);
+    if (pressure_driver_set_calibration(&(TANWA_utility.pressure_driver), sensor, calibration) != PRESSURE_DRIVER_OK) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t TANWA_calibration_init() {
+    calibration_channel_t calibration;
+    for (int i = 0; i < TANWA_CALIBRATION_COUNT; ++i) {
+        calibration_status_t ret = calibration_load(calibration_keys[i], &calibration, NULL);
+        if (ret == CALIBRATION_NOT_FOUND) {
+            continue;
+        } else if (ret != CALIBRATION_OK) {
+            ESP_LOGE(TAG, "Failed to load %s calibration", calibration_keys[i]);
+            continue;
+        }
+        if (TANWA_calibration_apply(i, &calibration) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to apply %s calibration", calibration_keys[i]);
+        } else {
+            ESP_LOGI(TAG, "Calibration %s loaded", calibration_keys[i]);
+        }
+    }
+    return ESP_OK;
+}
+
+const char* TANWA_calibration_get_name(TANWA_calibration_channel_t channel) {
+    if (channel >= TANWA_CALIBRATION_COUNT) {
+        return "unknown";
+    }
+    return calibration_keys[channel];
+}
+
+esp_err_t TANWA_calibration_read_raw(TANWA_calibration_channel_t channel, int32_t* raw) {
+    if (channel >= TANWA_CALIBRATION_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (channel == TANWA_CALIBRATION_VBAT) {
+        uint16_t adc_raw;
+        if (!_mcu_adc_read_raw(VBAT_CHANNEL_INDEX, &adc_raw)) {
+            return ESP_FAIL;
+        }
+        *raw = adc_raw;
+        return ESP_OK;
+    }
+    int16_t ads_raw;
+    pressure_driver_sensor_t sensor = (pressure_driver_sensor_t)(channel - TANWA_CALIBRATION_PRESSURE_1);
+    if (pressure_driver_read_raw(&(TANWA_utility.pressure_driver), sensor, &ads_raw) != PRESSURE_DRIVER_OK) {
+        return ESP_FAIL;
+    }
+    *raw = ads_raw;
+    return ESP_OK;
+}
+
+esp_err_t TANWA_calibration_commit(TANWA_calibration_channel_t channel, const calibration_table_t* table) {
+    if (channel >= TANWA_CALIBRATION_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    calibration_channel_t calibration;
+    if (calibration_compute(table, &calibration) != CALIBRATION_OK) {
+        ESP_LOGE(TAG, "Invalid %s calibration table", calibration_keys[channel]);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (calibration_save(calibration_keys[channel], table) != CALIBRATION_OK) {
+        return ESP_FAIL;
+    }
+    return TANWA_calibration_apply(channel, &calibration);
+}
+
+esp_err_t TANWA_calibration_get_table(TANWA_calibration_channel_t channel, calibration_table_t* table) {
+    if (channel >= TANWA_CALIBRATION_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    calibration_channel_t calibration;
+    calibration_status_t ret = calibration_load(calibration_keys[channel], &calibration, table);
+    if (ret == CALIBRATION_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ret == CALIBRATION_OK ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t TANWA_calibration_clear(TANWA_calibration_channel_t channel) {
+    if (channel >= TANWA_CALIBRATION_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    calibration_status_t ret = calibration_erase(calibration_keys[channel]);
+    if (ret != CALIBRATION_OK && ret != CALIBRATION_NOT_FOUND) {
+        return ESP_FAIL;
+    }
+    return TANWA_calibration_apply(channel, NULL);
 }
\ No newline at end of file
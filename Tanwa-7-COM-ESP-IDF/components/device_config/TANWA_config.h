@@ -24,6 +24,9 @@
 #include "led_state_display.h"
 #include "pressure_driver.h"
 #include "solenoid_driver.h"
+#include "temperature_driver.h"
+
+#include "calibration.h"
 
 #include "esp_now.h"
 #include "lora.h"
@@ -44,8 +47,19 @@ typedef struct {
     led_state_display_struct_t led_state_display;
     pressure_driver_struct_t pressure_driver;
     solenoid_driver_struct_t solenoid_driver;
+    temperature_driver_struct_t temperature_driver;
 } TANWA_utility_t;
 
+// Calibrated channels, each has its own table in NVS
+typedef enum {
+    TANWA_CALIBRATION_PRESSURE_1 = 0,
+    TANWA_CALIBRATION_PRESSURE_2,
+    TANWA_CALIBRATION_PRESSURE_3,
+    TANWA_CALIBRATION_PRESSURE_4,
+    TANWA_CALIBRATION_VBAT,
+    TANWA_CALIBRATION_COUNT,
+} TANWA_calibration_channel_t;
+
 // LoRa communication
 typedef lora_struct_t TANWA_lora_t;
 
@@ -67,4 +81,31 @@ esp_err_t TANWA_esp_now_init();
 
 esp_err_t TANWA_get_vbat(float* vbat);
 
+/**
+ * @brief Load the calibration tables from NVS, channels without a table keep the default
+ */
+esp_err_t TANWA_calibration_init();
+
+const char* TANWA_calibration_get_name(TANWA_calibration_channel_t channel);
+
+/**
+ * @brief Read the raw value used as the input of the channel calibration
+ */
+esp_err_t TANWA_calibration_read_raw(TANWA_calibration_channel_t channel, int32_t* raw);
+
+/**
+ * @brief Fit the table, store it in NVS and apply it to the channel
+ */
+esp_err_t TANWA_calibration_commit(TANWA_calibration_channel_t channel, const calibration_table_t* table);
+
+/**
+ * @brief Read the table of the channel stored in NVS
+ */
+esp_err_t TANWA_calibration_get_table(TANWA_calibration_channel_t channel, calibration_table_t* table);
+
+/**
+ * @brief Remove the table of the channel from NVS and restore the default calibration
+ */
+esp_err_t TANWA_calibration_clear(TANWA_calibration_channel_t channel);
+
 #endif /* PWRINSPACE_TANWA_CONFIG_H_*/
\ No newline at end of file
@@ -19,12 +19,28 @@ igniter_status_t igniter_check_continuity(igniter_struct_t* igniter, igniter_con
         ESP_LOGE(TAG, "Failed to read analog value from ADC for continuity check");
         return IGNITER_ADC_ERR;
     }
-    ESP_LOGD(TAG, "Continuity check value: %d", value);
-    if (value > IGNITER_CONTINUITY_THRESHOLD) {
-        *continuity = IGNITER_CONTINUITY_OK;
+    ESP_LOGD(TAG, "Continuity check value: %d, trend: %d", value, (int)value - (int)igniter->continuity_raw);
+    igniter->continuity_raw = value;
+
+    // inside the hysteresis band the current state is kept
+    igniter_continuity_t measured = igniter->continuity;
+    if (value > IGNITER_CONTINUITY_THRESHOLD_HIGH) {
+        measured = IGNITER_CONTINUITY_OK;
+    } else if (value < IGNITER_CONTINUITY_THRESHOLD_LOW) {
+        measured = IGNITER_CONTINUITY_FAIL;
+    }
+
+    if (measured != igniter->continuity) {
+        igniter->continuity_debounce++;
+        if (igniter->continuity_debounce >= IGNITER_CONTINUITY_DEBOUNCE_COUNT) {
+            igniter->continuity = measured;
+            igniter->continuity_debounce = 0;
+            ESP_LOGD(TAG, "Continuity changed to %d", measured);
+        }
     } else {
-        *continuity = IGNITER_CONTINUITY_FAIL;
+        igniter->continuity_debounce = 0;
     }
+    *continuity = igniter->continuity;
     return IGNITER_OK;
 }
 
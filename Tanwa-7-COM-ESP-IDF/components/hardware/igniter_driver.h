@@ -18,7 +18,11 @@
 #include <stdio.h>
 #include <stdbool.h>
 
-#define IGNITER_CONTINUITY_THRESHOLD 1000
+// continuity hysteresis on the averaged raw ADC value
+#define IGNITER_CONTINUITY_THRESHOLD_HIGH 1100
+#define IGNITER_CONTINUITY_THRESHOLD_LOW 900
+// number of consecutive checks needed to change the continuity state
+#define IGNITER_CONTINUITY_DEBOUNCE_COUNT 2
 
 typedef enum {
     IGNITER_STATE_WAITING = 0,
@@ -63,6 +67,9 @@ typedef struct {
     uint8_t gpio_num_fire;
     igniter_drive_t drive;
     igniter_state_t state;
+    igniter_continuity_t continuity;
+    uint8_t continuity_debounce;
+    uint16_t continuity_raw;
 } igniter_struct_t;
 
 igniter_status_t igniter_check_continuity(igniter_struct_t* igniter, igniter_continuity_t* continuity);
@@ -116,7 +116,7 @@ tmp1075_status_t tmp1075_set_conv_time(tmp1075_struct_t *tmp1075, const tmp1075_
     tmp1075_status_t ret = TMP1075_OK;
     uint8_t reg_val = 0;
 
-    if (((tmp1075_conversion_time_t)(tmp1075->config_register >> TMP1075_OFFSET_R) & 0b11) != conv_time) {
+    if (((tmp1075_conversion_time_t)(tmp1075->config_register >> TMP1075_OFFSET_R) & 0b11) == conv_time) {
         return TMP1075_OK;
     }
 
@@ -57,6 +57,34 @@ uint8_t lora_read_reg(lora_struct_t *lora, int16_t reg) {
   return in[1];
 }
 
+lora_err_t lora_write_fifo(lora_struct_t *lora, const uint8_t *buf,
+                           int16_t size) {
+  lora_err_t ret = LORA_OK;
+  if (lora->_spi_transmit_burst != NULL) {
+    return lora->_spi_transmit_burst(0x80 | REG_FIFO, NULL, buf, size) == true
+               ? LORA_OK
+               : LORA_WRITE_ERR;
+  }
+
+  for (int16_t i = 0; i < size; i++) {
+    ret |= lora_write_reg(lora, REG_FIFO, buf[i]);
+  }
+  return ret;
+}
+
+lora_err_t lora_read_fifo(lora_struct_t *lora, uint8_t *buf, int16_t size) {
+  if (lora->_spi_transmit_burst != NULL) {
+    return lora->_spi_transmit_burst(REG_FIFO, buf, NULL, size) == true
+               ? LORA_OK
+               : LORA_RECEIVE_ERR;
+  }
+
+  for (int16_t i = 0; i < size; i++) {
+    buf[i] = lora_read_reg(lora, REG_FIFO);
+  }
+  return LORA_OK;
+}
+
 void lora_reset(lora_struct_t *lora) {
   assert(lora->_gpio_set_level(lora->rst_gpio_num, 0) == true);
   lora->_delay(1);
@@ -198,6 +226,60 @@ lora_err_t lora_disable_crc(lora_struct_t *lora) {
                         lora_read_reg(lora, REG_MODEM_CONFIG_2) & 0xfb);
 }
 
+static bool modem_config_valid(const lora_modem_config_t *config) {
+  return config->bw <= LORA_BW_500_kHz && config->sf >= LORA_SF_64_CoS &&
+         config->sf <= LORA_SF_4096_CoS && config->coding_rate >= 5 &&
+         config->coding_rate <= 8;
+}
+
+lora_err_t lora_get_modem_config(lora_struct_t *lora,
+                                 lora_modem_config_t *config) {
+  uint8_t config_1 = lora_read_reg(lora, REG_MODEM_CONFIG_1);
+  uint8_t config_2 = lora_read_reg(lora, REG_MODEM_CONFIG_2);
+  uint8_t config_3 = lora_read_reg(lora, REG_MODEM_CONFIG_3);
+  lora_modem_config_t read;
+  read.bw = (lora_bandwith_t)(config_1 >> 4);
+  read.coding_rate = ((config_1 >> 1) & 0x07) + 4;
+  read.implicit_header = (config_1 & 0x01) != 0;
+  read.sf = (lora_spreading_factor_t)(config_2 >> 4);
+  read.crc = (config_2 & 0x04) != 0;
+  read.low_data_rate_optimize = (config_3 & 0x08) != 0;
+  read.preamble_length = (lora_read_reg(lora, REG_PREAMBLE_MSB) << 8) |
+                         lora_read_reg(lora, REG_PREAMBLE_LSB);
+  // 0x00 or 0xff from a missing radio, the config is left as it was
+  if (modem_config_valid(&read) == false) {
+    return LORA_CONFIG_ERR;
+  }
+  *config = read;
+  return LORA_OK;
+}
+
+uint32_t lora_time_on_air_us(const lora_modem_config_t *config, int16_t size) {
+  static const uint32_t bw_hz[] = {7800,  10400, 15600,  20800,  31250,
+                                   41700, 62500, 125000, 250000, 500000};
+  if (modem_config_valid(config) == false) {
+    return 0;
+  }
+  int32_t sf = config->sf;
+  int32_t de = config->low_data_rate_optimize ? 1 : 0;
+  int32_t numerator = 8 * size - 4 * sf + 28 + (config->crc ? 16 : 0) -
+                      (config->implicit_header ? 20 : 0);
+  int32_t denominator = 4 * (sf - 2 * de);
+  if (denominator <= 0) {
+    return 0;
+  }
+  int32_t payload_symbols = 8;
+  if (numerator > 0) {
+    payload_symbols += (numerator + denominator - 1) / denominator *
+                       config->coding_rate;
+  }
+  // preamble, 4.25 symbols of the sync word and the payload, in 1/4 symbols
+  uint64_t quarter_symbols =
+      4 * (uint64_t)(config->preamble_length + payload_symbols) + 17;
+  return (uint32_t)((quarter_symbols << sf) * 1000000 /
+                    (4 * (uint64_t)bw_hz[config->bw]));
+}
+
 lora_err_t lora_fill_fifo_buf_to_send(lora_struct_t *lora, uint8_t *buf,
                                       int16_t size) {
   lora_err_t ret = LORA_OK;
@@ -206,10 +288,7 @@ lora_err_t lora_fill_fifo_buf_to_send(lora_struct_t *lora, uint8_t *buf,
    */
   ret |= lora_idle(lora);
   ret |= lora_write_reg(lora, REG_FIFO_ADDR_PTR, 0);
-
-  for (int16_t i = 0; i < size; i++) {
-    ret |= lora_write_reg(lora, REG_FIFO, *buf++);
-  }
+  ret |= lora_write_fifo(lora, buf, size);
   ret |= lora_write_reg(lora, REG_PAYLOAD_LENGTH, size);
   return ret;
 }
@@ -244,6 +323,15 @@ lora_err_t lora_send_packet(lora_struct_t *lora, uint8_t *buf, int16_t size) {
   return ret == LORA_OK ? LORA_OK : LORA_TRANSMIT_ERR;
 }
 
+lora_err_t lora_send_packet_async(lora_struct_t *lora, uint8_t *buf,
+                                  int16_t size) {
+  lora_err_t ret = LORA_OK;
+  ret |= lora_fill_fifo_buf_to_send(lora, buf, size);
+  ret |= lora_map_d0_interrupt(lora, LORA_IRQ_D0_TXDONE);
+  ret |= lora_start_transmission(lora);
+  return ret == LORA_OK ? LORA_OK : LORA_TRANSMIT_ERR;
+}
+
 int16_t lora_receive_packet(lora_struct_t *lora, uint8_t *buf, int16_t size) {
   int16_t len = 0;
 
@@ -273,8 +361,8 @@ int16_t lora_receive_packet(lora_struct_t *lora, uint8_t *buf, int16_t size) {
   if (len > size) {
     len = size;
   }
-  for (int16_t i = 0; i < len; i++) {
-    buf[i] = lora_read_reg(lora, REG_FIFO);
+  if (lora_read_fifo(lora, buf, len) != LORA_OK) {
+    return 0;
   }
 
   return len;
@@ -287,6 +375,11 @@ lora_err_t lora_received(lora_struct_t *lora) {
   return LORA_RECEIVE_ERR;
 }
 
+bool lora_rx_in_progress(lora_struct_t *lora) {
+  return (lora_read_reg(lora, REG_MODEM_STAT) &
+          (MODEM_STAT_SIGNAL_SYNCHRONIZED | MODEM_STAT_HEADER_VALID)) != 0x00;
+}
+
 int16_t lora_packet_rssi(lora_struct_t *lora) {
   return (lora_read_reg(lora, REG_PKT_RSSI_VALUE) -
           (lora->frequency < 868E6 ? 164 : 157));
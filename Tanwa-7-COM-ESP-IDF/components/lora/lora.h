@@ -16,6 +16,12 @@
 #define IRQ_PAYLOAD_CRC_ERROR_MASK 0x20
 #define IRQ_RX_DONE_MASK 0x40
 
+/*
+ * Modem status masks
+ */
+#define MODEM_STAT_SIGNAL_SYNCHRONIZED 0x02
+#define MODEM_STAT_HEADER_VALID 0x08
+
 #define PA_OUTPUT_RFO_PIN 0
 #define PA_OUTPUT_PA_BOOST_PIN 1
 
@@ -37,6 +43,7 @@
 #define REG_FIFO_RX_CURRENT_ADDR 0x10
 #define REG_IRQ_FLAGS 0x12
 #define REG_RX_NB_BYTES 0x13
+#define REG_MODEM_STAT 0x18
 #define REG_PKT_SNR_VALUE 0x19
 #define REG_PKT_RSSI_VALUE 0x1a
 #define REG_MODEM_CONFIG_1 0x1d
@@ -131,13 +138,34 @@ typedef enum {
   LORA_TX_POWER_20_dBm = 17
 } lora_tx_power_t;
 
+/*!
+ * \brief Modem settings that set the time on air of a packet
+ */
+typedef struct {
+  lora_spreading_factor_t sf;
+  lora_bandwith_t bw;
+  int16_t coding_rate;  // denominator of the coding rate 4/x
+  int32_t preamble_length;
+  bool implicit_header;
+  bool crc;
+  bool low_data_rate_optimize;
+} lora_modem_config_t;
+
 typedef bool (*lora_SPI_transmit)(uint8_t _in[2], uint8_t _val[2]);
+/*!
+ * \brief One SPI transaction of the address byte and size data bytes,
+ * _in or _out is NULL when only writing or only reading
+ */
+typedef bool (*lora_SPI_transmit_burst)(uint8_t _address, uint8_t *_in,
+                                        const uint8_t *_out, size_t _size);
 typedef void (*lora_delay)(uint32_t _ms);
 typedef bool (*lora_GPIO_set_level)(uint8_t _gpio_num, uint8_t _level);
 typedef void (*lora_log)(const char *info);
 
 typedef struct {
   lora_SPI_transmit _spi_transmit;
+  lora_SPI_transmit_burst _spi_transmit_burst;  // can be NULL, the FIFO is
+                                                // then accessed byte by byte
   lora_delay _delay;
   lora_GPIO_set_level _gpio_set_level;
   lora_log log;
@@ -173,6 +201,23 @@ lora_err_t lora_write_reg(lora_struct_t *lora, int16_t reg, int16_t val);
  */
 uint8_t lora_read_reg(lora_struct_t *lora, int16_t reg);
 
+/*!
+ * \brief Write the bytes to REG_FIFO in one SPI transaction.
+ * \param buf Data to write.
+ * \param size Number of bytes.
+ * \return lora_err_t value
+ */
+lora_err_t lora_write_fifo(lora_struct_t *lora, const uint8_t *buf,
+                           int16_t size);
+
+/*!
+ * \brief Read the bytes from REG_FIFO in one SPI transaction.
+ * \param buf Buffer for the data.
+ * \param size Number of bytes.
+ * \return lora_err_t value
+ */
+lora_err_t lora_read_fifo(lora_struct_t *lora, uint8_t *buf, int16_t size);
+
 /*!
  * \brief Perform physical reset on the Lora chip
  * \throw Assert if _gpio_set_level fails
@@ -272,6 +317,22 @@ lora_err_t lora_enable_crc(lora_struct_t *lora);
  */
 lora_err_t lora_disable_crc(lora_struct_t *lora);
 
+/*!
+ * \brief Read the modem settings from the radio registers.
+ * \returns LORA_CONFIG_ERR if the registers hold no valid settings, the config
+ * is not changed then.
+ */
+lora_err_t lora_get_modem_config(lora_struct_t *lora,
+                                 lora_modem_config_t *config);
+
+/*!
+ * \brief Time on air of a packet, the formula from the SX1276 datasheet
+ * (4.1.1.7), does not need the radio.
+ * \param size Payload size in bytes.
+ * \returns Time on air in microseconds, 0 if the config is not valid.
+ */
+uint32_t lora_time_on_air_us(const lora_modem_config_t *config, int16_t size);
+
 /*!
  * \brief Fills the REG_FIFO buffer with desired values, and the
  * REG_PAYLOAD_LENGTH with buffer size
@@ -308,6 +369,16 @@ lora_err_t lora_write_irq_flags(lora_struct_t *lora);
  */
 lora_err_t lora_send_packet(lora_struct_t *lora, uint8_t *buf, int16_t size);
 
+/*!
+ * \brief Start sending a packet and return without waiting, DIO0 is mapped
+ * to TX done. The radio goes to standby after the packet.
+ * \note Clear the flag with lora_write_irq_flags after the DIO0 interrupt.
+ * DOES NOT go into receive mode automatically afterwards.
+ * \param buf Data to be sent
+ * \param size Size of data.
+ */
+lora_err_t lora_send_packet_async(lora_struct_t *lora, uint8_t *buf, int16_t size);
+
 /*!
  * \brief Read a received packet.
  * \param buf Buffer for the data.
@@ -321,6 +392,12 @@ int16_t lora_receive_packet(lora_struct_t *lora, uint8_t *buf, int16_t size);
  */
 lora_err_t lora_received(lora_struct_t *lora);
 
+/*!
+ * \returns true if a packet is being received, the preamble is synchronized
+ * or the header is valid.
+ */
+bool lora_rx_in_progress(lora_struct_t *lora);
+
 /*!
  * \returns last packet's RSSI.
  */
@@ -5,23 +5,55 @@
 ///
 ///===-----------------------------------------------------------------------------------------===//
 #include "mcu_adc_config.h"
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_idf_version.h"
 #include "esp_log.h"
 
 #define TAG "MCU_ADC"
 
-static mcu_adc_config_t mcu_adc_config = {                                                        
-  .adc_cal = {1.0f, 5.742f, 5.180f},                     
-  .adc_chan = {VBAT_CHANNEL, IGNITER_1_CHANNEL, IGNITER_2_CHANNEL}, 
+#define ADC_CHAN_INDEX_NONE 0xFF
+
+static mcu_adc_config_t mcu_adc_config = {
+  .adc_cal = {1.0f, 5.742f, 5.180f},
+  .adc_chan = {VBAT_CHANNEL, IGNITER_1_CHANNEL, IGNITER_2_CHANNEL},
   .adc_chan_num = MAX_CHANNEL_INDEX,
-  .oneshot_unit_init_cfg = {                                  
-    .unit_id = ADC_UNIT_1,                               
-  },        
-  .oneshot_chan_cfg = {                                                  
-    .bitwidth = ADC_BITWIDTH_12,                   
-    .atten = ADC_ATTEN_DB_11,                      
-  },                                               
+  .atten = ADC_ATTEN_DB_11,
+  .bitwidth = ADC_BITWIDTH_12,
+  .continuous_handle = NULL,
+  .adc_avg = {0},
+  .frame_count = 0,
 };
 
+// maps the ADC1 channel number from the DMA result to the channel index
+static uint8_t chan_to_index[MAX_ADC_CHANNELS];
+
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                   void *user_data) {
+  uint32_t sum[MAX_CHANNEL_INDEX] = {0};
+  uint32_t count[MAX_CHANNEL_INDEX] = {0};
+
+  for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= edata->size; i += SOC_ADC_DIGI_RESULT_BYTES) {
+    const adc_digi_output_data_t *result = (const adc_digi_output_data_t *)&edata->conv_frame_buffer[i];
+    uint8_t channel = result->type1.channel;
+    if (channel >= MAX_ADC_CHANNELS || chan_to_index[channel] == ADC_CHAN_INDEX_NONE) {
+      continue;
+    }
+    sum[chan_to_index[channel]] += result->type1.data;
+    count[chan_to_index[channel]]++;
+  }
+
+  for (uint8_t i = 0; i < mcu_adc_config.adc_chan_num; i++) {
+    if (count[i] > 0) {
+      mcu_adc_config.adc_avg[i] = (uint16_t)((sum[i] + count[i] / 2) / count[i]);
+    }
+  }
+  mcu_adc_config.frame_count++;
+
+  return false;
+}
+
 esp_err_t mcu_adc_init() {
   if (mcu_adc_config.adc_chan_num > MAX_ADC_CHANNELS) {
     ESP_LOGE(TAG, "Too many ADC channels to configure!");
@@ -29,27 +61,61 @@ esp_err_t mcu_adc_init() {
   }
   esp_err_t res = ESP_OK;
 
-  res |= adc_oneshot_new_unit(&(mcu_adc_config.oneshot_unit_init_cfg),
-                              &(mcu_adc_config.oneshot_unit_handle));
+  adc_continuous_handle_cfg_t handle_cfg = {
+    .max_store_buf_size = MCU_ADC_MAX_STORE_BUF_SIZE,
+    .conv_frame_size = MCU_ADC_CONV_FRAME_SIZE,
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    // results are consumed in the callback, the pool is never read
+    .flags.flush_pool = true,
+#endif
+  };
+  res = adc_continuous_new_handle(&handle_cfg, &mcu_adc_config.continuous_handle);
+  if (res != ESP_OK) {
+    ESP_LOGE(TAG, "ADC continuous handle creation failed!");
+    return res;
+  }
 
+  memset(chan_to_index, ADC_CHAN_INDEX_NONE, sizeof(chan_to_index));
+  adc_digi_pattern_config_t pattern[MAX_CHANNEL_INDEX] = {0};
   for (uint8_t i = 0; i < mcu_adc_config.adc_chan_num; i++) {
-    res |= adc_oneshot_config_channel(mcu_adc_config.oneshot_unit_handle,
-                                      mcu_adc_config.adc_chan[i],
-                                      &mcu_adc_config.oneshot_chan_cfg);
-    if (res != ESP_OK) {
-      ESP_LOGE(TAG, "ADC channel %d configuration failed!", i);
-    }
+    pattern[i].atten = mcu_adc_config.atten;
+    pattern[i].channel = mcu_adc_config.adc_chan[i];
+    pattern[i].unit = ADC_UNIT_1;
+    pattern[i].bit_width = mcu_adc_config.bitwidth;
+    chan_to_index[mcu_adc_config.adc_chan[i]] = i;
+  }
+
+  adc_continuous_config_t dig_cfg = {
+    .pattern_num = mcu_adc_config.adc_chan_num,
+    .adc_pattern = pattern,
+    .sample_freq_hz = MCU_ADC_SAMPLE_FREQ_HZ,
+    .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+    .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+  };
+  res |= adc_continuous_config(mcu_adc_config.continuous_handle, &dig_cfg);
+
+  adc_continuous_evt_cbs_t cbs = {
+    .on_conv_done = on_conv_done,
+  };
+  res |= adc_continuous_register_event_callbacks(mcu_adc_config.continuous_handle, &cbs, NULL);
+  if (res != ESP_OK) {
+    ESP_LOGE(TAG, "ADC continuous configuration failed!");
+    return res;
+  }
+
+  res = adc_continuous_start(mcu_adc_config.continuous_handle);
+  if (res != ESP_OK) {
+    ESP_LOGE(TAG, "ADC continuous start failed!");
   }
 
   return res;
 }
 
 bool _mcu_adc_read_raw(uint8_t channel, uint16_t* adc_raw) {
-  int vRaw;
-  if (adc_oneshot_read(mcu_adc_config.oneshot_unit_handle, mcu_adc_config.adc_chan[channel], &vRaw) != ESP_OK) {
+  if (channel >= mcu_adc_config.adc_chan_num || mcu_adc_config.frame_count == 0) {
     return false;
   }
-  *adc_raw = (uint16_t)vRaw;
+  *adc_raw = mcu_adc_config.adc_avg[channel];
   return true;
 }
 
@@ -16,15 +16,17 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include "esp_adc/adc_cali.h"
-#include "esp_adc/adc_cali_scheme.h"
-#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
 #include "soc/adc_channel.h"
 
 #define READ_ERROR_RETURN_VAL 0xFFFF
 #define VOLTAGE_READ_ERROR_RETURN_VAL -1.0f
 #define MAX_ADC_CHANNELS 8
 
+#define MCU_ADC_SAMPLE_FREQ_HZ 20000   // lowest frequency supported by the ESP32 DMA mode
+#define MCU_ADC_CONV_FRAME_SIZE 256    // bytes, 128 results per frame, ~6.4 ms at 20 kHz
+#define MCU_ADC_MAX_STORE_BUF_SIZE 1024
+
 typedef enum {
   VBAT_CHANNEL = ADC_CHANNEL_0,
   IGNITER_1_CHANNEL = ADC_CHANNEL_6,
@@ -41,49 +43,50 @@ typedef enum {
 /*!
  * \brief Voltage measure struct
  * \param adc_cal - calibration value to be configured.
- *                 voltage = rawRead * adc_cal
+ *                 voltage = rawRead / 4095 * 3.3 * adc_cal
  * \param adc_chan - specific channel of ADC
  * \param adc_chan_num - number of channels to be configured
- * \param oneshot_unit_cfg - config for ADC channel
- * \param oneshot_unit_handle - handle for ADC channel
- * \param oneshot_chan_cfg - config for ADC channel
- * \param oneshot_chan_handle - handle for ADC channel
+ * \param atten - attenuation used for all channels
+ * \param bitwidth - resolution used for all channels
+ * \param continuous_handle - handle of the ADC continuous (DMA) driver
+ * \param adc_avg - average of the raw results of the last DMA frame, written in ISR
+ * \param frame_count - number of DMA frames processed, written in ISR
  * \note adc_cal and adc_chan are arrays of size adc_chan_num.
  *      adc_cal[i] is calibration value for adc_chan[i]
  *     adc_chan[i] is channel number for adc_cal[i]
- * \note oneshot_unit_cfg and oneshot_chan_cfg are the same for all channels.
  */
 typedef struct {
   float adc_cal[MAX_CHANNEL_INDEX];
   uint8_t adc_chan[MAX_CHANNEL_INDEX];
   uint8_t adc_chan_num;
-  adc_oneshot_unit_handle_t oneshot_unit_handle;
-  adc_oneshot_unit_init_cfg_t oneshot_unit_init_cfg;
-  adc_oneshot_chan_cfg_t oneshot_chan_cfg;
+  adc_atten_t atten;
+  adc_bitwidth_t bitwidth;
+  adc_continuous_handle_t continuous_handle;
+  volatile uint16_t adc_avg[MAX_CHANNEL_INDEX];
+  volatile uint32_t frame_count;
 } mcu_adc_config_t;
 
 /*!
   \brief Init for a voltage measure.
-  \param v_mes - pointer to voltage_measure_config_t struct
-  \param adc_chan - specific channel of ADC1
-  \param adc_cal - calibration value to be configured.
-                  voltage = rawRead * adc_cal
+  \note All channels are sampled in the background by the DMA, the results of every frame are
+        averaged in the conversion done callback.
 */
 esp_err_t mcu_adc_init();
 
 /*!
  * \brief Read raw value from ADC
- * \param v_mes - pointer to voltage_measure_config_t struct
- * \param adc_chan - specific channel of ADC as specified in v_mes struct
- * \param adc_raw - pointer to raw value read from ADC
+ * \param adc_chan - index of the channel as specified in mcu_adc_chan_index_cfg_t
+ * \param adc_raw - pointer to the averaged raw value of the last DMA frame
+ * \note Does not block, returns false until the first frame is sampled.
  */
 bool _mcu_adc_read_raw(uint8_t adc_chan, uint16_t* adc_raw);
 
 /*!
  * \brief Read voltage from ADC
- * \param v_mes - pointer to voltage_measure_config_t struct
- * \param adc_chan - specific channel of ADC as specified in v_mes struct
+ * \param adc_chan - index of the channel as specified in mcu_adc_chan_index_cfg_t
  * \param adc_voltage - pointer to voltage read from ADC
+ * \note The adc_cal gains are tuned for the raw conversion, not for the adc_cali
+ *       millivolts.
  */
 bool _mcu_adc_read_voltage(uint8_t adc_chan, float* adc_voltage);
 
@@ -8,16 +8,169 @@
 #include "mcu_i2c_config.h"
 #include <string.h>
 
+#include "esp_timer.h"
+
 #define TAG "MCU_I2C"
 
+typedef struct {
+  uint8_t address;
+  mcu_i2c_priority_t priority;
+  const char *name;
+} mcu_i2c_device_t;
+
+typedef struct {
+  uint8_t address;
+  uint8_t reg;
+  uint8_t *data;
+  uint8_t len;
+  bool read;
+  uint8_t device;
+  int64_t enqueue_time_us;
+  SemaphoreHandle_t done;
+  esp_err_t *result;
+} mcu_i2c_transaction_t;
+
 static mcu_i2c_config_t mcu_i2c_config = {
-  .port = CONFIG_I2C_MASTER_PORT_NUM, 
-  .sda = CONFIG_I2C_SDA, 
+  .port = CONFIG_I2C_MASTER_PORT_NUM,
+  .sda = CONFIG_I2C_SDA,
   .scl = CONFIG_I2C_SCL,
-  .clk_speed = CONFIG_I2C_MASTER_FREQUENCY, 
-  .i2c_init_flag = false,           
+  .clk_speed = CONFIG_I2C_MASTER_FREQUENCY,
+  .i2c_init_flag = false,
+};
+
+static const mcu_i2c_device_t mcu_i2c_devices[MCU_I2C_DEVICE_COUNT] = {
+  [MCU_I2C_DEVICE_PCA9574] = {CONFIG_I2C_PCA9574_ADDR, MCU_I2C_PRIORITY_HIGH, "PCA9574"},
+  [MCU_I2C_DEVICE_MCP23018] = {CONFIG_I2C_MCP23018_ADDR, MCU_I2C_PRIORITY_NORMAL, "MCP23018"},
+  [MCU_I2C_DEVICE_ADS1115] = {CONFIG_I2C_ADS1115_ADDR, MCU_I2C_PRIORITY_NORMAL, "ADS1115"},
+  [MCU_I2C_DEVICE_TMP1075_TS1] = {CONFIG_I2C_TMP1075_TS1_ADDR, MCU_I2C_PRIORITY_LOW, "TMP1075 TS1"},
+  [MCU_I2C_DEVICE_TMP1075_TS2] = {CONFIG_I2C_TMP1075_TS2_ADDR, MCU_I2C_PRIORITY_LOW, "TMP1075 TS2"},
+  [MCU_I2C_DEVICE_OTHER] = {0x00, MCU_I2C_PRIORITY_NORMAL, "OTHER"},
+};
+
+static struct {
+  TaskHandle_t task;
+  QueueHandle_t queues[MCU_I2C_PRIORITY_COUNT];
+  SemaphoreHandle_t lock;  // owned by the bus for the whole batch
+  mcu_i2c_bus_stats_t stats;
+} bus = {
+  .task = NULL,
+  .lock = NULL,
 };
 
+static uint8_t get_device_index(uint8_t address) {
+  for (uint8_t i = 0; i < MCU_I2C_DEVICE_OTHER; ++i) {
+    if (mcu_i2c_devices[i].address == address) {
+      return i;
+    }
+  }
+  return MCU_I2C_DEVICE_OTHER;
+}
+
+static esp_err_t execute_transaction(mcu_i2c_transaction_t *trans) {
+  esp_err_t ret;
+  if (trans->read == true) {
+    ret = i2c_master_write_read_device(mcu_i2c_config.port, trans->address, &trans->reg, 1, trans->data,
+                                       trans->len, CONFIG_I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
+  } else {
+    // register address and data have to be sent in one transfer, the length is bounded by
+    // mcu_i2c_submit so the buffer can live on the stack
+    uint8_t write_buf[MCU_I2C_MAX_WRITE_LEN + 1];
+    write_buf[0] = trans->reg;
+    memcpy(write_buf + 1, trans->data, trans->len);
+    ret = i2c_master_write_to_device(mcu_i2c_config.port, trans->address, write_buf, trans->len + 1,
+                                     CONFIG_I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
+  }
+  return ret;
+}
+
+static void update_stats(mcu_i2c_transaction_t *trans, int64_t start_time_us, esp_err_t result) {
+  int64_t end_time_us = esp_timer_get_time();
+  uint32_t queue_wait_us = (uint32_t)(start_time_us - trans->enqueue_time_us);
+  uint32_t latency_us = (uint32_t)(end_time_us - trans->enqueue_time_us);
+  mcu_i2c_device_stats_t *stats = &bus.stats.devices[trans->device];
+
+  stats->transactions++;
+  if (result != ESP_OK) {
+    stats->errors++;
+  }
+  stats->total_latency_us += latency_us;
+  if (latency_us > stats->max_latency_us) {
+    stats->max_latency_us = latency_us;
+  }
+  if (queue_wait_us > stats->max_queue_wait_us) {
+    stats->max_queue_wait_us = queue_wait_us;
+  }
+}
+
+static void run_transaction(mcu_i2c_transaction_t *trans) {
+  int64_t start_time_us = esp_timer_get_time();
+  esp_err_t ret = execute_transaction(trans);
+  update_stats(trans, start_time_us, ret);
+  if (ret != ESP_OK) {
+    ESP_LOGD(TAG, "Transaction to %s failed: %s", mcu_i2c_devices[trans->device].name, esp_err_to_name(ret));
+  }
+  *trans->result = ret;
+}
+
+static bool get_next_transaction(mcu_i2c_transaction_t *trans) {
+  for (uint8_t i = 0; i < MCU_I2C_PRIORITY_COUNT; ++i) {
+    if (xQueueReceive(bus.queues[i], trans, 0) == pdTRUE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void mcu_i2c_bus_task(void *pvParameters) {
+  mcu_i2c_transaction_t trans;
+  while (1) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    bool pending = true;
+    while (pending == true) {
+      // Consecutive transactions are executed back to back while holding the bus, the priority
+      // queues are checked again before every transaction so solenoid writes can jump ahead
+      uint32_t batch_size = 0;
+      xSemaphoreTake(bus.lock, portMAX_DELAY);
+      while (batch_size < MCU_I2C_BUS_BATCH_MAX && get_next_transaction(&trans) == true) {
+        run_transaction(&trans);
+        xSemaphoreGive(trans.done);
+        batch_size++;
+      }
+      if (batch_size > 0) {
+        bus.stats.batches++;
+        if (batch_size > bus.stats.max_batch_size) {
+          bus.stats.max_batch_size = batch_size;
+        }
+      }
+      xSemaphoreGive(bus.lock);
+      pending = (batch_size == MCU_I2C_BUS_BATCH_MAX);
+    }
+  }
+  vTaskDelete(NULL);
+}
+
+static bool mcu_i2c_bus_init(void) {
+  bus.lock = xSemaphoreCreateMutex();
+  if (bus.lock == NULL) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < MCU_I2C_PRIORITY_COUNT; ++i) {
+    bus.queues[i] = xQueueCreate(MCU_I2C_BUS_QUEUE_SIZE, sizeof(mcu_i2c_transaction_t));
+    if (bus.queues[i] == NULL) {
+      return false;
+    }
+  }
+
+  xTaskCreatePinnedToCore(mcu_i2c_bus_task, "i2c_bus_task", MCU_I2C_BUS_TASK_STACK_SIZE, NULL,
+                          MCU_I2C_BUS_TASK_PRIORITY, &bus.task, MCU_I2C_BUS_TASK_CORE);
+  if (bus.task == NULL) {
+    return false;
+  }
+  return true;
+}
+
 esp_err_t mcu_i2c_init() {
   if (mcu_i2c_config.i2c_init_flag == false) {
     i2c_config_t conf = {
@@ -34,24 +187,93 @@ esp_err_t mcu_i2c_init() {
       ESP_LOGE(TAG, "I2C driver install error: %d", ret);
       return ret;
     }
+    if (mcu_i2c_bus_init() == false) {
+      ESP_LOGE(TAG, "I2C bus manager init error");
+      return ESP_FAIL;
+    }
     mcu_i2c_config.i2c_init_flag = true;
   }
   return ESP_OK;
 }
 
+static bool mcu_i2c_submit(bool read, uint8_t address, uint8_t reg, uint8_t *data, uint8_t len) {
+  if (read == false && len > MCU_I2C_MAX_WRITE_LEN) {
+    ESP_LOGE(TAG, "I2C write of %d bytes exceeds the limit of %d", len, MCU_I2C_MAX_WRITE_LEN);
+    return false;
+  }
+
+  esp_err_t result = ESP_FAIL;
+  StaticSemaphore_t done_buffer;
+  mcu_i2c_transaction_t trans = {
+    .address = address,
+    .reg = reg,
+    .data = data,
+    .len = len,
+    .read = read,
+    .device = get_device_index(address),
+    .enqueue_time_us = esp_timer_get_time(),
+    .done = NULL,
+    .result = &result,
+  };
+
+  // Bus manager is not running, execute in the context of the caller
+  if (bus.task == NULL) {
+    if (bus.lock != NULL) {
+      xSemaphoreTake(bus.lock, portMAX_DELAY);
+    }
+    run_transaction(&trans);
+    if (bus.lock != NULL) {
+      xSemaphoreGive(bus.lock);
+    }
+    return (bool)(result == ESP_OK);
+  }
+
+  trans.done = xSemaphoreCreateBinaryStatic(&done_buffer);
+  mcu_i2c_priority_t priority = mcu_i2c_devices[trans.device].priority;
+  if (xQueueSend(bus.queues[priority], &trans, pdMS_TO_TICKS(CONFIG_I2C_MASTER_TIMEOUT_MS)) == pdFALSE) {
+    // several caller tasks, the other counters are updated by the bus manager under the lock
+    __atomic_add_fetch(&bus.stats.queue_full, 1, __ATOMIC_RELAXED);
+    ESP_LOGW(TAG, "I2C queue full, transaction to %s dropped", mcu_i2c_devices[trans.device].name);
+    return false;
+  }
+  xTaskNotifyGive(bus.task);
+
+  // Transaction lives on the stack of the caller, so wait until the bus manager is done with it
+  xSemaphoreTake(trans.done, portMAX_DELAY);
+  return (bool)(result == ESP_OK);
+}
+
 bool _mcu_i2c_write(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len) {
-    esp_err_t ret;
-    // dynamically create a buffer to hold the data to be written
-    uint8_t *write_buf = malloc(len + 1);
-    write_buf[0] = reg;
-    memcpy(write_buf + 1, data, len);
-    ret = i2c_master_write_to_device(CONFIG_I2C_MASTER_PORT_NUM, address, write_buf, len+1, CONFIG_I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-    free(write_buf);
-    return (bool)(ret == ESP_OK);
+  return mcu_i2c_submit(false, address, reg, data, len);
 }
 
 bool _mcu_i2c_read(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len) {
-    esp_err_t ret;
-    ret = i2c_master_write_read_device(CONFIG_I2C_MASTER_PORT_NUM, address, &reg, 1, data, len, CONFIG_I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-    return (bool)(ret == ESP_OK);
-}
\ No newline at end of file
+  return mcu_i2c_submit(true, address, reg, data, len);
+}
+
+const char* mcu_i2c_get_device_name(mcu_i2c_device_index_t device) {
+  if (device >= MCU_I2C_DEVICE_COUNT) {
+    return "UNKNOWN";
+  }
+  return mcu_i2c_devices[device].name;
+}
+
+void mcu_i2c_get_stats(mcu_i2c_bus_stats_t *stats) {
+  if (bus.lock != NULL) {
+    xSemaphoreTake(bus.lock, portMAX_DELAY);
+  }
+  memcpy(stats, &bus.stats, sizeof(mcu_i2c_bus_stats_t));
+  if (bus.lock != NULL) {
+    xSemaphoreGive(bus.lock);
+  }
+}
+
+void mcu_i2c_reset_stats(void) {
+  if (bus.lock != NULL) {
+    xSemaphoreTake(bus.lock, portMAX_DELAY);
+  }
+  memset(&bus.stats, 0, sizeof(mcu_i2c_bus_stats_t));
+  if (bus.lock != NULL) {
+    xSemaphoreGive(bus.lock);
+  }
+}
@@ -19,8 +19,17 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "sdkconfig.h"
 
+#define MCU_I2C_BUS_TASK_STACK_SIZE 3072
+#define MCU_I2C_BUS_TASK_PRIORITY 9
+#define MCU_I2C_BUS_TASK_CORE 0
+#define MCU_I2C_BUS_QUEUE_SIZE 16
+#define MCU_I2C_BUS_BATCH_MAX 8
+#define MCU_I2C_MAX_WRITE_LEN 16  // max number of data bytes in a single register write
+
 #define MCU_I2C_DEFAULT_CONFIG()                                                      \
   {                                                                                   \
     .port = CONFIG_I2C_MASTER_PORT_NUM, .sda = CONFIG_I2C_SDA, .scl = CONFIG_I2C_SCL, \
@@ -37,6 +46,58 @@ typedef struct {
   bool i2c_init_flag;
 } mcu_i2c_config_t;
 
+/*!
+ * \brief Priority of the I2C transaction in the bus manager queue.
+ * \note Solenoid valves (PCA9574) are served before everything else, the LED display and the
+ *       pressure ADC go next and the temperature sensors are served last.
+ */
+typedef enum {
+  MCU_I2C_PRIORITY_HIGH = 0,
+  MCU_I2C_PRIORITY_NORMAL,
+  MCU_I2C_PRIORITY_LOW,
+  MCU_I2C_PRIORITY_COUNT,
+} mcu_i2c_priority_t;
+
+typedef enum {
+  MCU_I2C_DEVICE_PCA9574 = 0,
+  MCU_I2C_DEVICE_MCP23018,
+  MCU_I2C_DEVICE_ADS1115,
+  MCU_I2C_DEVICE_TMP1075_TS1,
+  MCU_I2C_DEVICE_TMP1075_TS2,
+  MCU_I2C_DEVICE_OTHER,
+  MCU_I2C_DEVICE_COUNT,
+} mcu_i2c_device_index_t;
+
+/*!
+ * \brief Per device transaction statistics
+ * \param transactions - number of finished transactions
+ * \param errors - number of transactions finished with an error
+ * \param total_latency_us - sum of latencies (queue wait + bus time) of all transactions
+ * \param max_latency_us - worst latency (queue wait + bus time)
+ * \param max_queue_wait_us - worst time spent in the queue before the bus was granted
+ */
+typedef struct {
+  uint32_t transactions;
+  uint32_t errors;
+  uint64_t total_latency_us;
+  uint32_t max_latency_us;
+  uint32_t max_queue_wait_us;
+} mcu_i2c_device_stats_t;
+
+/*!
+ * \brief Bus manager statistics
+ * \param devices - per device statistics, indexed by mcu_i2c_device_index_t
+ * \param batches - number of batches executed by the bus manager
+ * \param max_batch_size - biggest number of transactions executed in one batch
+ * \param queue_full - number of transactions rejected because the queue was full
+ */
+typedef struct {
+  mcu_i2c_device_stats_t devices[MCU_I2C_DEVICE_COUNT];
+  uint32_t batches;
+  uint32_t max_batch_size;
+  uint32_t queue_full;
+} mcu_i2c_bus_stats_t;
+
 /*!
  * \brief Initiates the I2C bus
  * \param i2c I2C configuration
@@ -45,8 +106,36 @@ typedef struct {
  */
 esp_err_t mcu_i2c_init();
 
+/*!
+ * \brief Writes the register of the I2C device through the bus manager
+ * \note The caller is blocked until the transaction is finished. Transactions are executed in
+ *       the order of the device priority. Writes longer than MCU_I2C_MAX_WRITE_LEN are rejected,
+ *       the write path does not use the heap.
+ */
 bool _mcu_i2c_write(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len);
 
+/*!
+ * \brief Reads the register of the I2C device through the bus manager
+ * \note The caller is blocked until the transaction is finished. Transactions are executed in
+ *       the order of the device priority.
+ */
 bool _mcu_i2c_read(uint8_t address, uint8_t reg, uint8_t *data, uint8_t len);
 
+/*!
+ * \brief Returns the name of the device tracked by the bus manager
+ * \param device index of the device
+ */
+const char* mcu_i2c_get_device_name(mcu_i2c_device_index_t device);
+
+/*!
+ * \brief Copies the bus manager statistics
+ * \param stats pointer to the statistics struct
+ */
+void mcu_i2c_get_stats(mcu_i2c_bus_stats_t *stats);
+
+/*!
+ * \brief Clears the bus manager statistics
+ */
+void mcu_i2c_reset_stats(void);
+
 #endif // PWRINSPACE_MCU_I2C_CONFIG_H_
\ No newline at end of file
@@ -7,8 +7,11 @@
 
 #include "mcu_spi_config.h"
 
+#include <string.h>
+
 #include "mcu_gpio_config.h"
 
+#include "esp_attr.h"
 #include "esp_log.h"
 
 #define TAG "MCU_SPI"
@@ -16,6 +19,10 @@
 static mcu_spi_config_t spi_config = MCU_SPI_DEFAULT_CONFIG();
 SemaphoreHandle_t mutex_spi;
 
+// burst buffers go through DMA, used under mutex_spi
+static DMA_ATTR uint8_t lora_burst_tx[LORA_SPI_BURST_MAX_SIZE + 1];
+static DMA_ATTR uint8_t lora_burst_rx[LORA_SPI_BURST_MAX_SIZE + 1];
+
 esp_err_t mcu_spi_init(void) {
     esp_err_t ret = ESP_OK;
     if (spi_config.spi_init_flag) {
@@ -72,4 +79,30 @@ bool _lora_spi_transmit(uint8_t _in[2], uint8_t _out[2]) {
     _mcu_gpio_set_level(LORA_CS_GPIO_INDEX, 1);
     xSemaphoreGive(mutex_spi);
     return true;
+}
+
+bool _lora_spi_transmit_burst(uint8_t _address, uint8_t *_in, const uint8_t *_out, size_t _size) {
+    if (_size > LORA_SPI_BURST_MAX_SIZE) {
+        return false;
+    }
+
+    xSemaphoreTake(mutex_spi, portMAX_DELAY);
+    lora_burst_tx[0] = _address;
+    if (_out != NULL) {
+        memcpy(lora_burst_tx + 1, _out, _size);
+    } else {
+        memset(lora_burst_tx + 1, 0xff, _size);
+    }
+    spi_transaction_t t = {.flags = 0,
+                          .length = 8 * (_size + 1),
+                          .tx_buffer = lora_burst_tx,
+                          .rx_buffer = _in != NULL ? lora_burst_rx : NULL};
+    _mcu_gpio_set_level(LORA_CS_GPIO_INDEX, 0);
+    esp_err_t ret = spi_device_transmit(spi_config.spi_handle, &t);
+    _mcu_gpio_set_level(LORA_CS_GPIO_INDEX, 1);
+    if (_in != NULL && ret == ESP_OK) {
+        memcpy(_in, lora_burst_rx + 1, _size);
+    }
+    xSemaphoreGive(mutex_spi);
+    return ret == ESP_OK;
 }
\ No newline at end of file
@@ -66,6 +66,8 @@ esp_err_t mcu_spi_init(void);
 */
 esp_err_t mcu_spi_deinit(void);
 
+#define LORA_SPI_BURST_MAX_SIZE 256  // whole FIFO of the radio
+
 bool _lora_add_device(void);
 
 /**
@@ -75,4 +77,13 @@ bool _lora_add_device(void);
  */
 bool _lora_spi_transmit(uint8_t _in[2], uint8_t _out[2]);
 
+/**
+ * \brief SPI burst transmit function for LoRa, the address byte and the data in one transaction
+ * \param[in] _address register address with the write bit
+ * \param[out] _in input buffer, NULL when writing
+ * \param[in] _out output buffer, NULL when reading
+ * \param[in] _size data size, up to LORA_SPI_BURST_MAX_SIZE
+ */
+bool _lora_spi_transmit_burst(uint8_t _address, uint8_t *_in, const uint8_t *_out, size_t _size);
+
 #endif /* PWRINSPACE_MCU_SPI_CONFIG_H_ */
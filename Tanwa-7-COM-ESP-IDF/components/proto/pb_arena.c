@@ -0,0 +1,44 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "pb_arena.h"
+
+static void *arena_alloc(void *allocator_data, size_t size) {
+    pb_arena_t *arena = allocator_data;
+    size_t start = (arena->used + PB_ARENA_ALIGN - 1) & ~(size_t)(PB_ARENA_ALIGN - 1);
+    if (start > arena->size || size > arena->size - start) {
+        arena->failures++;
+        return NULL;
+    }
+
+    arena->used = start + size;
+    if (arena->used > arena->max_used) {
+        arena->max_used = arena->used;
+    }
+    return arena->buffer + start;
+}
+
+static void arena_free(void *allocator_data, void *pointer) {
+    // released all at once by pb_arena_reset
+    (void)allocator_data;
+    (void)pointer;
+}
+
+void pb_arena_init(pb_arena_t *arena, void *buffer, size_t size) {
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.free = arena_free;
+    arena->allocator.allocator_data = arena;
+    arena->buffer = buffer;
+    arena->size = size;
+    arena->used = 0;
+    arena->max_used = 0;
+    arena->failures = 0;
+}
+
+void pb_arena_reset(pb_arena_t *arena) {
+    arena->used = 0;
+}
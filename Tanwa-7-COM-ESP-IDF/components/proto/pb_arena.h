@@ -0,0 +1,47 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the protobuf-c arena allocator. Unpacked messages are taken
+/// from a static buffer of the task with a bump pointer, free does nothing and the whole arena is
+/// released by the reset before the next packet, so decoding does not touch the heap.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_PB_ARENA_H_
+#define PWRINSPACE_PB_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <protobuf-c/protobuf-c.h>
+
+#define PB_ARENA_ALIGN 8
+
+typedef struct {
+    ProtobufCAllocator allocator;  // pass to the __unpack and __free_unpacked functions
+    uint8_t *buffer;
+    size_t size;
+    size_t used;
+    size_t max_used;
+    uint32_t failures;  // allocations that did not fit, the unpack returns NULL
+} pb_arena_t;
+
+/**
+ * @brief Initialize the arena on the buffer
+ *
+ * @param arena pointer to the arena
+ * @param buffer memory of the arena, aligned to PB_ARENA_ALIGN
+ * @param size buffer size
+ */
+void pb_arena_init(pb_arena_t *arena, void *buffer, size_t size);
+
+/**
+ * @brief Release all allocations, the messages unpacked before are no longer valid
+ */
+void pb_arena_reset(pb_arena_t *arena);
+
+#endif /* PWRINSPACE_PB_ARENA_H_ */
@@ -0,0 +1,53 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "latency_hist.h"
+
+#include <string.h>
+
+void latency_hist_reset(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void latency_hist_add(latency_hist_t *hist, int64_t time_us) {
+    if (time_us < 0) {
+        time_us = 0;
+    }
+
+    uint8_t bucket = 0;
+    while (bucket < LATENCY_HIST_SIZE - 1 && time_us >= (1LL << bucket)) {
+        bucket++;
+    }
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->total_us += time_us;
+    if (time_us > hist->max_us) {
+        hist->max_us = (uint32_t)time_us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, float percentile) {
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    uint32_t rank = (uint32_t)(hist->count * percentile / 100.0f);
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < LATENCY_HIST_SIZE; ++i) {
+        sum += hist->buckets[i];
+        if (sum > rank) {
+            // the bucket bound can not be above the slowest sample
+            uint32_t bound = i < LATENCY_HIST_SIZE - 1 ? (1UL << i) : hist->max_us;
+            return bound < hist->max_us ? bound : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+float latency_hist_average(const latency_hist_t *hist) {
+    return hist->count > 0 ? (float)hist->total_us / hist->count : 0.0f;
+}
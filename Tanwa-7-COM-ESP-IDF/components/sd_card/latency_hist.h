@@ -0,0 +1,45 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the log2 latency histogram used by the SD task statistics
+/// and the SD benchmark. Adding a sample is a few instructions and no memory, the percentiles are
+/// estimated from the bucket bounds. Does not depend on ESP-IDF.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_LATENCY_HIST_H_
+#define PWRINSPACE_LATENCY_HIST_H_
+
+#include <stdint.h>
+
+#define LATENCY_HIST_SIZE 24  // bucket i counts latencies below 2^i us
+
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_SIZE];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_hist_t;
+
+void latency_hist_reset(latency_hist_t *hist);
+
+void latency_hist_add(latency_hist_t *hist, int64_t time_us);
+
+/**
+ * @brief Estimate the percentile from the histogram
+ *
+ * @param percentile percentile, 0 - 100
+ * @return upper bound of the bucket in us, 0 if the histogram is empty
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, float percentile);
+
+/**
+ * @return average latency in us, 0 if the histogram is empty
+ */
+float latency_hist_average(const latency_hist_t *hist);
+
+#endif /* PWRINSPACE_LATENCY_HIST_H_ */
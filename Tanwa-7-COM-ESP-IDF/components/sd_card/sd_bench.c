@@ -0,0 +1,188 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "sd_bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+#define PATH_SIZE 64
+#define SYNC_WRITE_SIZE 512
+
+static int64_t now_us(void) {
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static void lock(const sd_bench_cfg_t *cfg) {
+    if (cfg->lock != NULL) {
+        cfg->lock();
+    }
+}
+
+static void unlock(const sd_bench_cfg_t *cfg) {
+    if (cfg->unlock != NULL) {
+        cfg->unlock();
+    }
+}
+
+static float kbps(size_t bytes, int64_t time_us) {
+    return time_us > 0 ? (float)bytes * 1000.0f / time_us : 0.0f;
+}
+
+/**
+ * @brief Write the file in buffer sized chunks, sequentially or at random aligned offsets
+ *
+ * @note The random pass overwrites the file written by the sequential one, so it measures the
+ *       read-modify-write cost of the FAT layer without allocating clusters.
+ */
+static bool write_pass(const sd_bench_cfg_t *cfg, const char *path, uint8_t *buffer, size_t buffer_size,
+                       bool random, latency_hist_t *hist, float *throughput) {
+    size_t chunks = cfg->file_size / buffer_size;
+    lock(cfg);
+    FILE *file = fopen(path, random ? "r+" : "w");
+    if (file != NULL) {
+        setvbuf(file, NULL, _IONBF, 0);
+    }
+    unlock(cfg);
+    if (file == NULL) {
+        return false;
+    }
+
+    bool ret = true;
+    int64_t start = now_us();
+    for (size_t i = 0; i < chunks && ret == true; ++i) {
+        buffer[0] = (uint8_t)i;
+        int64_t write_start = now_us();
+        lock(cfg);
+        if (random) {
+            ret = fseek(file, (long)((size_t)rand() % chunks * buffer_size), SEEK_SET) == 0;
+        }
+        ret = ret && fwrite(buffer, 1, buffer_size, file) == buffer_size;
+        unlock(cfg);
+        latency_hist_add(hist, now_us() - write_start);
+    }
+    lock(cfg);
+    ret = ret && fsync(fileno(file)) == 0;
+    fclose(file);
+    unlock(cfg);
+
+    *throughput = kbps(chunks * buffer_size, now_us() - start);
+    return ret;
+}
+
+static bool open_close_pass(const sd_bench_cfg_t *cfg, const char *path, latency_hist_t *hist) {
+    for (uint32_t i = 0; i < cfg->open_close_count; ++i) {
+        int64_t start = now_us();
+        lock(cfg);
+        FILE *file = fopen(path, "a");
+        if (file != NULL) {
+            fclose(file);
+        }
+        unlock(cfg);
+        if (file == NULL) {
+            return false;
+        }
+        latency_hist_add(hist, now_us() - start);
+    }
+    return true;
+}
+
+static bool sync_pass(const sd_bench_cfg_t *cfg, const char *path, uint8_t *buffer, latency_hist_t *hist) {
+    lock(cfg);
+    FILE *file = fopen(path, "w");
+    if (file != NULL) {
+        setvbuf(file, NULL, _IONBF, 0);
+    }
+    unlock(cfg);
+    if (file == NULL) {
+        return false;
+    }
+
+    bool ret = true;
+    for (uint32_t i = 0; i < cfg->sync_count && ret == true; ++i) {
+        // small write and sync, the pattern of the SD task sync interval
+        int64_t start = now_us();
+        lock(cfg);
+        ret = fwrite(buffer, 1, SYNC_WRITE_SIZE, file) == SYNC_WRITE_SIZE && fsync(fileno(file)) == 0;
+        unlock(cfg);
+        latency_hist_add(hist, now_us() - start);
+    }
+    lock(cfg);
+    fclose(file);
+    unlock(cfg);
+    return ret;
+}
+
+void sd_bench_default_config(sd_bench_cfg_t *cfg, const char *dir) {
+    static const size_t sizes[] = {512, 1024, 4096, 8192, 16384, 32768};
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->dir = dir;
+    cfg->file_size = SD_BENCH_DEFAULT_FILE_SIZE;
+    cfg->buffer_size_count = sizeof(sizes) / sizeof(sizes[0]);
+    memcpy(cfg->buffer_sizes, sizes, sizeof(sizes));
+    cfg->open_close_count = SD_BENCH_DEFAULT_OPEN_CLOSE_COUNT;
+    cfg->sync_count = SD_BENCH_DEFAULT_SYNC_COUNT;
+}
+
+bool sd_bench_run(const sd_bench_cfg_t *cfg, sd_bench_result_t *result) {
+    if (cfg->buffer_size_count > SD_BENCH_MAX_BUFFER_SIZES) {
+        return false;
+    }
+
+    size_t max_buffer_size = SYNC_WRITE_SIZE;
+    for (uint8_t i = 0; i < cfg->buffer_size_count; ++i) {
+        if (cfg->buffer_sizes[i] == 0 || cfg->buffer_sizes[i] > cfg->file_size) {
+            return false;
+        }
+        if (cfg->buffer_sizes[i] > max_buffer_size) {
+            max_buffer_size = cfg->buffer_sizes[i];
+        }
+    }
+
+    uint8_t *buffer = malloc(max_buffer_size);
+    if (buffer == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < max_buffer_size; ++i) {
+        buffer[i] = (uint8_t)(i * 31 + 7);
+    }
+
+    char path[PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/" SD_BENCH_FILE_NAME, cfg->dir);
+    memset(result, 0, sizeof(*result));
+    srand(1);
+
+    bool ret = true;
+    for (uint8_t i = 0; i < cfg->buffer_size_count && ret == true; ++i) {
+        sd_bench_write_t *write = &result->write[i];
+        write->buffer_size = cfg->buffer_sizes[i];
+        ret = write_pass(cfg, path, buffer, write->buffer_size, false, &write->sequential, &write->sequential_kbps) &&
+              write_pass(cfg, path, buffer, write->buffer_size, true, &write->random, &write->random_kbps);
+        result->write_count = i + 1;
+    }
+    ret = ret && open_close_pass(cfg, path, &result->open_close) && sync_pass(cfg, path, buffer, &result->sync);
+
+    lock(cfg);
+    remove(path);
+    unlock(cfg);
+    free(buffer);
+    return ret;
+}
@@ -0,0 +1,74 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the SD card write benchmark. It measures sequential and
+/// random write throughput at several buffer sizes, fopen/fclose and fsync cost, all with latency
+/// histograms. Only stdio and POSIX calls are used, so the same code runs on the card and on the
+/// host against a mounted FAT image (tools/sd_bench_host.c).
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_SD_BENCH_H_
+#define PWRINSPACE_SD_BENCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "latency_hist.h"
+
+#define SD_BENCH_MAX_BUFFER_SIZES 8
+#define SD_BENCH_FILE_NAME "bench.bin"
+#define SD_BENCH_DEFAULT_FILE_SIZE (1024 * 1024)
+#define SD_BENCH_DEFAULT_OPEN_CLOSE_COUNT 50
+#define SD_BENCH_DEFAULT_SYNC_COUNT 50
+
+typedef struct {
+    const char *dir;  // directory of the test file, the file is removed at the end
+    size_t file_size;  // written for every buffer size
+    size_t buffer_sizes[SD_BENCH_MAX_BUFFER_SIZES];
+    uint8_t buffer_size_count;
+    uint32_t open_close_count;
+    uint32_t sync_count;
+    void (*lock)(void);  // taken around every file operation, can be NULL
+    void (*unlock)(void);
+} sd_bench_cfg_t;
+
+typedef struct {
+    size_t buffer_size;
+    float sequential_kbps;
+    float random_kbps;
+    latency_hist_t sequential;
+    latency_hist_t random;
+} sd_bench_write_t;
+
+typedef struct {
+    sd_bench_write_t write[SD_BENCH_MAX_BUFFER_SIZES];
+    uint8_t write_count;
+    latency_hist_t open_close;
+    latency_hist_t sync;
+} sd_bench_result_t;
+
+/**
+ * @brief Fill the config with the default buffer sizes and counts
+ */
+void sd_bench_default_config(sd_bench_cfg_t *cfg, const char *dir);
+
+/**
+ * @brief Run the benchmark
+ *
+ * @note Throughput includes the fsync at the end of every pass. Takes seconds, the test file is
+ *       file_size long.
+ *
+ * @param cfg pointer to the benchmark config
+ * @param result pointer to the result
+ * @return true :)
+ * @return false :C the test file can not be written
+ */
+bool sd_bench_run(const sd_bench_cfg_t *cfg, sd_bench_result_t *result);
+
+#endif /* PWRINSPACE_SD_BENCH_H_ */
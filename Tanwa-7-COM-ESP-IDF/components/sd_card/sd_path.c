@@ -0,0 +1,52 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "sd_path.h"
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+int SD_find_free_number(const char *dir, const char *prefix, const char *extension, int start, int max) {
+    if (max <= 0 || max > SD_FREE_NUMBER_MAX) {
+        return -1;
+    }
+
+    DIR *directory = opendir(dir);
+    if (directory == NULL) {
+        return -1;
+    }
+
+    uint8_t used[(SD_FREE_NUMBER_MAX + 7) / 8] = {0};
+    size_t prefix_length = strlen(prefix);
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL) {
+        // 8.3 names may come back in upper case
+        if (strncasecmp(entry->d_name, prefix, prefix_length) != 0) {
+            continue;
+        }
+
+        char *end;
+        const char *number_start = entry->d_name + prefix_length;
+        long number = strtol(number_start, &end, 10);
+        if (end == number_start || *number_start == '-' || number >= max || strcasecmp(end, extension) != 0) {
+            continue;
+        }
+        used[number / 8] |= 1 << (number % 8);
+    }
+    closedir(directory);
+
+    for (int i = 0; i < max; ++i) {
+        int number = (start + i) % max;
+        if ((used[number / 8] & (1 << (number % 8))) == 0) {
+            return number;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,30 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the numbered file name lookup. Only POSIX directory calls
+/// are used, so the same code runs on the card and on the host (tools/sd_boot_bench.c).
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_SD_PATH_H_
+#define PWRINSPACE_SD_PATH_H_
+
+#define SD_FREE_NUMBER_MAX 1000
+
+/*!
+ * \brief Find a free number for the file name with a single directory read
+ *
+ * \param dir directory of the file
+ * \param prefix file name before the number, case insensitive
+ * \param extension file name after the number, case insensitive, can be empty
+ * \param start first number checked, the search wraps around to 0
+ * \param max numbers are lower than max, at most SD_FREE_NUMBER_MAX
+ * \returns free number, -1 if all are used or the directory can not be read
+ */
+int SD_find_free_number(const char *dir, const char *prefix, const char *extension, int start, int max);
+
+#endif /* PWRINSPACE_SD_PATH_H_ */
@@ -2,6 +2,7 @@
 
 #include "sdcard.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
@@ -129,8 +130,8 @@ bool SD_write(sd_card_t *sd_card, const char *path, const char *data,
     return false;
   }
 
-  int written_bytes = 0;
-  written_bytes = fprintf(file, data, sd_card->card->cid.name);
+  // written as is, the data is not a format string
+  size_t written_bytes = fwrite(data, 1, strnlen(data, length), file);
   fclose(file);
 
   if (written_bytes < 1) {
@@ -160,22 +161,34 @@ bool SD_card_detect(sd_card_t *sd_card) {
 }
 
 bool create_path_to_file(char *file_path, size_t size) {
-  char *path = (char *)calloc(size, sizeof(char));
-  int ret = 0;
-  for (int i = 0; i < 1000; ++i) {
-    ret = snprintf(path, size, "%s%d.txt", file_path, i);
-    if (ret == size) {
-      free(path);
-      return false;
-    }
+  const char *name = strrchr(file_path, '/');
+  if (name == NULL) {
+    return false;
+  }
 
-    if (SD_file_exists(path) == false) {
-      memcpy(file_path, path, size);
-      free(path);
-      return true;
-    }
+  char dir[32];
+  int dir_length = name - file_path;
+  if (dir_length >= sizeof(dir)) {
+    return false;
+  }
+  snprintf(dir, sizeof(dir), "%.*s", dir_length, file_path);
+
+  int number = SD_find_free_number(dir, name + 1, ".txt", 0, SD_FREE_NUMBER_MAX);
+  if (number < 0) {
+    return false;
   }
 
+  char *path = (char *)calloc(size, sizeof(char));
+  if (path == NULL) {
+    return false;
+  }
+  int ret = snprintf(path, size, "%s%d.txt", file_path, number);
+  if (ret >= size) {
+    free(path);
+    return false;
+  }
+
+  memcpy(file_path, path, size);
   free(path);
-  return false;
+  return true;
 }
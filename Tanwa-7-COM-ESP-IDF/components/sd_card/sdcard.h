@@ -10,6 +10,8 @@
 #include "esp_vfs_fat.h"
 #include "sdmmc_cmd.h"
 
+#include "sd_path.h"
+
 #define SDCARD_MOUNT_POINT "/sdcard"
 #define SD_CREATE_FILE_PREFIX(usr_path) SDCARD_MOUNT_POINT "/" usr_path
 // 8 is a placeholder for _number_.txt
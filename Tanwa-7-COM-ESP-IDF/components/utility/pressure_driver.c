@@ -10,11 +10,71 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+// The mutex is created by pressure_driver_init, nothing can change the calibration concurrently
+// before that
+static void calibration_lock(pressure_driver_struct_t *pressure_driver) {
+    if (pressure_driver->calibration_mutex != NULL) {
+        xSemaphoreTake(pressure_driver->calibration_mutex, portMAX_DELAY);
+    }
+}
+
+static void calibration_unlock(pressure_driver_struct_t *pressure_driver) {
+    if (pressure_driver->calibration_mutex != NULL) {
+        xSemaphoreGive(pressure_driver->calibration_mutex);
+    }
+}
+
+static void adc_lock(pressure_driver_struct_t *pressure_driver) {
+    if (pressure_driver->adc_mutex != NULL) {
+        xSemaphoreTake(pressure_driver->adc_mutex, portMAX_DELAY);
+    }
+}
+
+static void adc_unlock(pressure_driver_struct_t *pressure_driver) {
+    if (pressure_driver->adc_mutex != NULL) {
+        xSemaphoreGive(pressure_driver->adc_mutex);
+    }
+}
+
+// Converts the min/max voltage and pressure to the raw ADC calibration, so reading the pressure
+// does not need to divide
+static pressure_driver_status_t update_default_calibration(pressure_sensor_struct_t *sensor) {
+    if (sensor->custom_calibration == true) {
+        return PRESSURE_DRIVER_OK;
+    }
+    if (sensor->voltage_max == sensor->voltage_min) {
+        return PRESSURE_DRIVER_FAIL;
+    }
+
+    float volts_per_bit = ads1115_gain_values[ADS1115_GAIN_4V096] / ADS1115_MAX_VALUE;
+    float pressure_per_volt = (sensor->pressure_max - sensor->pressure_min) / (sensor->voltage_max - sensor->voltage_min);
+    float gain = volts_per_bit * pressure_per_volt;
+    float offset = sensor->pressure_min - sensor->voltage_min * pressure_per_volt;
+    if (calibration_set_linear(&sensor->calibration, gain, offset) != CALIBRATION_OK) {
+        return PRESSURE_DRIVER_FAIL;
+    }
+
+    return PRESSURE_DRIVER_OK;
+}
+
 pressure_driver_status_t pressure_driver_init(pressure_driver_struct_t *pressure_driver) {
     if (pressure_driver == NULL) {
         return PRESSURE_DRIVER_FAIL;
     }
 
+    if (pressure_driver->calibration_mutex == NULL) {
+        pressure_driver->calibration_mutex = xSemaphoreCreateMutex();
+        if (pressure_driver->calibration_mutex == NULL) {
+            return PRESSURE_DRIVER_FAIL;
+        }
+    }
+    if (pressure_driver->adc_mutex == NULL) {
+        pressure_driver->adc_mutex = xSemaphoreCreateMutex();
+        if (pressure_driver->adc_mutex == NULL) {
+            return PRESSURE_DRIVER_FAIL;
+        }
+    }
+
     ads1115_set_mode(pressure_driver->ads1115, ADS1115_MODE_CONTINUOUS);
     vTaskDelay(pdMS_TO_TICKS(50));
     ads1115_set_data_rate(pressure_driver->ads1115, ADS1115_DATA_RATE_250);
@@ -44,7 +104,14 @@ pressure_driver_status_t pressure_driver_init(pressure_driver_struct_t *pressure
     ads1115_set_gain(pressure_driver->ads1115, ADS1115_GAIN_4V096);
     vTaskDelay(pdMS_TO_TICKS(50));
 
-    return PRESSURE_DRIVER_OK;
+    pressure_driver_status_t ret = PRESSURE_DRIVER_OK;
+    calibration_lock(pressure_driver);
+    for (int i = 0; i < PRESSURE_DRIVER_SENSOR_COUNT && ret == PRESSURE_DRIVER_OK; ++i) {
+        ret = update_default_calibration(&pressure_driver->sensors[i]);
+    }
+    calibration_unlock(pressure_driver);
+
+    return ret;
 }
 
 pressure_driver_status_t pressure_driver_set_min_pressure(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float pressure) {
@@ -52,9 +119,12 @@ pressure_driver_status_t pressure_driver_set_min_pressure(pressure_driver_struct
         return PRESSURE_DRIVER_FAIL;
     }
 
+    calibration_lock(pressure_driver);
     pressure_driver->sensors[sensor].pressure_min = pressure;
+    pressure_driver_status_t ret = update_default_calibration(&pressure_driver->sensors[sensor]);
+    calibration_unlock(pressure_driver);
 
-    return PRESSURE_DRIVER_OK;
+    return ret;
 }
 
 pressure_driver_status_t pressure_driver_set_max_pressure(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float pressure) {
@@ -62,9 +132,12 @@ pressure_driver_status_t pressure_driver_set_max_pressure(pressure_driver_struct
         return PRESSURE_DRIVER_FAIL;
     }
 
+    calibration_lock(pressure_driver);
     pressure_driver->sensors[sensor].pressure_max = pressure;
+    pressure_driver_status_t ret = update_default_calibration(&pressure_driver->sensors[sensor]);
+    calibration_unlock(pressure_driver);
 
-    return PRESSURE_DRIVER_OK;
+    return ret;
 }
 
 pressure_driver_status_t pressure_driver_set_min_voltage(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float voltage) {
@@ -72,9 +145,12 @@ pressure_driver_status_t pressure_driver_set_min_voltage(pressure_driver_struct_
         return PRESSURE_DRIVER_FAIL;
     }
 
+    calibration_lock(pressure_driver);
     pressure_driver->sensors[sensor].voltage_min = voltage;
+    pressure_driver_status_t ret = update_default_calibration(&pressure_driver->sensors[sensor]);
+    calibration_unlock(pressure_driver);
 
-    return PRESSURE_DRIVER_OK;
+    return ret;
 }
 
 pressure_driver_status_t pressure_driver_set_max_voltage(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float voltage) {
@@ -82,9 +158,12 @@ pressure_driver_status_t pressure_driver_set_max_voltage(pressure_driver_struct_
         return PRESSURE_DRIVER_FAIL;
     }
 
+    calibration_lock(pressure_driver);
     pressure_driver->sensors[sensor].voltage_max = voltage;
+    pressure_driver_status_t ret = update_default_calibration(&pressure_driver->sensors[sensor]);
+    calibration_unlock(pressure_driver);
 
-    return PRESSURE_DRIVER_OK;
+    return ret;
 }
 
 pressure_driver_status_t pressure_driver_read_voltage(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float *voltage) {
@@ -93,13 +172,32 @@ pressure_driver_status_t pressure_driver_read_voltage(pressure_driver_struct_t *
     }
 
     int16_t raw;
+    pressure_driver_status_t ret = pressure_driver_read_raw(pressure_driver, sensor, &raw);
+    if (ret != PRESSURE_DRIVER_OK) {
+        return ret;
+    }
+    *voltage = ads1115_gain_values[ADS1115_GAIN_4V096] / ADS1115_MAX_VALUE * raw;
+
+    return PRESSURE_DRIVER_OK;
+}
+
+pressure_driver_status_t pressure_driver_read_raw(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, int16_t *raw) {
+    if (pressure_driver == NULL) {
+        return PRESSURE_DRIVER_FAIL;
+    }
+
+    // another task must not switch the mux before the conversion of this channel is read
+    pressure_driver_status_t ret = PRESSURE_DRIVER_OK;
+    adc_lock(pressure_driver);
     vTaskDelay(pdMS_TO_TICKS(10));
     ads1115_set_input_mux(pressure_driver->ads1115, pressure_driver->sensors[sensor].adc_pin);
     vTaskDelay(pdMS_TO_TICKS(10));
-    ads1115_get_value(pressure_driver->ads1115, &raw);
-    *voltage = ads1115_gain_values[ADS1115_GAIN_4V096] / ADS1115_MAX_VALUE * raw;
+    if (ads1115_get_value(pressure_driver->ads1115, raw) != ADS1115_OK) {
+        ret = PRESSURE_DRIVER_READ_ERR;
+    }
+    adc_unlock(pressure_driver);
 
-    return PRESSURE_DRIVER_OK;
+    return ret;
 }
 
 pressure_driver_status_t pressure_driver_read_pressure(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float *pressure) {
@@ -107,9 +205,39 @@ pressure_driver_status_t pressure_driver_read_pressure(pressure_driver_struct_t
         return PRESSURE_DRIVER_FAIL;
     }
 
-    float voltage;
-    pressure_driver_read_voltage(pressure_driver, sensor, &voltage);
-    *pressure = (voltage - pressure_driver->sensors[sensor].voltage_min) * (pressure_driver->sensors[sensor].pressure_max - pressure_driver->sensors[sensor].pressure_min) / (pressure_driver->sensors[sensor].voltage_max - pressure_driver->sensors[sensor].voltage_min) + pressure_driver->sensors[sensor].pressure_min;
+    int16_t raw;
+    pressure_driver_status_t ret = pressure_driver_read_raw(pressure_driver, sensor, &raw);
+    if (ret != PRESSURE_DRIVER_OK) {
+        return ret;
+    }
+    calibration_lock(pressure_driver);
+    if (calibration_apply(&pressure_driver->sensors[sensor].calibration, raw, pressure) != CALIBRATION_OK) {
+        ret = PRESSURE_DRIVER_FAIL;
+    }
+    calibration_unlock(pressure_driver);
 
-    return PRESSURE_DRIVER_OK;
+    return ret;
+}
+
+pressure_driver_status_t pressure_driver_set_calibration(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, const calibration_channel_t *calibration) {
+    if (pressure_driver == NULL) {
+        return PRESSURE_DRIVER_FAIL;
+    }
+
+    if (calibration != NULL && calibration_is_valid(calibration) == false) {
+        return PRESSURE_DRIVER_FAIL;
+    }
+
+    pressure_driver_status_t ret = PRESSURE_DRIVER_OK;
+    calibration_lock(pressure_driver);
+    if (calibration == NULL) {
+        pressure_driver->sensors[sensor].custom_calibration = false;
+        ret = update_default_calibration(&pressure_driver->sensors[sensor]);
+    } else {
+        memcpy(&pressure_driver->sensors[sensor].calibration, calibration, sizeof(calibration_channel_t));
+        pressure_driver->sensors[sensor].custom_calibration = true;
+    }
+    calibration_unlock(pressure_driver);
+
+    return ret;
 }
\ No newline at end of file
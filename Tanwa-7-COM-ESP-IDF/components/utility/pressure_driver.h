@@ -19,7 +19,11 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
 #include "ads1115.h"
+#include "calibration.h"
 
 #define PRESSURE_DRIVER_SENSOR_COUNT 4
 
@@ -40,6 +44,7 @@
         .pressure_max = PRESSURE_DRIVER_DEFAULT_MAX_PRESSURE,   \
         .voltage_min = PRESSURE_DRIVER_DEFAULT_MIN_VOLTAGE,     \
         .voltage_max = PRESSURE_DRIVER_DEFAULT_MAX_VOLTAGE,     \
+        .custom_calibration = false,                            \
       },                                                        \
       {                                                         \
         .sensor = PRESSURE_DRIVER_SENSOR_2,                     \
@@ -48,6 +53,7 @@
         .pressure_max = PRESSURE_DRIVER_DEFAULT_MAX_PRESSURE,   \
         .voltage_min = PRESSURE_DRIVER_DEFAULT_MIN_VOLTAGE,     \
         .voltage_max = PRESSURE_DRIVER_DEFAULT_MAX_VOLTAGE,     \
+        .custom_calibration = false,                            \
       },                                                        \
       {                                                         \
         .sensor = PRESSURE_DRIVER_SENSOR_3,                     \
@@ -56,6 +62,7 @@
         .pressure_max = PRESSURE_DRIVER_DEFAULT_MAX_PRESSURE,   \
         .voltage_min = PRESSURE_DRIVER_DEFAULT_MIN_VOLTAGE,     \
         .voltage_max = PRESSURE_DRIVER_DEFAULT_MAX_VOLTAGE,     \
+        .custom_calibration = false,                            \
       },                                                        \
       {                                                         \
         .sensor = PRESSURE_DRIVER_SENSOR_4,                     \
@@ -64,6 +71,7 @@
         .pressure_max = PRESSURE_DRIVER_DEFAULT_MAX_PRESSURE,   \
         .voltage_min = PRESSURE_DRIVER_DEFAULT_MIN_VOLTAGE,     \
         .voltage_max = PRESSURE_DRIVER_DEFAULT_MAX_VOLTAGE,     \
+        .custom_calibration = false,                            \
       },                                                        \
     }                                                           \
   }
@@ -95,11 +103,15 @@ typedef struct {
     float pressure_max;
     float voltage_min;
     float voltage_max;
+    calibration_channel_t calibration;
+    bool custom_calibration;
 } pressure_sensor_struct_t;
 
 typedef struct {
     ads1115_struct_t *ads1115;
     pressure_sensor_struct_t sensors[PRESSURE_DRIVER_SENSOR_COUNT];
+    SemaphoreHandle_t calibration_mutex;  // the calibrations are replaced from the console task
+    SemaphoreHandle_t adc_mutex;  // mux and read of the ADS1115, the console task reads calibration points
 } pressure_driver_struct_t;
 
 pressure_driver_status_t pressure_driver_init(pressure_driver_struct_t *pressure_driver);
@@ -114,6 +126,15 @@ pressure_driver_status_t pressure_driver_set_max_voltage(pressure_driver_struct_
 
 pressure_driver_status_t pressure_driver_read_voltage(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float *voltage);
 
+pressure_driver_status_t pressure_driver_read_raw(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, int16_t *raw);
+
 pressure_driver_status_t pressure_driver_read_pressure(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, float *pressure);
 
+/**
+ * @brief Replace the linear min/max calibration of the sensor with the calibration table
+ * @param calibration calibration mapping raw ADS1115 values to pressure, NULL restores the
+ *                    calibration based on the min/max voltage and pressure
+ */
+pressure_driver_status_t pressure_driver_set_calibration(pressure_driver_struct_t *pressure_driver, pressure_driver_sensor_t sensor, const calibration_channel_t *calibration);
+
 #endif /* PWRINSPACE_PRESSURE_DRIVER_H_ */
\ No newline at end of file
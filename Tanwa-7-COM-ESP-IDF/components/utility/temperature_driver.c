@@ -0,0 +1,89 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include "temperature_driver.h"
+
+// conversion times rounded up to the full millisecond, indexed by tmp1075_conversion_time_t
+static const uint32_t conv_time_ms[] = {28, 55, 110, 220};
+
+temperature_driver_status_t temperature_driver_init(temperature_driver_struct_t *temperature_driver) {
+    if (temperature_driver == NULL) {
+        return TEMPERATURE_DRIVER_FAIL;
+    }
+
+    for (int i = 0; i < TEMPERATURE_DRIVER_SENSOR_COUNT; ++i) {
+        if (tmp1075_set_conv_time(temperature_driver->tmp1075[i], temperature_driver->conv_time) != TMP1075_OK) {
+            return TEMPERATURE_DRIVER_WRITE_ERR;
+        }
+        if (tmp1075_set_conv_mode(temperature_driver->tmp1075[i], true) != TMP1075_OK) {
+            return TEMPERATURE_DRIVER_WRITE_ERR;
+        }
+    }
+    temperature_driver->conversion_pending = false;
+
+    return TEMPERATURE_DRIVER_OK;
+}
+
+temperature_driver_status_t temperature_driver_start_conversion(temperature_driver_struct_t *temperature_driver) {
+    if (temperature_driver == NULL) {
+        return TEMPERATURE_DRIVER_FAIL;
+    }
+
+    if (temperature_driver->conversion_pending == true) {
+        return TEMPERATURE_DRIVER_BUSY;
+    }
+
+    for (int i = 0; i < TEMPERATURE_DRIVER_SENSOR_COUNT; ++i) {
+        if (tmp1075_start_conv(temperature_driver->tmp1075[i]) != TMP1075_OK) {
+            temperature_driver->error_count++;
+            return TEMPERATURE_DRIVER_WRITE_ERR;
+        }
+    }
+    temperature_driver->conversion_pending = true;
+
+    return TEMPERATURE_DRIVER_OK;
+}
+
+temperature_driver_status_t temperature_driver_read_conversion(temperature_driver_struct_t *temperature_driver) {
+    if (temperature_driver == NULL) {
+        return TEMPERATURE_DRIVER_FAIL;
+    }
+
+    if (temperature_driver->conversion_pending == false) {
+        return TEMPERATURE_DRIVER_FAIL;
+    }
+    // the conversion is consumed even if the read fails, the next one has to be started anyway
+    temperature_driver->conversion_pending = false;
+
+    float temperature[TEMPERATURE_DRIVER_SENSOR_COUNT];
+    for (int i = 0; i < TEMPERATURE_DRIVER_SENSOR_COUNT; ++i) {
+        if (tmp1075_get_temp_celsius(temperature_driver->tmp1075[i], &temperature[i]) != TMP1075_OK) {
+            temperature_driver->error_count++;
+            return TEMPERATURE_DRIVER_READ_ERR;
+        }
+    }
+    for (int i = 0; i < TEMPERATURE_DRIVER_SENSOR_COUNT; ++i) {
+        temperature_driver->temperature[i] = temperature[i];
+    }
+    temperature_driver->sample_count++;
+
+    return TEMPERATURE_DRIVER_OK;
+}
+
+temperature_driver_status_t temperature_driver_get_temperature(temperature_driver_struct_t *temperature_driver, temperature_driver_sensor_t sensor, float *temperature) {
+    if (temperature_driver == NULL || sensor >= TEMPERATURE_DRIVER_SENSOR_COUNT) {
+        return TEMPERATURE_DRIVER_FAIL;
+    }
+
+    *temperature = temperature_driver->temperature[sensor];
+
+    return TEMPERATURE_DRIVER_OK;
+}
+
+uint32_t temperature_driver_get_conv_time_ms(temperature_driver_struct_t *temperature_driver) {
+    return conv_time_ms[temperature_driver->conv_time & 0b11] + TEMPERATURE_DRIVER_CONV_MARGIN_MS;
+}
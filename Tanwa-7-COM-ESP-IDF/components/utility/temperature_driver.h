@@ -0,0 +1,86 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the temperature sensor utility. Both TMP1075 sensors work in
+/// the one-shot mode, the conversions are started back-to-back and the results are read once the
+/// configured conversion time has elapsed, so every new sample is read from the bus exactly once.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_TEMPERATURE_DRIVER_H_
+#define PWRINSPACE_TEMPERATURE_DRIVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tmp1075.h"
+
+#define TEMPERATURE_DRIVER_SENSOR_COUNT 2
+
+#define TEMPERATURE_DRIVER_DEFAULT_CONV_TIME TMP1075_CONV_TIME_27_5MS
+#define TEMPERATURE_DRIVER_CONV_MARGIN_MS 2
+
+#define TEMPERATURE_DRIVER_TANWA_CONFIG(X, Y)                   \
+  {                                                             \
+    .tmp1075 = {X, Y},                                          \
+    .conv_time = TEMPERATURE_DRIVER_DEFAULT_CONV_TIME,          \
+    .temperature = {0.0f, 0.0f},                                \
+    .conversion_pending = false,                                \
+    .sample_count = 0,                                          \
+    .error_count = 0,                                           \
+  }
+
+typedef enum {
+    TEMPERATURE_DRIVER_SENSOR_1 = 0,
+    TEMPERATURE_DRIVER_SENSOR_2,
+} temperature_driver_sensor_t;
+
+typedef enum {
+    TEMPERATURE_DRIVER_OK = 0,
+    TEMPERATURE_DRIVER_FAIL = 1,
+    TEMPERATURE_DRIVER_READ_ERR = 2,
+    TEMPERATURE_DRIVER_WRITE_ERR = 3,
+    TEMPERATURE_DRIVER_BUSY = 4,
+} temperature_driver_status_t;
+
+typedef struct {
+    tmp1075_struct_t *tmp1075[TEMPERATURE_DRIVER_SENSOR_COUNT];
+    tmp1075_conversion_time_t conv_time;
+    volatile float temperature[TEMPERATURE_DRIVER_SENSOR_COUNT];
+    volatile bool conversion_pending;
+    volatile uint32_t sample_count;
+    uint32_t error_count;
+} temperature_driver_struct_t;
+
+/**
+ * @brief Switches both sensors to the one-shot mode with the configured conversion time
+ */
+temperature_driver_status_t temperature_driver_init(temperature_driver_struct_t *temperature_driver);
+
+/**
+ * @brief Starts the conversion on both sensors back-to-back
+ * @return TEMPERATURE_DRIVER_BUSY if the previous conversion was not read yet
+ */
+temperature_driver_status_t temperature_driver_start_conversion(temperature_driver_struct_t *temperature_driver);
+
+/**
+ * @brief Reads the result of the pending conversion from both sensors
+ * @note Has to be called at least temperature_driver_get_conv_time_ms() after the start
+ */
+temperature_driver_status_t temperature_driver_read_conversion(temperature_driver_struct_t *temperature_driver);
+
+/**
+ * @brief Returns the last temperature read from the sensor, does not touch the bus
+ */
+temperature_driver_status_t temperature_driver_get_temperature(temperature_driver_struct_t *temperature_driver, temperature_driver_sensor_t sensor, float *temperature);
+
+/**
+ * @brief Returns the time after which the started conversion can be read, including the margin
+ */
+uint32_t temperature_driver_get_conv_time_ms(temperature_driver_struct_t *temperature_driver);
+
+#endif /* PWRINSPACE_TEMPERATURE_DRIVER_H_ */
@@ -0,0 +1,59 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Linux shim of the legacy ESP-IDF I2C driver API, only the declarations. The host tool that
+/// builds an I2C user defines the functions as a mocked bus.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_DRIVER_I2C_H_
+#define PWRINSPACE_HOST_DRIVER_I2C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef int i2c_port_t;
+typedef int gpio_num_t;
+typedef void *i2c_cmd_handle_t;
+
+typedef enum {
+    I2C_MODE_SLAVE = 0,
+    I2C_MODE_MASTER,
+} i2c_mode_t;
+
+typedef enum {
+    GPIO_PULLUP_DISABLE = 0,
+    GPIO_PULLUP_ENABLE,
+} gpio_pullup_t;
+
+typedef struct {
+    i2c_mode_t mode;
+    int sda_io_num;
+    int scl_io_num;
+    gpio_pullup_t sda_pullup_en;
+    gpio_pullup_t scl_pullup_en;
+    struct {
+        uint32_t clk_speed;
+    } master;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *config);
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t slave_rx_buffer, size_t slave_tx_buffer,
+                             int interrupt_flags);
+
+esp_err_t i2c_master_write_to_device(i2c_port_t port, uint8_t address, const uint8_t *write_buffer,
+                                     size_t write_size, TickType_t ticks);
+
+esp_err_t i2c_master_write_read_device(i2c_port_t port, uint8_t address, const uint8_t *write_buffer,
+                                       size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                       TickType_t ticks);
+
+#endif /* PWRINSPACE_HOST_DRIVER_I2C_H_ */
@@ -0,0 +1,26 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Linux shim of esp_err.h.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_ESP_ERR_H_
+#define PWRINSPACE_HOST_ESP_ERR_H_
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+static inline const char *esp_err_to_name(esp_err_t code) {
+    return code == ESP_OK ? "ESP_OK" : "ESP_FAIL";
+}
+
+#endif /* PWRINSPACE_HOST_ESP_ERR_H_ */
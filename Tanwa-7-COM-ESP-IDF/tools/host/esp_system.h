@@ -0,0 +1,19 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Linux shim of esp_system.h, only the standard headers it brings in through esp_err.h.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_ESP_SYSTEM_H_
+#define PWRINSPACE_HOST_ESP_SYSTEM_H_
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#endif /* PWRINSPACE_HOST_ESP_SYSTEM_H_ */
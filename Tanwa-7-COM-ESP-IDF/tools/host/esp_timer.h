@@ -0,0 +1,24 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Linux shim of esp_timer_get_time, the monotonic clock in microseconds.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_ESP_TIMER_H_
+#define PWRINSPACE_HOST_ESP_TIMER_H_
+
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t)time.tv_sec * 1000000 + time.tv_nsec / 1000;
+}
+
+#endif /* PWRINSPACE_HOST_ESP_TIMER_H_ */
@@ -0,0 +1,35 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_SEMPHR_H_
+#define PWRINSPACE_HOST_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_mutex *SemaphoreHandle_t;
+
+typedef struct {
+    _Alignas(16) uint8_t storage[192];  // struct host_mutex
+} StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+/**
+ * @brief Binary semaphore in the given buffer, created empty, does not use the heap
+ */
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer);
+
+/**
+ * @note Waits without a timeout, the host tools do not hold the mutexes for long
+ */
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks);
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex);
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex);
+
+#endif /* PWRINSPACE_HOST_SEMPHR_H_ */
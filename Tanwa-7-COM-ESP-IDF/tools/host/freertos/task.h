@@ -0,0 +1,32 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_TASK_H_
+#define PWRINSPACE_HOST_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *parameters);
+
+/**
+ * @note The task is a detached thread, the stack size, priority and core are ignored
+ */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size,
+                                   void *parameters, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+
+void vTaskDelete(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+/**
+ * @note Takes the notifications of the calling task, the host tools have one notified task
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+#endif /* PWRINSPACE_HOST_TASK_H_ */
@@ -0,0 +1,13 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_TIMERS_H_
+#define PWRINSPACE_HOST_TIMERS_H_
+
+#include "freertos/FreeRTOS.h"
+
+#endif /* PWRINSPACE_HOST_TIMERS_H_ */
@@ -0,0 +1,199 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+struct host_mutex {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;  // binary semaphore only
+    bool binary;
+    bool given;
+    bool is_static;
+};
+
+_Static_assert(sizeof(struct host_mutex) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+
+struct host_queue {
+    pthread_mutex_t mutex;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t items[];
+};
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *parameters;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t notifications;
+};
+
+static _Thread_local TaskHandle_t current_task;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t mutex = calloc(1, sizeof(struct host_mutex));
+    if (mutex != NULL) {
+        pthread_mutex_init(&mutex->mutex, NULL);
+    }
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer) {
+    SemaphoreHandle_t semaphore = (SemaphoreHandle_t)buffer->storage;
+    memset(semaphore, 0, sizeof(*semaphore));
+    pthread_mutex_init(&semaphore->mutex, NULL);
+    pthread_cond_init(&semaphore->cond, NULL);
+    semaphore->binary = true;
+    semaphore->is_static = true;
+    return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    (void)ticks;
+    if (mutex->binary == false) {
+        return pthread_mutex_lock(&mutex->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    pthread_mutex_lock(&mutex->mutex);
+    while (mutex->given == false) {
+        pthread_cond_wait(&mutex->cond, &mutex->mutex);
+    }
+    mutex->given = false;
+    pthread_mutex_unlock(&mutex->mutex);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    if (mutex->binary == false) {
+        return pthread_mutex_unlock(&mutex->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    pthread_mutex_lock(&mutex->mutex);
+    BaseType_t ret = mutex->given ? pdFALSE : pdTRUE;
+    mutex->given = true;
+    pthread_cond_signal(&mutex->cond);
+    pthread_mutex_unlock(&mutex->mutex);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+    if (mutex->binary) {
+        pthread_cond_destroy(&mutex->cond);
+    }
+    if (mutex->is_static == false) {
+        free(mutex);
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t queue = calloc(1, sizeof(struct host_queue) + (size_t)length * item_size);
+    if (queue != NULL) {
+        pthread_mutex_init(&queue->mutex, NULL);
+        queue->length = length;
+        queue->item_size = item_size;
+    }
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    (void)ticks;
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->count < queue->length) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + (size_t)tail * queue->item_size, item, queue->item_size);
+        queue->count++;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    (void)ticks;
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&queue->mutex);
+    if (queue->count > 0) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return ret;
+}
+
+static void *task_thread(void *arg) {
+    current_task = arg;
+    current_task->function(current_task->parameters);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_size,
+                                   void *parameters, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core) {
+    (void)name;
+    (void)stack_size;
+    (void)priority;
+    (void)core;
+    TaskHandle_t task = calloc(1, sizeof(struct host_task));
+    if (task == NULL) {
+        return pdFALSE;
+    }
+    task->function = function;
+    task->parameters = parameters;
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    // the handle is set before the task runs, like the FreeRTOS scheduler of a lower priority task
+    if (handle != NULL) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_thread, task) != 0) {
+        free(task);
+        if (handle != NULL) {
+            *handle = NULL;
+        }
+        return pdFALSE;
+    }
+    pthread_detach(task->thread);
+    return pdTRUE;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+    pthread_exit(NULL);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->mutex);
+    task->notifications++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+    return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    (void)ticks;
+    TaskHandle_t task = current_task;
+    pthread_mutex_lock(&task->mutex);
+    while (task->notifications == 0) {
+        pthread_cond_wait(&task->cond, &task->mutex);
+    }
+    uint32_t notifications = task->notifications;
+    task->notifications = clear_on_exit ? 0 : notifications - 1;
+    pthread_mutex_unlock(&task->mutex);
+    return notifications;
+}
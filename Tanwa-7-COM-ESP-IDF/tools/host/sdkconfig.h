@@ -0,0 +1,27 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Configuration of the host tools, the defaults of main/Kconfig.projbuild that the shared
+/// sources use.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_HOST_SDKCONFIG_H_
+#define PWRINSPACE_HOST_SDKCONFIG_H_
+
+#define CONFIG_I2C_SDA 21
+#define CONFIG_I2C_SCL 22
+#define CONFIG_I2C_MASTER_PORT_NUM 0
+#define CONFIG_I2C_MASTER_FREQUENCY 400000
+#define CONFIG_I2C_MASTER_TIMEOUT_MS 1000
+#define CONFIG_I2C_PCA9574_ADDR 32
+#define CONFIG_I2C_MCP23018_ADDR 39
+#define CONFIG_I2C_ADS1115_ADDR 73
+#define CONFIG_I2C_TMP1075_TS1_ADDR 78
+#define CONFIG_I2C_TMP1075_TS2_ADDR 79
+
+#endif /* PWRINSPACE_HOST_SDKCONFIG_H_ */
@@ -0,0 +1,186 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host benchmark and heap check of the I2C register write path. mcu_i2c_config.c runs on mocked
+/// i2c_master_x functions, first in the caller context (before mcu_i2c_init), then through the
+/// bus manager task and its priority queues with the FreeRTOS shim in tools/host. malloc and free
+/// are wrapped by the linker, the writes have to make no heap call and the heap in use and free
+/// has to be the same after the run. The bus time of a write is modeled from the SCL clock, the
+/// measured time is the software cost on the host.
+///
+/// Build:
+///   gcc -std=gnu11 -O2 -Ihost -I../components/mcu_config i2c_bench_host.c
+///       ../components/mcu_config/mcu_i2c_config.c host/host_rtos.c
+///       -Wl,--wrap=malloc -Wl,--wrap=free -lpthread -o i2c_bench_host
+/// Usage:
+///   i2c_bench_host [writes]
+///===-----------------------------------------------------------------------------------------===//
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "mcu_i2c_config.h"
+
+#define DEFAULT_WRITES 1000000
+#define WRITE_SIZE 2  // TMP1075 configuration register, the solenoid writes are 1 byte
+
+void *__real_malloc(size_t size);
+void __real_free(void *pointer);
+
+static struct {
+    uint64_t mallocs;
+    uint64_t frees;
+} heap;
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&heap.mallocs, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void __wrap_free(void *pointer) {
+    if (pointer != NULL) {
+        __atomic_add_fetch(&heap.frees, 1, __ATOMIC_RELAXED);
+    }
+    __real_free(pointer);
+}
+
+static struct {
+    uint64_t writes;
+    uint64_t bytes;
+    uint8_t last[MCU_I2C_MAX_WRITE_LEN + 1];
+} bus_mock;
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *config) {
+    (void)port;
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t slave_rx_buffer, size_t slave_tx_buffer,
+                             int interrupt_flags) {
+    (void)port;
+    (void)mode;
+    (void)slave_rx_buffer;
+    (void)slave_tx_buffer;
+    (void)interrupt_flags;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_write_to_device(i2c_port_t port, uint8_t address, const uint8_t *write_buffer,
+                                     size_t write_size, TickType_t ticks) {
+    (void)port;
+    (void)address;
+    (void)ticks;
+    if (write_size > sizeof(bus_mock.last)) {
+        return ESP_FAIL;
+    }
+    memcpy(bus_mock.last, write_buffer, write_size);
+    bus_mock.writes++;
+    bus_mock.bytes += write_size;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_write_read_device(i2c_port_t port, uint8_t address, const uint8_t *write_buffer,
+                                       size_t write_size, uint8_t *read_buffer, size_t read_size,
+                                       TickType_t ticks) {
+    (void)port;
+    (void)address;
+    (void)write_buffer;
+    (void)write_size;
+    (void)ticks;
+    memset(read_buffer, 0, read_size);
+    return ESP_OK;
+}
+
+typedef struct {
+    uint32_t errors;
+    uint64_t mallocs;
+    uint64_t frees;
+    size_t in_use_before;
+    size_t in_use_after;
+    size_t free_before;
+    size_t free_after;
+    double avg_ns;
+    double max_us;
+} run_result_t;
+
+static void run(uint32_t writes, run_result_t *result) {
+    uint8_t config[WRITE_SIZE] = {0x60, 0xff};
+    memset(result, 0, sizeof(*result));
+    struct mallinfo2 before = mallinfo2();
+    memset(&heap, 0, sizeof(heap));
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < writes; ++i) {
+        int64_t write_start_us = esp_timer_get_time();
+        config[1] = (uint8_t)i;
+        if (_mcu_i2c_write(CONFIG_I2C_TMP1075_TS1_ADDR, 0x01, config, sizeof(config)) == false ||
+            bus_mock.last[2] != config[1]) {
+            result->errors++;
+        }
+        double write_us = (double)(esp_timer_get_time() - write_start_us);
+        if (write_us > result->max_us) {
+            result->max_us = write_us;
+        }
+    }
+    result->avg_ns = (esp_timer_get_time() - start_us) * 1000.0 / writes;
+    result->mallocs = heap.mallocs;
+    result->frees = heap.frees;
+    struct mallinfo2 after = mallinfo2();
+    result->in_use_before = before.uordblks;
+    result->in_use_after = after.uordblks;
+    result->free_before = before.fordblks;
+    result->free_after = after.fordblks;
+}
+
+static void print_run(const char *name, const run_result_t *result) {
+    printf("%-12s avg %7.1f ns, max %6.0f us, %u errors, heap %llu malloc / %llu free, in use %zu -> %zu B, "
+           "free %zu -> %zu B\n",
+           name, result->avg_ns, result->max_us, result->errors, (unsigned long long)result->mallocs,
+           (unsigned long long)result->frees, result->in_use_before, result->in_use_after, result->free_before,
+           result->free_after);
+}
+
+static bool run_ok(const run_result_t *result) {
+    return result->errors == 0 && result->mallocs == 0 && result->frees == 0 &&
+           result->in_use_before == result->in_use_after && result->free_before == result->free_after;
+}
+
+int main(int argc, char **argv) {
+    uint32_t writes = argc >= 2 ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_WRITES;
+    if (writes == 0) {
+        fprintf(stderr, "usage: %s [writes]\n", argv[0]);
+        return 1;
+    }
+
+    // start, address, register and data bytes with the ACK bits, stop
+    double bus_us = (2 + 1 + 1 + WRITE_SIZE) * 9 * 1e6 / CONFIG_I2C_MASTER_FREQUENCY;
+    printf("%u writes of %d B, modeled bus time %.1f us at %d Hz\n", writes, WRITE_SIZE, bus_us,
+           CONFIG_I2C_MASTER_FREQUENCY);
+
+    run_result_t caller, manager;
+    run(writes, &caller);
+    print_run("caller", &caller);
+    if (mcu_i2c_init() != ESP_OK) {
+        fprintf(stderr, "bus manager init failed\n");
+        return 1;
+    }
+    run(writes, &manager);
+    print_run("bus manager", &manager);
+
+    mcu_i2c_bus_stats_t stats;
+    mcu_i2c_get_stats(&stats);
+    printf("bus manager  %u batches, max batch %u, queue full %u, mock bus %llu writes\n", stats.batches,
+           stats.max_batch_size, stats.queue_full, (unsigned long long)bus_mock.writes);
+
+    bool ok = run_ok(&caller) && run_ok(&manager);
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
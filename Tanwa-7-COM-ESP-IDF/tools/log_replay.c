@@ -0,0 +1,456 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+
+#define _GNU_SOURCE
+
+#include "log_replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "record_codec.h"
+#include "telemetry_frames.h"
+#include "TANWA_data.h"
+
+#define PATH_SIZE 512
+#define CSV_LINE_SIZE 1024
+
+///===-----------------------------------------------------------------------------------------===//
+/// loading
+///===-----------------------------------------------------------------------------------------===//
+
+static bool read_file(const char *path, uint8_t **data, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "can not open %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    *data = malloc(length > 0 ? (size_t)length : 1);
+    if (*data == NULL || fread(*data, 1, (size_t)length, file) != (size_t)length) {
+        fprintf(stderr, "can not read %s\n", path);
+        free(*data);
+        fclose(file);
+        return false;
+    }
+    *size = (size_t)length;
+    fclose(file);
+    return true;
+}
+
+static bool push_sample(log_replay_session_t *session, const tanwa_log_sample_t *sample) {
+    if (session->count >= session->capacity) {
+        size_t capacity = session->capacity > 0 ? session->capacity * 2 : 4096;
+        tanwa_log_sample_t *samples = realloc(session->samples, capacity * sizeof(tanwa_log_sample_t));
+        if (samples == NULL) {
+            return false;
+        }
+        session->samples = samples;
+        session->capacity = capacity;
+    }
+    session->samples[session->count++] = *sample;
+    return true;
+}
+
+static void push_record(log_replay_session_t *session, const uint8_t *record) {
+    tanwa_log_sample_t sample;
+    if (tanwa_log_decode_sample(record, &sample) == false) {
+        session->crc_errors++;
+        return;
+    }
+    push_sample(session, &sample);
+}
+
+static void on_frame(void *context, const tanwa_log_frame_t *frame, size_t offset) {
+    (void)offset;
+    log_replay_session_t *session = context;
+    if (frame->type == TANWA_LOG_FRAME_RECORD && frame->length == TANWA_LOG_RECORD_SIZE) {
+        push_record(session, frame->payload);
+        return;
+    }
+    if (frame->type != TANWA_LOG_FRAME_BLOCK) {
+        // backpressure and summary frames are not a part of the data path
+        return;
+    }
+
+    static uint8_t records[RECORD_CODEC_BLOCK_SIZE * 8];
+    size_t block_size = 0;
+    uint16_t record_size = 0;
+    size_t count = record_codec_decode_block(frame->payload, frame->length, records, sizeof(records),
+                                             &block_size, &record_size);
+    if (count == 0 || record_size != TANWA_LOG_RECORD_SIZE) {
+        session->crc_errors++;
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        push_record(session, records + i * record_size);
+    }
+}
+
+/**
+ * @brief Version 2 and older files, records or codec blocks without frames
+ */
+static void load_unframed(log_replay_session_t *session, const tanwa_log_schema_t *schema, const uint8_t *data,
+                          size_t size) {
+    size_t pos = schema->header_size;
+    if ((schema->flags & TANWA_LOG_FLAG_COMPRESSED) == 0) {
+        for (; pos + TANWA_LOG_RECORD_SIZE <= size; pos += TANWA_LOG_RECORD_SIZE) {
+            push_record(session, data + pos);
+        }
+        return;
+    }
+
+    static uint8_t records[RECORD_CODEC_BLOCK_SIZE * 8];
+    while (pos < size) {
+        size_t block_size = 0;
+        uint16_t record_size = 0;
+        size_t count = record_codec_decode_block(data + pos, size - pos, records, sizeof(records), &block_size,
+                                                 &record_size);
+        if (count == 0 || record_size != TANWA_LOG_RECORD_SIZE) {
+            session->crc_errors++;
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            push_record(session, records + i * record_size);
+        }
+        pos += block_size;
+    }
+}
+
+static bool load_binary(log_replay_session_t *session, const char *path, const uint8_t *data, size_t size) {
+    static tanwa_log_schema_t schema;
+    if (tanwa_log_parse_header(data, size, &schema) == false) {
+        fprintf(stderr, "%s: wrong header\n", path);
+        return false;
+    }
+    if (tanwa_log_schema_is_builtin(&schema) == false) {
+        fprintf(stderr, "%s: recorded with a different schema, not supported by the replay\n", path);
+        return false;
+    }
+
+    if (schema.version >= 3) {
+        tanwa_log_scanner_t scanner;
+        tanwa_log_scanner_init(&scanner, schema.header_size, on_frame, session);
+        tanwa_log_scanner_feed(&scanner, data + schema.header_size, size - schema.header_size, true);
+    } else {
+        load_unframed(session, &schema, data, size);
+    }
+    session->files++;
+    return true;
+}
+
+static bool parse_csv_line(char *line, tanwa_data_t *data) {
+    double values[LOG_REPLAY_CSV_FIELDS];
+    size_t count = 0;
+    char *save = NULL;
+    for (char *field = strtok_r(line, ";\r\n", &save); field != NULL && count < LOG_REPLAY_CSV_FIELDS;
+         field = strtok_r(NULL, ";\r\n", &save)) {
+        char *end = NULL;
+        values[count++] = strtod(field, &end);
+        if (end == field) {
+            return false;
+        }
+    }
+    if (count != LOG_REPLAY_CSV_FIELDS) {
+        return false;
+    }
+
+    // same order as convert_data_to_frame in sd_task.c
+    const double *v = values;
+    memset(data, 0, sizeof(*data));
+    data->state = (uint8_t)*v++;
+    data->com_data.vbat = (float)*v++;
+    data->com_data.solenoid_state_fill = *v++ != 0;
+    data->com_data.solenoid_state_depr = *v++ != 0;
+    data->com_data.pressure_1 = (float)*v++;
+    data->com_data.pressure_2 = (float)*v++;
+    data->com_data.pressure_3 = (float)*v++;
+    data->com_data.pressure_4 = (float)*v++;
+    data->com_data.temperature_1 = (float)*v++;
+    data->com_data.temperature_2 = (float)*v++;
+    data->com_data.igniter_cont_1 = *v++ != 0;
+    data->com_data.igniter_cont_2 = *v++ != 0;
+    data->can_connected_slaves.hx_rocket = *v++ != 0;
+    data->can_connected_slaves.hx_oxidizer = *v++ != 0;
+    data->can_connected_slaves.fac = *v++ != 0;
+    data->can_connected_slaves.flc = *v++ != 0;
+    data->can_connected_slaves.termo = *v++ != 0;
+    data->can_hx_rocket_status.status = (uint16_t)*v++;
+    data->can_hx_rocket_status.request = (uint8_t)*v++;
+    data->can_hx_rocket_status.temperature = (int16_t)*v++;
+    data->can_hx_rocket_data.weight = (float)*v++;
+    data->can_hx_rocket_data.weight_raw = (uint32_t)*v++;
+    data->can_hx_oxidizer_status.status = (uint16_t)*v++;
+    data->can_hx_oxidizer_status.request = (uint8_t)*v++;
+    data->can_hx_oxidizer_status.temperature = (int16_t)*v++;
+    data->can_hx_oxidizer_data.weight = (float)*v++;
+    data->can_hx_oxidizer_data.weight_raw = (uint32_t)*v++;
+    data->can_fac_status.status = (uint16_t)*v++;
+    data->can_fac_status.request = (uint8_t)*v++;
+    data->can_fac_status.motor_state_1 = (uint8_t)*v++;
+    data->can_fac_status.motor_state_2 = (uint8_t)*v++;
+    data->can_fac_status.limit_switch_1 = (uint8_t)*v++;
+    data->can_fac_status.limit_switch_2 = (uint8_t)*v++;
+    data->can_flc_status.status = (uint16_t)*v++;
+    data->can_flc_status.request = (uint8_t)*v++;
+    data->can_flc_status.temperature = (int16_t)*v++;
+    data->can_flc_data.temperature_1 = (int16_t)*v++;
+    data->can_flc_data.temperature_2 = (int16_t)*v++;
+    data->can_flc_data.temperature_3 = (int16_t)*v++;
+    data->can_flc_data.temperature_4 = (int16_t)*v++;
+    data->can_termo_status.status = (uint16_t)*v++;
+    data->can_termo_status.request = (uint8_t)*v++;
+    data->can_termo_data.pressure = (float)*v++;
+    data->can_termo_data.temperature = (float)*v++;
+    return true;
+}
+
+static bool load_csv(log_replay_session_t *session, const char *path, uint32_t period_ms) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "can not open %s\n", path);
+        return false;
+    }
+
+    char line[CSV_LINE_SIZE];
+    uint32_t timestamp_ms = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        tanwa_log_sample_t sample = {.timestamp_ms = timestamp_ms};
+        if (parse_csv_line(line, &sample.data) == false) {
+            session->skipped++;
+            continue;
+        }
+        push_sample(session, &sample);
+        timestamp_ms += period_ms;
+    }
+    fclose(file);
+    session->files++;
+    return true;
+}
+
+static bool load_file(log_replay_session_t *session, const char *path, uint32_t csv_period_ms) {
+    uint8_t *data = NULL;
+    size_t size = 0;
+    if (read_file(path, &data, &size) == false) {
+        return false;
+    }
+
+    bool ret;
+    if (size >= TANWA_LOG_MAGIC_SIZE && memcmp(data, TANWA_LOG_MAGIC, TANWA_LOG_MAGIC_SIZE) == 0) {
+        ret = load_binary(session, path, data, size);
+    } else {
+        ret = load_csv(session, path, csv_period_ms);
+    }
+    free(data);
+    return ret;
+}
+
+static bool load_session(log_replay_session_t *session, const char *directory) {
+    char path[PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s", directory, TANWA_LOG_INDEX_NAME);
+    uint8_t *index = NULL;
+    size_t size = 0;
+    if (read_file(path, &index, &size) == false) {
+        return false;
+    }
+    if (tanwa_log_check_index_header(index, size) == false) {
+        fprintf(stderr, "%s: wrong index header\n", path);
+        free(index);
+        return false;
+    }
+
+    bool ret = true;
+    for (size_t pos = TANWA_LOG_INDEX_HEADER_SIZE; pos + TANWA_LOG_INDEX_ENTRY_SIZE <= size && ret == true;
+         pos += TANWA_LOG_INDEX_ENTRY_SIZE) {
+        tanwa_log_index_entry_t entry;
+        if (tanwa_log_decode_index_entry(index + pos, &entry) == false || entry.record_count == 0) {
+            continue;
+        }
+        char name[16];
+        snprintf(name, sizeof(name), TANWA_LOG_SEGMENT_NAME, (unsigned)entry.segment);
+        snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+        uint8_t *data = NULL;
+        ret = read_file(path, &data, &size) && load_binary(session, path, data, size);
+        free(data);
+    }
+    free(index);
+    return ret;
+}
+
+bool log_replay_load(const char *path, uint32_t csv_period_ms, log_replay_session_t *session) {
+    memset(session, 0, sizeof(*session));
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        fprintf(stderr, "can not open %s\n", path);
+        return false;
+    }
+
+    bool ret = S_ISDIR(info.st_mode) ? load_session(session, path) : load_file(session, path, csv_period_ms);
+    if (ret == false || session->count == 0) {
+        log_replay_free(session);
+        return false;
+    }
+    return true;
+}
+
+void log_replay_free(log_replay_session_t *session) {
+    free(session->samples);
+    session->samples = NULL;
+    session->count = 0;
+    session->capacity = 0;
+}
+
+///===-----------------------------------------------------------------------------------------===//
+/// replay
+///===-----------------------------------------------------------------------------------------===//
+
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t deadline) {
+    struct timespec time = {
+        .tv_sec = (time_t)(deadline / 1000000000ULL),
+        .tv_nsec = (long)(deadline % 1000000000ULL),
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) != 0) {
+    }
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+void log_replay_apply(const tanwa_data_t *data) {
+    tanwa_data_t copy = *data;
+    tanwa_data_update_state(copy.state);
+    tanwa_data_update_com_data(&copy.com_data);
+    tanwa_data_update_can_connected_slaves(&copy.can_connected_slaves);
+    tanwa_data_update_can_hx_rocket_status(&copy.can_hx_rocket_status);
+    tanwa_data_update_can_hx_rocket_data(&copy.can_hx_rocket_data);
+    tanwa_data_update_can_hx_oxidizer_status(&copy.can_hx_oxidizer_status);
+    tanwa_data_update_can_hx_oxidizer_data(&copy.can_hx_oxidizer_data);
+    tanwa_data_update_can_fac_status(&copy.can_fac_status);
+    tanwa_data_update_can_flc_status(&copy.can_flc_status);
+    tanwa_data_update_can_flc_data(&copy.can_flc_data);
+    tanwa_data_update_can_flc_pressure_data(&copy.can_flc_pressure_data);
+    tanwa_data_update_can_termo_status(&copy.can_termo_status);
+    tanwa_data_update_can_termo_data(&copy.can_termo_data);
+    tanwa_data_update_now_main_valve_pressure_data(&copy.now_main_valve_pressure_data);
+    tanwa_data_update_now_main_valve_temperature_data(&copy.now_main_valve_temperature_data);
+}
+
+bool log_replay_run(const log_replay_session_t *session, float speed, log_replay_result_t *result) {
+    memset(result, 0, sizeof(*result));
+    if (session->count == 0 || tanwa_data_init() == false) {
+        return false;
+    }
+
+    uint64_t *sample_ns = malloc(session->count * sizeof(uint64_t));
+    if (sample_ns == NULL) {
+        return false;
+    }
+
+    uint8_t packed[512];
+    uint16_t digest = 0xFFFF;
+    uint64_t busy_ns = 0;
+    uint64_t update_ns = 0;
+    uint64_t serialize_now_ns = 0;
+    uint64_t serialize_lora_ns = 0;
+    uint32_t first_ms = session->samples[0].timestamp_ms;
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < session->count; ++i) {
+        const tanwa_log_sample_t *sample = &session->samples[i];
+        if (speed > 0.0f) {
+            sleep_until_ns(start + (uint64_t)((double)(sample->timestamp_ms - first_ms) * 1e6 / speed));
+        }
+
+        uint64_t t0 = now_ns();
+        log_replay_apply(&sample->data);
+
+        uint64_t t1 = now_ns();
+        tanwa_data_t data = tanwa_data_read();
+        DataToObc now_frame;
+        memset(&now_frame, 0, sizeof(now_frame));
+        telemetry_fill_now_frame(&data, &now_frame);
+
+        uint64_t t2 = now_ns();
+        data = tanwa_data_read();
+        LoRaFrame lora_frame;
+        telemetry_fill_lora_frame(&data, &lora_frame);
+        size_t lora_size = lo_ra_frame__get_packed_size(&lora_frame);
+        if (lora_size <= sizeof(packed)) {
+            lo_ra_frame__pack(&lora_frame, packed);
+        } else {
+            lora_size = 0;
+        }
+
+        uint64_t t3 = now_ns();
+        update_ns += t1 - t0;
+        serialize_now_ns += t2 - t1;
+        serialize_lora_ns += t3 - t2;
+        sample_ns[i] = t3 - t0;
+        busy_ns += t3 - t0;
+
+        digest = tanwa_log_crc16_update(digest, (const uint8_t*)&now_frame, sizeof(now_frame));
+        digest = tanwa_log_crc16_update(digest, packed, lora_size);
+        result->now_bytes += sizeof(now_frame);
+        result->lora_bytes += lora_size;
+        if (lora_size > result->lora_max_bytes) {
+            result->lora_max_bytes = (uint32_t)lora_size;
+        }
+
+        if (speed > 0.0f && i + 1 < session->count) {
+            uint32_t next_ms = session->samples[i + 1].timestamp_ms - first_ms;
+            if (t3 > start + (uint64_t)((double)next_ms * 1e6 / speed)) {
+                result->late++;
+            }
+        }
+    }
+
+    result->samples = (uint32_t)session->count;
+    result->session_s = (double)(session->samples[session->count - 1].timestamp_ms - first_ms) / 1000.0;
+    result->wall_s = (double)(now_ns() - start) / 1e9;
+    result->busy_s = (double)busy_ns / 1e9;
+    result->digest = digest;
+    result->update_us = (double)update_ns / 1000.0 / session->count;
+    result->now_us = (double)serialize_now_ns / 1000.0 / session->count;
+    result->lora_us = (double)serialize_lora_ns / 1000.0 / session->count;
+
+    qsort(sample_ns, session->count, sizeof(uint64_t), compare_u64);
+    result->sample_p50_us = (double)sample_ns[session->count / 2] / 1000.0;
+    result->sample_p99_us = (double)sample_ns[(session->count * 99) / 100] / 1000.0;
+    result->sample_max_us = (double)sample_ns[session->count - 1] / 1000.0;
+    free(sample_ns);
+    return true;
+}
+
+float log_replay_max_speed(const log_replay_result_t *result) {
+    if (result->busy_s <= 0.0) {
+        return 0.0f;
+    }
+    return (float)(result->session_s / result->busy_s);
+}
+
+float log_replay_max_speed_p99(const log_replay_result_t *result) {
+    if (result->samples < 2 || result->sample_p99_us <= 0.0) {
+        return 0.0f;
+    }
+    double period_us = result->session_s * 1e6 / (result->samples - 1);
+    return (float)(period_us / result->sample_p99_us);
+}
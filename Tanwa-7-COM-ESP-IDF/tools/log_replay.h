@@ -0,0 +1,96 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains declaration of the host side log replay. A recorded session (the session
+/// directory, one binary data file or the old CSV data file) is loaded to samples, which are then
+/// fed at the recorded pace or faster to the tanwa_data_update_x functions. After every sample the
+/// ESP-NOW and LoRa frames are filled from tanwa_data_read like the tasks do, and every stage is
+/// timed. Built for Linux with the FreeRTOS shim in tools/host.
+///===-----------------------------------------------------------------------------------------===//
+
+#ifndef PWRINSPACE_LOG_REPLAY_H_
+#define PWRINSPACE_LOG_REPLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tanwa_log_format.h"
+
+#define LOG_REPLAY_CSV_PERIOD_MS 50  // CSV lines have no timestamp, the SD timer period of that firmware
+#define LOG_REPLAY_CSV_FIELDS 44
+
+typedef struct {
+    tanwa_log_sample_t *samples;
+    size_t count;
+    size_t capacity;
+    uint32_t files;
+    uint32_t crc_errors;  // records with a wrong CRC or blocks that could not be decoded
+    uint32_t skipped;  // CSV lines that could not be parsed
+} log_replay_session_t;
+
+typedef struct {
+    uint32_t samples;
+    double session_s;  // recorded time from the first to the last sample
+    double wall_s;
+    double busy_s;  // time spent in the data path, without waiting for the next sample
+    uint32_t late;  // samples finished after the next one was due
+    // average time of one sample, the host is too fast for the latency_hist buckets
+    double update_us;  // all tanwa_data_update_x calls
+    double now_us;  // tanwa_data_read and the ESP-NOW frame
+    double lora_us;  // tanwa_data_read, the LoRa frame and its packing
+    double sample_p50_us;  // all of the above
+    double sample_p99_us;
+    double sample_max_us;
+    uint64_t now_bytes;
+    uint64_t lora_bytes;
+    uint32_t lora_max_bytes;
+    uint16_t digest;  // CRC16 of all serialized frames, compare between builds to catch output changes
+} log_replay_result_t;
+
+/**
+ * @brief Load the recorded samples
+ *
+ * @note The binary files have to use the built-in schema, the replay does not map the fields.
+ *
+ * @param path session directory with the index, binary data file or CSV data file
+ * @param csv_period_ms time between the CSV lines
+ * @param session pointer to the session, free it with log_replay_free
+ * @return true :)
+ * @return false :C
+ */
+bool log_replay_load(const char *path, uint32_t csv_period_ms, log_replay_session_t *session);
+
+void log_replay_free(log_replay_session_t *session);
+
+/**
+ * @brief Write the sample to the TANWA data with the update functions
+ */
+void log_replay_apply(const tanwa_data_t *data);
+
+/**
+ * @brief Replay the session through the data path
+ *
+ * @param speed 1 for the recorded pace, 10 for ten times faster, 0 as fast as possible
+ * @param result pointer to the result
+ * @return true :)
+ * @return false :C no samples or the TANWA data could not be initialized
+ */
+bool log_replay_run(const log_replay_session_t *session, float speed, log_replay_result_t *result);
+
+/**
+ * @brief Highest speed at which the average sample is processed before the next one is due
+ */
+float log_replay_max_speed(const log_replay_result_t *result);
+
+/**
+ * @brief Highest speed at which 99 % of the samples are processed before the next one is due
+ */
+float log_replay_max_speed_p99(const log_replay_result_t *result);
+
+#endif /* PWRINSPACE_LOG_REPLAY_H_ */
@@ -0,0 +1,176 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host benchmark of the SX127x FIFO access, the lora driver runs on a mocked radio that counts
+/// the SPI transactions and bytes. The packet is written and read back byte by byte and with the
+/// burst access, the time is modeled from the SPI clock and a fixed cost of one transaction
+/// (driver call, bus mutex and CS toggling, about 20 us on the ESP32 with the polling driver).
+///
+/// Build:
+///   gcc -std=gnu11 -O2 -Ihost -I../components/lora lora_spi_bench.c ../components/lora/lora.c -o lora_spi_bench
+/// Usage:
+///   lora_spi_bench [spi_clock_hz] [transaction_us]
+///===-----------------------------------------------------------------------------------------===//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lora.h"
+
+#define DEFAULT_CLOCK_HZ 400000  // _lora_add_device
+#define DEFAULT_TRANSACTION_US 20.0f
+
+static struct {
+    uint8_t regs[128];
+    uint8_t fifo[256];
+    uint32_t transactions;
+    uint64_t bytes;
+} radio;
+
+static void radio_write(uint8_t reg, uint8_t value) {
+    if (reg == REG_FIFO) {
+        radio.fifo[radio.regs[REG_FIFO_ADDR_PTR]++] = value;
+    } else if (reg == REG_IRQ_FLAGS) {
+        radio.regs[reg] &= (uint8_t)~value;
+    } else {
+        radio.regs[reg] = value;
+        if (reg == REG_OP_MODE && (value & 0x07) == MODE_TX) {
+            radio.regs[REG_IRQ_FLAGS] |= IRQ_TX_DONE_MASK;
+        }
+    }
+}
+
+static uint8_t radio_read(uint8_t reg) {
+    if (reg == REG_FIFO) {
+        return radio.fifo[radio.regs[REG_FIFO_ADDR_PTR]++];
+    }
+    return radio.regs[reg];
+}
+
+/**
+ * @brief One transaction, the address byte and the data, the FIFO pointer moves with every byte
+ */
+static void radio_transaction(uint8_t address, uint8_t *in, const uint8_t *out, size_t size) {
+    uint8_t reg = address & 0x7f;
+    for (size_t i = 0; i < size; ++i) {
+        if (address & 0x80) {
+            radio_write(reg, out != NULL ? out[i] : 0xff);
+        } else if (in != NULL) {
+            in[i] = radio_read(reg);
+        }
+    }
+    radio.transactions++;
+    radio.bytes += size + 1;
+}
+
+static bool mock_transmit(uint8_t _in[2], uint8_t _out[2]) {
+    radio_transaction(_out[0], &_in[1], &_out[1], 1);
+    return true;
+}
+
+static bool mock_transmit_burst(uint8_t _address, uint8_t *_in, const uint8_t *_out, size_t _size) {
+    radio_transaction(_address, _in, _out, _size);
+    return true;
+}
+
+static void mock_delay(uint32_t _ms) {
+    (void)_ms;
+}
+
+static bool mock_gpio_set_level(uint8_t _gpio_num, uint8_t _level) {
+    (void)_gpio_num;
+    (void)_level;
+    return true;
+}
+
+static void mock_log(const char *info) {
+    printf("lora: %s\n", info);
+}
+
+typedef struct {
+    uint32_t transactions;
+    uint64_t bytes;
+} spi_count_t;
+
+static spi_count_t count_since(const spi_count_t *start) {
+    spi_count_t count = {radio.transactions - start->transactions, radio.bytes - start->bytes};
+    return count;
+}
+
+static float model_us(const spi_count_t *count, uint32_t clock_hz, float transaction_us) {
+    return count->transactions * transaction_us + count->bytes * 8.0f * 1e6f / clock_hz;
+}
+
+/**
+ * @return false if the packet read back differs
+ */
+static bool run(lora_struct_t *lora, int16_t size, spi_count_t *tx, spi_count_t *rx) {
+    uint8_t packet[256];
+    uint8_t received[256];
+    for (int16_t i = 0; i < size; ++i) {
+        packet[i] = (uint8_t)rand();
+    }
+
+    spi_count_t start = {radio.transactions, radio.bytes};
+    lora_send_packet(lora, packet, size);
+    *tx = count_since(&start);
+
+    // the packet is received from the same FIFO
+    radio.regs[REG_IRQ_FLAGS] = IRQ_RX_DONE_MASK;
+    radio.regs[REG_RX_NB_BYTES] = (uint8_t)size;
+    radio.regs[REG_FIFO_RX_CURRENT_ADDR] = 0;
+    start = (spi_count_t){radio.transactions, radio.bytes};
+    int16_t length = lora_receive_packet(lora, received, sizeof(received));
+    *rx = count_since(&start);
+    return length == size && memcmp(packet, received, size) == 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t clock_hz = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_CLOCK_HZ;
+    float transaction_us = argc >= 3 ? strtof(argv[2], NULL) : DEFAULT_TRANSACTION_US;
+    if (clock_hz == 0) {
+        fprintf(stderr, "usage: %s [spi_clock_hz] [transaction_us]\n", argv[0]);
+        return 1;
+    }
+
+    radio.regs[REG_VERSION] = 0x12;
+    lora_struct_t lora = {
+        ._spi_transmit = mock_transmit,
+        ._spi_transmit_burst = NULL,
+        ._delay = mock_delay,
+        ._gpio_set_level = mock_gpio_set_level,
+        .log = mock_log,
+    };
+    lora_init(&lora);
+
+    printf("SPI %u Hz, %.1f us per transaction\n", clock_hz, transaction_us);
+    printf("%5s | %-37s | %-37s | %s\n", "size", "tx byte / burst (trans, B, us)",
+           "rx byte / burst (trans, B, us)", "speedup tx/rx");
+    static const int16_t sizes[] = {20, 40, 77, 128, 255};
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        spi_count_t tx_byte, rx_byte, tx_burst, rx_burst;
+        lora._spi_transmit_burst = NULL;
+        ok &= run(&lora, sizes[i], &tx_byte, &rx_byte);
+        lora._spi_transmit_burst = mock_transmit_burst;
+        ok &= run(&lora, sizes[i], &tx_burst, &rx_burst);
+
+        float tx_byte_us = model_us(&tx_byte, clock_hz, transaction_us);
+        float tx_burst_us = model_us(&tx_burst, clock_hz, transaction_us);
+        float rx_byte_us = model_us(&rx_byte, clock_hz, transaction_us);
+        float rx_burst_us = model_us(&rx_burst, clock_hz, transaction_us);
+        printf("%5d | %3u %3llu %6.0f / %3u %3llu %6.0f | %3u %3llu %6.0f / %3u %3llu %6.0f | x%.1f / x%.1f\n",
+               sizes[i], tx_byte.transactions, (unsigned long long)tx_byte.bytes, tx_byte_us, tx_burst.transactions,
+               (unsigned long long)tx_burst.bytes, tx_burst_us, rx_byte.transactions,
+               (unsigned long long)rx_byte.bytes, rx_byte_us, rx_burst.transactions,
+               (unsigned long long)rx_burst.bytes, rx_burst_us, tx_byte_us / tx_burst_us, rx_byte_us / rx_burst_us);
+    }
+    printf("read back %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
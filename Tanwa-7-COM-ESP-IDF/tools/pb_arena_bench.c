@@ -0,0 +1,212 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host test of the protobuf-c arena allocator used by the LoRa task. LoRaCommand packets are
+/// decoded with the default allocator and with the arena reset per packet, then LoRaFrame is
+/// packed like the telemetry packet. malloc and free are wrapped by the linker to count every heap
+/// call, the arena and the packing have to make none. Fails if they do or if the decoded commands
+/// differ.
+///
+/// Build (protobuf-c runtime from ESP-IDF):
+///   gcc -std=gnu11 -O2 -Ihost -I../components/proto -I../components/data -I../components/app
+///       -I../components/esp_now -I$IDF_PATH/components/protobuf-c/protobuf-c
+///       pb_arena_bench.c ../components/proto/pb_arena.c ../components/proto/lora.pb-c.c
+///       ../components/app/telemetry_frames.c $IDF_PATH/components/protobuf-c/protobuf-c/protobuf-c/protobuf-c.c
+///       -Wl,--wrap=malloc -Wl,--wrap=free -o pb_arena_bench
+/// Usage:
+///   pb_arena_bench [packets]
+///===-----------------------------------------------------------------------------------------===//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lora.pb-c.h"
+#include "pb_arena.h"
+#include "telemetry_frames.h"
+
+#define DEFAULT_PACKETS 100000
+#define COMMAND_MAX_SIZE 32
+#define ARENA_SIZE 256  // LORA_TASK_ARENA_SIZE
+
+void *__real_malloc(size_t size);
+void __real_free(void *pointer);
+
+static struct {
+    uint64_t mallocs;
+    uint64_t frees;
+    uint64_t bytes;
+} heap;
+
+void *__wrap_malloc(size_t size) {
+    heap.mallocs++;
+    heap.bytes += size;
+    return __real_malloc(size);
+}
+
+void __wrap_free(void *pointer) {
+    if (pointer != NULL) {
+        heap.frees++;
+    }
+    __real_free(pointer);
+}
+
+typedef struct {
+    uint8_t data[COMMAND_MAX_SIZE];
+    size_t size;
+    LoRaCommand command;
+} packet_t;
+
+typedef struct {
+    uint64_t mallocs;
+    uint64_t frees;
+    uint64_t bytes;
+    double p50_ns;
+    double p99_ns;
+    double max_ns;
+} run_result_t;
+
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void finish_run(run_result_t *result, uint64_t *times, size_t count) {
+    result->mallocs = heap.mallocs;
+    result->frees = heap.frees;
+    result->bytes = heap.bytes;
+    qsort(times, count, sizeof(uint64_t), compare_u64);
+    result->p50_ns = (double)times[count / 2];
+    result->p99_ns = (double)times[(count * 99) / 100];
+    result->max_ns = (double)times[count - 1];
+}
+
+static bool same_command(const LoRaCommand *a, const LoRaCommand *b) {
+    return a->lora_dev_id == b->lora_dev_id && a->sys_dev_id == b->sys_dev_id && a->command == b->command &&
+           a->payload == b->payload;
+}
+
+/**
+ * @param arena NULL for the default allocator
+ * @return number of wrongly decoded packets
+ */
+static size_t decode_all(const packet_t *packets, size_t count, pb_arena_t *arena, uint64_t *times,
+                         run_result_t *result) {
+    size_t errors = 0;
+    ProtobufCAllocator *allocator = arena != NULL ? &arena->allocator : NULL;
+    memset(&heap, 0, sizeof(heap));
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t start = now_ns();
+        if (arena != NULL) {
+            pb_arena_reset(arena);
+        }
+        LoRaCommand *received = lo_ra_command__unpack(allocator, packets[i].size, packets[i].data);
+        bool ok = received != NULL && same_command(received, &packets[i].command);
+        if (received != NULL) {
+            lo_ra_command__free_unpacked(received, allocator);
+        }
+        times[i] = now_ns() - start;
+        errors += ok ? 0 : 1;
+    }
+    finish_run(result, times, count);
+    return errors;
+}
+
+static void pack_frames(size_t count, uint64_t *times, run_result_t *result, size_t *frame_size) {
+    tanwa_data_t data;
+    memset(&data, 0, sizeof(data));
+    data.state = 3;
+    data.com_data.vbat = 12.4f;
+    data.com_data.pressure_3 = 42.5f;
+    data.can_hx_rocket_data.weight = 18.2f;
+    data.can_hx_oxidizer_data.weight = 7.9f;
+
+    uint8_t buffer[256];
+    memset(&heap, 0, sizeof(heap));
+    for (size_t i = 0; i < count; ++i) {
+        data.can_hx_rocket_data.weight_raw = (uint32_t)i;
+        uint64_t start = now_ns();
+        LoRaFrame frame;
+        telemetry_fill_lora_frame(&data, &frame);
+        *frame_size = lo_ra_frame__get_packed_size(&frame);
+        lo_ra_frame__pack(&frame, buffer);
+        times[i] = now_ns() - start;
+    }
+    finish_run(result, times, count);
+}
+
+static void print_run(const char *name, const run_result_t *result, size_t count) {
+    printf("%-16s heap %llu malloc / %llu free (%.2f per packet, %llu B), p50 %.0f ns, p99 %.0f ns, max %.0f ns\n",
+           name, (unsigned long long)result->mallocs, (unsigned long long)result->frees,
+           (double)result->mallocs / count, (unsigned long long)result->bytes, result->p50_ns, result->p99_ns,
+           result->max_ns);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_PACKETS;
+    if (count == 0) {
+        fprintf(stderr, "usage: %s [packets]\n", argv[0]);
+        return 1;
+    }
+
+    packet_t *packets = malloc(count * sizeof(packet_t));
+    uint64_t *times = malloc(count * sizeof(uint64_t));
+    if (packets == NULL || times == NULL) {
+        return 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        lo_ra_command__init(&packets[i].command);
+        packets[i].command.lora_dev_id = rand() % 8;
+        packets[i].command.sys_dev_id = rand() % 16;
+        packets[i].command.command = rand() % 256;
+        packets[i].command.payload = rand() - RAND_MAX / 2;
+        packets[i].size = lo_ra_command__pack(&packets[i].command, packets[i].data);
+    }
+
+    static uint8_t arena_buffer[ARENA_SIZE] __attribute__((aligned(PB_ARENA_ALIGN)));
+    pb_arena_t arena;
+    pb_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+
+    run_result_t system_run, arena_run, pack_run;
+    size_t system_errors = decode_all(packets, count, NULL, times, &system_run);
+    size_t arena_errors = decode_all(packets, count, &arena, times, &arena_run);
+    size_t frame_size = 0;
+    pack_frames(count, times, &pack_run, &frame_size);
+
+    // too small arena, the unpack has to fail cleanly without the heap
+    static uint8_t small_buffer[8] __attribute__((aligned(PB_ARENA_ALIGN)));
+    pb_arena_t small;
+    pb_arena_init(&small, small_buffer, sizeof(small_buffer));
+    memset(&heap, 0, sizeof(heap));
+    LoRaCommand *overflow = lo_ra_command__unpack(&small.allocator, packets[0].size, packets[0].data);
+    bool overflow_ok = overflow == NULL && small.failures == 1 && heap.mallocs == 0;
+
+    printf("%zu LoRaCommand packets, arena %u B, max used %zu B, %u failed allocations\n", count, ARENA_SIZE,
+           arena.max_used, arena.failures);
+    print_run("unpack system", &system_run, count);
+    print_run("unpack arena", &arena_run, count);
+    print_run("pack LoRaFrame", &pack_run, count);
+    printf("LoRaFrame %zu B, decode errors system %zu, arena %zu, overflow %s\n", frame_size, system_errors,
+           arena_errors, overflow_ok ? "ok" : "FAILED");
+
+    bool ok = system_errors == 0 && arena_errors == 0 && arena_run.mallocs == 0 && pack_run.mallocs == 0 &&
+              overflow_ok;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    free(packets);
+    free(times);
+    return ok ? 0 : 1;
+}
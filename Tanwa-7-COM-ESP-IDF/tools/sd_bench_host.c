@@ -0,0 +1,61 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host build of the SD card benchmark, the same code as the sd-bench console command. Run it on a
+/// FAT image mounted through a loop device to compare SD write path changes offline, for example:
+///   dd if=/dev/zero of=fat.img bs=1M count=256 && mkfs.vfat -F 32 -s 64 fat.img
+///   sudo mount -o loop,sync fat.img /mnt/fat
+///
+/// Build:
+///   gcc -std=gnu11 -O2 -I../components/sd_card sd_bench_host.c ../components/sd_card/sd_bench.c ../components/sd_card/latency_hist.c -o sd_bench_host
+/// Usage:
+///   sd_bench_host <directory> [file_kb]
+///===-----------------------------------------------------------------------------------------===//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sd_bench.h"
+
+static void print_latency(const char *name, const latency_hist_t *hist) {
+    printf("%-10s n %u, avg %.0f us, p50 < %u us, p90 < %u us, p99 < %u us, p99.9 < %u us, max %u us\n", name,
+           hist->count, latency_hist_average(hist), latency_hist_percentile(hist, 50.0f),
+           latency_hist_percentile(hist, 90.0f), latency_hist_percentile(hist, 99.0f),
+           latency_hist_percentile(hist, 99.9f), hist->max_us);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <directory> [file_kb]\n", argv[0]);
+        return 1;
+    }
+
+    sd_bench_cfg_t cfg;
+    sd_bench_default_config(&cfg, argv[1]);
+    if (argc >= 3) {
+        cfg.file_size = (size_t)atoi(argv[2]) * 1024;
+    }
+
+    static sd_bench_result_t result;
+    if (!sd_bench_run(&cfg, &result)) {
+        fprintf(stderr, "benchmark failed in %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%u kB per pass\n", (unsigned)(cfg.file_size / 1024));
+    for (uint8_t i = 0; i < result.write_count; ++i) {
+        const sd_bench_write_t *write = &result.write[i];
+        printf("%5u B: sequential %.1f kB/s, p99 < %u us, max %u us; random %.1f kB/s, p99 < %u us, max %u us\n",
+               (unsigned)write->buffer_size, write->sequential_kbps, latency_hist_percentile(&write->sequential, 99.0f),
+               write->sequential.max_us, write->random_kbps, latency_hist_percentile(&write->random, 99.0f),
+               write->random.max_us);
+    }
+    print_latency("open+close", &result.open_close);
+    print_latency("sync", &result.sync);
+    return 0;
+}
@@ -0,0 +1,273 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host measurement of the SD task boot cost on a card with many sessions. A tree like the one
+/// the SD task leaves on the card is generated (session directories with an index and a segment,
+/// log files, all in the root), then the boot file system work is replayed:
+///   before - every session directory walked for the recovery, session and log numbers probed
+///            with stat from 0 until a free one is found
+///   after  - only the session left open (kept in NVS) recovered, one directory scan of
+///            SD_find_free_number for the session and one for the log number
+/// The host time is measured on the real calls. FATFS finds a name by reading the directory
+/// linearly from its first sector and caches only one sector, so the card time is modeled from
+/// the root directory entries read by every lookup (32 B each, no LFN entries for these names).
+///
+/// Build:
+///   gcc -std=gnu11 -O2 -I../components/sd_card sd_boot_bench.c ../components/sd_card/sd_path.c
+///       -o sd_boot_bench
+/// Usage:
+///   sd_boot_bench <empty directory> [sessions] [us per sector read]
+///===-----------------------------------------------------------------------------------------===//
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "sd_path.h"
+
+#define DEFAULT_SESSIONS 999  // every number but the last one used
+#define DEFAULT_SECTOR_US 250  // single block read over SPI at 20 MHz with the command overhead
+#define DIR_ENTRY_SIZE 32
+#define SECTOR_SIZE 512
+#define PATH_SIZE 256
+
+#define SESSION_PREFIX "data"  // sd_task_cfg_t data_path and log_path of the SD task
+#define LOG_PREFIX "log"
+#define LOG_EXTENSION ".txt"
+#define HWM_EXTENSION ".hwm"
+#define INDEX_NAME "index.bin"
+#define SEGMENT_NAME "seg0000.bin"
+#define INDEX_SIZE 64  // header and one entry
+
+typedef struct {
+    const char *root;
+    int sessions;  // session i is the root entry 2 * i + 2, log i the next one, after "." and ".."
+    uint64_t lookups;
+    uint64_t entries_read;
+    uint64_t opened;
+    double host_us;
+} boot_run_t;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief Root directory entries FATFS reads to find the name, a missing name reads all of them
+ */
+static uint64_t root_lookup_cost(const boot_run_t *run, const char *name) {
+    uint64_t entries = 2 + 2 * (uint64_t)run->sessions;
+    char *end;
+    long number;
+    if (strncasecmp(name, SESSION_PREFIX, strlen(SESSION_PREFIX)) == 0) {
+        number = strtol(name + strlen(SESSION_PREFIX), &end, 10);
+        if (*end == '\0' && number < run->sessions) {
+            return 2 * number + 3;
+        }
+    } else if (strncasecmp(name, LOG_PREFIX, strlen(LOG_PREFIX)) == 0) {
+        number = strtol(name + strlen(LOG_PREFIX), &end, 10);
+        if (strcasecmp(end, LOG_EXTENSION) == 0 && number < run->sessions) {
+            return 2 * number + 4;
+        }
+    }
+    return entries;
+}
+
+static void count_lookup(boot_run_t *run, const char *name) {
+    run->lookups++;
+    run->entries_read += root_lookup_cost(run, name);
+}
+
+static void count_root_scan(boot_run_t *run) {
+    run->entries_read += 2 + 2 * (uint64_t)run->sessions;
+}
+
+static bool create_tree(const char *root, int sessions) {
+    char path[PATH_SIZE];
+    uint8_t index[INDEX_SIZE] = {0};
+    for (int i = 0; i < sessions; ++i) {
+        snprintf(path, sizeof(path), "%s/" SESSION_PREFIX "%d", root, i);
+        if (mkdir(path, 0775) != 0) {
+            return false;
+        }
+        snprintf(path, sizeof(path), "%s/" SESSION_PREFIX "%d/" INDEX_NAME, root, i);
+        FILE *file = fopen(path, "w");
+        if (file == NULL) {
+            return false;
+        }
+        fwrite(index, 1, sizeof(index), file);
+        fclose(file);
+        snprintf(path, sizeof(path), "%s/" SESSION_PREFIX "%d/" SEGMENT_NAME, root, i);
+        file = fopen(path, "w");
+        if (file == NULL) {
+            return false;
+        }
+        fclose(file);
+        snprintf(path, sizeof(path), "%s/" LOG_PREFIX "%d" LOG_EXTENSION, root, i);
+        file = fopen(path, "w");
+        if (file == NULL) {
+            return false;
+        }
+        fclose(file);
+    }
+    return true;
+}
+
+/**
+ * @brief recover_files of one session directory, the high water mark files are looked for
+ */
+static void recover_session_files(boot_run_t *run, const char *session) {
+    char path[PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s", run->root, session);
+    count_lookup(run, session);
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        char *extension = strrchr(entry->d_name, '.');
+        if (entry->d_type != DT_DIR && extension != NULL && strcasecmp(extension, HWM_EXTENSION) == 0) {
+            run->opened++;
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief recover_session, the last index entry is read to check the closed flag
+ */
+static void recover_session_index(boot_run_t *run, const char *session) {
+    char path[PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s/" INDEX_NAME, run->root, session);
+    count_lookup(run, session);
+    FILE *file = fopen(path, "r+");
+    if (file == NULL) {
+        return;
+    }
+    run->opened++;
+    uint8_t entry[INDEX_SIZE / 2];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, size - (long)sizeof(entry), SEEK_SET);
+    if (fread(entry, 1, sizeof(entry), file) != sizeof(entry)) {
+        run->opened--;
+    }
+    fclose(file);
+}
+
+static bool name_exists(boot_run_t *run, const char *name) {
+    char path[PATH_SIZE];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", run->root, name);
+    count_lookup(run, name);
+    return stat(path, &st) == 0;
+}
+
+static int probe_free_number(boot_run_t *run, const char *prefix, const char *extension) {
+    char name[PATH_SIZE];
+    for (int i = 0; i < SD_FREE_NUMBER_MAX; ++i) {
+        snprintf(name, sizeof(name), "%s%d%s", prefix, i, extension);
+        if (name_exists(run, name) == false) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void boot_before(boot_run_t *run, int *session, int *log) {
+    double start = now_us();
+    DIR *dir = opendir(run->root);
+    if (dir != NULL) {
+        count_root_scan(run);
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+                recover_session_files(run, entry->d_name);
+                recover_session_index(run, entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    *session = probe_free_number(run, SESSION_PREFIX, "");
+    *log = probe_free_number(run, LOG_PREFIX, LOG_EXTENSION);
+    run->host_us = now_us() - start;
+}
+
+/**
+ * @param open_session the last session is marked as open in NVS, otherwise nothing is recovered
+ */
+static void boot_after(boot_run_t *run, bool open_session, int *session, int *log) {
+    char name[PATH_SIZE];
+    double start = now_us();
+    if (open_session == true) {
+        snprintf(name, sizeof(name), SESSION_PREFIX "%d", run->sessions - 1);
+        recover_session_files(run, name);
+        recover_session_index(run, name);
+    }
+
+    count_root_scan(run);
+    *session = SD_find_free_number(run->root, SESSION_PREFIX, "", 0, SD_FREE_NUMBER_MAX);
+    count_root_scan(run);
+    *log = SD_find_free_number(run->root, LOG_PREFIX, LOG_EXTENSION, 0, SD_FREE_NUMBER_MAX);
+    run->host_us = now_us() - start;
+}
+
+static void print_run(const char *name, const boot_run_t *run, int session, int log, double sector_us) {
+    double sectors = (double)run->entries_read * DIR_ENTRY_SIZE / SECTOR_SIZE;
+    printf("%-22s host %9.0f us, %5llu lookups, %4llu files opened, %9llu dir entries = %7.0f sectors, "
+           "card ~%8.1f ms, next %s%d %s%d%s\n",
+           name, run->host_us, (unsigned long long)run->lookups, (unsigned long long)run->opened,
+           (unsigned long long)run->entries_read, sectors, sectors * sector_us / 1000.0, SESSION_PREFIX, session,
+           LOG_PREFIX, log, LOG_EXTENSION);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <empty directory> [sessions] [us per sector read]\n", argv[0]);
+        return 1;
+    }
+    int sessions = argc >= 3 ? atoi(argv[2]) : DEFAULT_SESSIONS;
+    double sector_us = argc >= 4 ? atof(argv[3]) : DEFAULT_SECTOR_US;
+    if (sessions <= 0 || sessions >= SD_FREE_NUMBER_MAX) {
+        fprintf(stderr, "sessions has to be 1..%d\n", SD_FREE_NUMBER_MAX - 1);
+        return 1;
+    }
+    if (create_tree(argv[1], sessions) == false) {
+        fprintf(stderr, "unable to create the sessions in %s, it has to be empty\n", argv[1]);
+        return 1;
+    }
+
+    printf("%d sessions and %d log files in %s, card time at %.0f us per directory sector\n", sessions, sessions,
+           argv[1], sector_us);
+    boot_run_t before = {.root = argv[1], .sessions = sessions};
+    boot_run_t after = {.root = argv[1], .sessions = sessions};
+    boot_run_t after_no_nvs = {.root = argv[1], .sessions = sessions};
+    int session[3], log[3];
+    boot_before(&before, &session[0], &log[0]);
+    boot_after(&after, true, &session[1], &log[1]);
+    boot_after(&after_no_nvs, false, &session[2], &log[2]);
+    print_run("before", &before, session[0], log[0], sector_us);
+    print_run("after", &after, session[1], log[1], sector_us);
+    print_run("after, NVS erased", &after_no_nvs, session[2], log[2], sector_us);
+
+    bool ok = true;
+    for (int i = 0; i < 3; ++i) {
+        ok = ok && session[i] == sessions && log[i] == sessions;
+    }
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,507 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host side decoder of the binary TANWA data log. Converts the records to CSV with one typed
+/// column per schema field, ready to be loaded to pandas/Parquet.
+///
+/// Build:
+///   g++ -std=c++17 -O2 -I../components/data tanwa_log_decode.cpp ../components/data/tanwa_log_format.c ../components/data/record_codec.c ../components/data/record_summary.c -o tanwa_log_decode
+/// Usage:
+///   tanwa_log_decode <data.bin|session> [out.csv]   decode records to CSV (stdout by default)
+///   tanwa_log_decode --schema <data.bin|session>    print the column names and types
+///   tanwa_log_decode --from <ms> --to <ms> <data.bin|session> [out.csv]
+///   tanwa_log_decode --scan <data.bin|session>      check the frames, same scan as the boot recovery
+///   tanwa_log_decode --accounting <data.bin|session> [out.csv]   sample accounting of the backpressure frames
+///   tanwa_log_decode --summary <data.bin|session> [out.csv]   min/max/mean per interval of the two-tier logging
+///
+/// A session directory is decoded segment by segment. With --from/--to only the segments of the
+/// time window are read, found by binary search in the session index, and the first record in a
+/// segment is found by binary search over the fixed-size records. The records are taken from
+/// the frames first (decompressed if needed), a torn or damaged frame is skipped up to the next
+/// valid one. The circular recent.bin of the two-tier logging is read block by block in the
+/// order of the block sequence, the stale blocks of an older ring are skipped.
+///===-----------------------------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "record_codec.h"
+#include "record_summary.h"
+#include "tanwa_log_format.h"
+
+static const char* type_name(uint8_t type) {
+    switch (type) {
+        case TANWA_LOG_TYPE_U8: return "uint8";
+        case TANWA_LOG_TYPE_U16: return "uint16";
+        case TANWA_LOG_TYPE_I16: return "int16";
+        case TANWA_LOG_TYPE_U32: return "uint32";
+        case TANWA_LOG_TYPE_F32: return "float32";
+        case TANWA_LOG_TYPE_FLAG: return "bool";
+        default: return "unknown";
+    }
+}
+
+static bool read_file(const char* path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static void write_value(FILE* out, uint8_t type, const tanwa_log_value_t& value) {
+    switch (type) {
+        case TANWA_LOG_TYPE_I16:
+            fprintf(out, "%d", (int)value.i);
+            break;
+        case TANWA_LOG_TYPE_F32:
+            fprintf(out, "%.9g", value.f);
+            break;
+        default:
+            fprintf(out, "%u", (unsigned)value.u);
+            break;
+    }
+}
+
+struct decode_result_t {
+    size_t records = 0;
+    size_t crc_errors = 0;
+    size_t trailing_bytes = 0;
+    size_t bad_blocks = 0;
+    size_t sequence_gaps = 0;
+    size_t skipped_bytes = 0;
+    std::vector<tanwa_log_backpressure_t> accounting;
+    std::vector<record_summary_values_t> summaries;
+};
+
+struct frame_context_t {
+    const tanwa_log_schema_t* schema;
+    std::vector<uint8_t>* records;
+    decode_result_t* result;
+};
+
+static uint32_t record_timestamp(const uint8_t* record) {
+    // timestamp_ms is the first field of every record
+    return record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+}
+
+static void on_frame(void* context, const tanwa_log_frame_t* frame, size_t offset) {
+    frame_context_t* ctx = static_cast<frame_context_t*>(context);
+    uint16_t record_size = ctx->schema->record_size;
+    if (frame->type == TANWA_LOG_FRAME_RECORD && frame->length == record_size) {
+        ctx->records->insert(ctx->records->end(), frame->payload, frame->payload + frame->length);
+        return;
+    }
+
+    if (frame->type == TANWA_LOG_FRAME_BACKPRESSURE) {
+        tanwa_log_backpressure_t backpressure;
+        if (tanwa_log_decode_backpressure(frame->payload, frame->length, &backpressure)) {
+            ctx->result->accounting.push_back(backpressure);
+            return;
+        }
+    }
+
+    if (frame->type == TANWA_LOG_FRAME_SUMMARY) {
+        record_summary_values_t summary;
+        if (record_summary_decode(frame->payload, frame->length, &summary) &&
+            summary.field_count == ctx->schema->field_count) {
+            ctx->result->summaries.push_back(summary);
+            return;
+        }
+    }
+
+    if (frame->type == TANWA_LOG_FRAME_BLOCK) {
+        static uint8_t block_records[RECORD_CODEC_BLOCK_SIZE * RECORD_CODEC_MAX_RECORD_SIZE];
+        size_t block_size = 0;
+        size_t count = record_codec_decode_block(frame->payload, frame->length, block_records, sizeof(block_records),
+                                                 &block_size, &record_size);
+        if (count > 0 && record_size == ctx->schema->record_size) {
+            ctx->records->insert(ctx->records->end(), block_records, block_records + count * record_size);
+            return;
+        }
+    }
+
+    std::cerr << "unexpected frame " << frame->sequence << " at " << offset << std::endl;
+    ctx->result->bad_blocks++;
+}
+
+/**
+ * @brief Get the records of the segment, decompressed if needed
+ */
+static void load_records(const tanwa_log_schema_t& schema, const std::vector<uint8_t>& data,
+                         std::vector<uint8_t>& records, decode_result_t& result) {
+    if (schema.version >= 3) {
+        records.clear();
+        frame_context_t context = {&schema, &records, &result};
+        tanwa_log_scanner_t scanner;
+        tanwa_log_scanner_init(&scanner, schema.header_size, on_frame, &context);
+        tanwa_log_scanner_feed(&scanner, data.data() + schema.header_size, data.size() - schema.header_size, true);
+        result.sequence_gaps += scanner.sequence_gaps;
+        result.skipped_bytes += scanner.skipped_bytes;
+        return;
+    }
+
+    // version 2 and older, no frames
+    if ((schema.flags & TANWA_LOG_FLAG_COMPRESSED) == 0) {
+        records.assign(data.begin() + schema.header_size, data.end());
+        return;
+    }
+
+    records.clear();
+    std::vector<uint8_t> block_records(RECORD_CODEC_BLOCK_SIZE * RECORD_CODEC_MAX_RECORD_SIZE);
+    size_t pos = schema.header_size;
+    bool in_sync = true;
+    while (pos < data.size()) {
+        size_t block_size = 0;
+        uint16_t record_size = 0;
+        size_t count = record_codec_decode_block(data.data() + pos, data.size() - pos, block_records.data(),
+                                                 block_records.size(), &block_size, &record_size);
+        if (count == 0 || record_size != schema.record_size) {
+            // look for the next block marker
+            if (in_sync) {
+                result.bad_blocks++;
+                in_sync = false;
+            }
+            pos++;
+            continue;
+        }
+        in_sync = true;
+        records.insert(records.end(), block_records.begin(), block_records.begin() + count * record_size);
+        pos += block_size;
+    }
+}
+
+/**
+ * @brief Replace the circular file by its header and the frames of its blocks, oldest first
+ *
+ * @return false if the data is not a circular file, it is left as it is
+ */
+static bool linearize_ring(std::vector<uint8_t>& data, const tanwa_log_schema_t& schema) {
+    tanwa_log_ring_block_t descriptor;
+    size_t descriptor_pos = TANWA_LOG_RING_BLOCK_SIZE - TANWA_LOG_RING_BLOCK_HEADER_SIZE;
+    if (data.size() < TANWA_LOG_RING_BLOCK_SIZE || !tanwa_log_decode_ring_block(data.data() + descriptor_pos, &descriptor) ||
+        descriptor.used != 0) {
+        return false;
+    }
+
+    std::vector<tanwa_log_ring_block_t> blocks;
+    std::vector<size_t> positions;
+    for (size_t pos = TANWA_LOG_RING_BLOCK_SIZE; pos + TANWA_LOG_RING_BLOCK_SIZE <= data.size();
+         pos += TANWA_LOG_RING_BLOCK_SIZE) {
+        tanwa_log_ring_block_t block;
+        if (tanwa_log_decode_ring_block(data.data() + pos, &block) && block.ring_id == descriptor.ring_id &&
+            block.used >= TANWA_LOG_RING_BLOCK_HEADER_SIZE) {
+            blocks.push_back(block);
+            positions.push_back(pos);
+        }
+    }
+
+    std::vector<size_t> order(blocks.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return blocks[a].sequence < blocks[b].sequence; });
+
+    std::vector<uint8_t> linear(data.begin(), data.begin() + schema.header_size);
+    for (size_t i : order) {
+        const uint8_t* frames = data.data() + positions[i] + TANWA_LOG_RING_BLOCK_HEADER_SIZE;
+        linear.insert(linear.end(), frames, frames + blocks[i].used - TANWA_LOG_RING_BLOCK_HEADER_SIZE);
+    }
+    if (!order.empty()) {
+        std::cerr << "recent ring of " << descriptor.sequence << " blocks, blocks " << blocks[order.front()].sequence
+                  << "-" << blocks[order.back()].sequence << " present" << std::endl;
+    }
+    data.swap(linear);
+    return true;
+}
+
+static size_t find_first_record(const tanwa_log_schema_t& schema, const std::vector<uint8_t>& records,
+                                uint32_t from_ms) {
+    size_t low = 0;
+    size_t high = records.size() / schema.record_size;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (record_timestamp(records.data() + mid * schema.record_size) < from_ms) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low * schema.record_size;
+}
+
+static void write_columns(FILE* out, const tanwa_log_schema_t& schema) {
+    for (uint8_t i = 0; i < schema.field_count; ++i) {
+        fprintf(out, "%s%s", i ? "," : "", schema.fields[i].name);
+    }
+    fprintf(out, "\n");
+}
+
+static void decode_records(FILE* out, const tanwa_log_schema_t& schema, const std::vector<uint8_t>& segment,
+                           uint32_t from_ms, uint32_t to_ms, decode_result_t& result) {
+    std::vector<uint8_t> data;
+    load_records(schema, segment, data, result);
+    std::vector<tanwa_log_value_t> values(schema.field_count);
+    size_t pos = find_first_record(schema, data, from_ms);
+    while (pos + schema.record_size <= data.size()) {
+        const uint8_t* record = data.data() + pos;
+        pos += schema.record_size;
+        if (!tanwa_log_decode_record(&schema, record, values.data())) {
+            result.crc_errors++;
+            continue;
+        }
+        if (record_timestamp(record) > to_ms) {
+            return;
+        }
+        for (uint8_t i = 0; i < schema.field_count; ++i) {
+            if (i) {
+                fputc(',', out);
+            }
+            write_value(out, schema.fields[i].type, values[i]);
+        }
+        fputc('\n', out);
+        result.records++;
+    }
+    result.trailing_bytes += data.size() - pos;
+}
+
+static bool read_index(const std::filesystem::path& session, std::vector<tanwa_log_index_entry_t>& entries) {
+    std::vector<uint8_t> data;
+    if (!read_file((session / TANWA_LOG_INDEX_NAME).string().c_str(), data) ||
+        !tanwa_log_check_index_header(data.data(), data.size())) {
+        return false;
+    }
+
+    for (size_t pos = TANWA_LOG_INDEX_HEADER_SIZE; pos + TANWA_LOG_INDEX_ENTRY_SIZE <= data.size();
+         pos += TANWA_LOG_INDEX_ENTRY_SIZE) {
+        tanwa_log_index_entry_t entry;
+        // an entry of the segment written during a reset may be missing, skip it
+        if (tanwa_log_decode_index_entry(data.data() + pos, &entry) && entry.record_count > 0) {
+            entries.push_back(entry);
+        }
+    }
+    return true;
+}
+
+static std::string segment_path(const std::filesystem::path& session, uint32_t segment) {
+    char name[16];
+    snprintf(name, sizeof(name), TANWA_LOG_SEGMENT_NAME, (unsigned)segment);
+    return (session / name).string();
+}
+
+/**
+ * @brief Report the frames of every segment, the garbage after the last frame would be truncated
+ */
+static int scan_segments(const std::vector<std::string>& segments) {
+    int ret = 0;
+    std::vector<uint8_t> data;
+    static tanwa_log_schema_t schema;
+    for (const std::string& segment : segments) {
+        if (!read_file(segment.c_str(), data) || !tanwa_log_parse_header(data.data(), data.size(), &schema) ||
+            schema.version < 3) {
+            std::cerr << segment << ": unreadable or not framed" << std::endl;
+            ret = 1;
+            continue;
+        }
+        linearize_ring(data, schema);
+
+        tanwa_log_scanner_t scanner;
+        tanwa_log_scanner_init(&scanner, schema.header_size, nullptr, nullptr);
+        tanwa_log_scanner_feed(&scanner, data.data() + schema.header_size, data.size() - schema.header_size, true);
+        size_t valid_end = scanner.frames > 0 ? scanner.valid_end : schema.header_size;
+        std::cout << segment << ": frames " << scanner.frames << ", sequence " << scanner.first_sequence << "-"
+                  << scanner.last_sequence << ", missing " << scanner.sequence_gaps << ", skipped "
+                  << scanner.skipped_bytes << " B, garbage at the end " << (data.size() - valid_end) << " B"
+                  << std::endl;
+        if (scanner.sequence_gaps > 0 || scanner.skipped_bytes > 0) {
+            ret = 2;
+        }
+    }
+    return ret;
+}
+
+static void write_summaries(FILE* out, const tanwa_log_schema_t& schema,
+                            const std::vector<record_summary_values_t>& summaries) {
+    fprintf(out, "first_timestamp_ms,last_timestamp_ms,count");
+    for (uint8_t i = 0; i < schema.field_count; ++i) {
+        const char* name = schema.fields[i].name;
+        fprintf(out, ",%s_min,%s_max,%s_mean", name, name, name);
+    }
+    fprintf(out, "\n");
+    for (const record_summary_values_t& summary : summaries) {
+        fprintf(out, "%u,%u,%u", (unsigned)summary.first_timestamp_ms, (unsigned)summary.last_timestamp_ms,
+                (unsigned)summary.count);
+        for (uint8_t i = 0; i < summary.field_count; ++i) {
+            fprintf(out, ",%.9g,%.9g,%.9g", summary.min[i], summary.max[i], summary.mean[i]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+static void write_accounting(FILE* out, const std::vector<tanwa_log_backpressure_t>& accounting) {
+    fprintf(out, "timestamp_ms,interval_ms,policy,decimation,produced,decimated,dropped,written\n");
+    for (const tanwa_log_backpressure_t& entry : accounting) {
+        fprintf(out, "%u,%u,%u,%u,%u,%u,%u,%u\n", (unsigned)entry.timestamp_ms, (unsigned)entry.interval_ms,
+                (unsigned)entry.policy, 1u << entry.decimation, (unsigned)entry.produced,
+                (unsigned)entry.decimated, (unsigned)entry.dropped, (unsigned)entry.written);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool schema_only = false;
+    bool scan_only = false;
+    bool accounting_only = false;
+    bool summary_only = false;
+    uint32_t from_ms = 0;
+    uint32_t to_ms = UINT32_MAX;
+    int arg = 1;
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+        if (strcmp(argv[arg], "--schema") == 0) {
+            schema_only = true;
+            arg++;
+        } else if (strcmp(argv[arg], "--scan") == 0) {
+            scan_only = true;
+            arg++;
+        } else if (strcmp(argv[arg], "--accounting") == 0) {
+            accounting_only = true;
+            arg++;
+        } else if (strcmp(argv[arg], "--summary") == 0) {
+            summary_only = true;
+            arg++;
+        } else if (strcmp(argv[arg], "--from") == 0 && arg + 1 < argc) {
+            from_ms = strtoul(argv[arg + 1], nullptr, 0);
+            arg += 2;
+        } else if (strcmp(argv[arg], "--to") == 0 && arg + 1 < argc) {
+            to_ms = strtoul(argv[arg + 1], nullptr, 0);
+            arg += 2;
+        } else {
+            break;
+        }
+    }
+    if (argc <= arg) {
+        std::cerr << "usage: " << argv[0] << " [--schema|--scan|--accounting|--summary] [--from ms] [--to ms] <data.bin|session> [out.csv]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> segments;
+    std::filesystem::path input(argv[arg]);
+    if (std::filesystem::is_directory(input)) {
+        std::vector<tanwa_log_index_entry_t> entries;
+        if (!read_index(input, entries)) {
+            std::cerr << "can not read the index of " << argv[arg] << std::endl;
+            return 1;
+        }
+        for (size_t i = tanwa_log_index_find(entries.data(), entries.size(), from_ms);
+             i < entries.size() && entries[i].first_timestamp_ms <= to_ms; ++i) {
+            segments.push_back(segment_path(input, entries[i].segment));
+        }
+        if (segments.empty()) {
+            std::cerr << "no segments in the time window" << std::endl;
+            return 1;
+        }
+    } else {
+        segments.push_back(argv[arg]);
+    }
+
+    std::vector<uint8_t> data;
+    static tanwa_log_schema_t schema;
+    if (!read_file(segments[0].c_str(), data)) {
+        std::cerr << "can not read " << segments[0] << std::endl;
+        return 1;
+    }
+    if (!tanwa_log_parse_header(data.data(), data.size(), &schema)) {
+        std::cerr << "invalid log header" << std::endl;
+        return 1;
+    }
+    linearize_ring(data, schema);
+
+    if (schema_only) {
+        std::cout << "# version " << (int)schema.version << ", record " << schema.record_size << " bytes"
+                  << ((schema.flags & TANWA_LOG_FLAG_COMPRESSED) ? ", compressed" : "") << std::endl;
+        for (uint8_t i = 0; i < schema.field_count; ++i) {
+            std::cout << schema.fields[i].name << "," << type_name(schema.fields[i].type) << std::endl;
+        }
+        return 0;
+    }
+
+    if (scan_only) {
+        return scan_segments(segments);
+    }
+
+    FILE* out = stdout;
+    if (argc > arg + 1) {
+        out = fopen(argv[arg + 1], "w");
+        if (out == nullptr) {
+            std::cerr << "can not open " << argv[arg + 1] << std::endl;
+            return 1;
+        }
+    }
+
+    FILE* records_out = out;
+    if (accounting_only || summary_only) {
+        records_out = fopen("/dev/null", "w");
+    }
+    write_columns(records_out, schema);
+    decode_result_t result;
+    decode_records(records_out, schema, data, from_ms, to_ms, result);
+    for (size_t i = 1; i < segments.size(); ++i) {
+        static tanwa_log_schema_t segment_schema;
+        if (!read_file(segments[i].c_str(), data) ||
+            !tanwa_log_parse_header(data.data(), data.size(), &segment_schema) ||
+            segment_schema.record_size != schema.record_size) {
+            std::cerr << "skipping " << segments[i] << ", unreadable or different schema" << std::endl;
+            continue;
+        }
+        linearize_ring(data, segment_schema);
+        decode_records(records_out, segment_schema, data, from_ms, to_ms, result);
+    }
+
+    tanwa_log_backpressure_t total = {};
+    for (const tanwa_log_backpressure_t& entry : result.accounting) {
+        total.produced += entry.produced;
+        total.decimated += entry.decimated;
+        total.dropped += entry.dropped;
+        total.written += entry.written;
+        total.decimation = std::max(total.decimation, entry.decimation);
+    }
+    if (accounting_only) {
+        fclose(records_out);
+        write_accounting(out, result.accounting);
+    } else if (summary_only) {
+        fclose(records_out);
+        write_summaries(out, schema, result.summaries);
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    std::cerr << "segments: " << segments.size() << ", records: " << result.records
+              << ", crc errors: " << result.crc_errors << ", bad blocks: " << result.bad_blocks
+              << ", missing frames: " << result.sequence_gaps << ", skipped bytes: " << result.skipped_bytes
+              << ", trailing bytes: " << result.trailing_bytes;
+    if (!result.summaries.empty()) {
+        std::cerr << ", summaries: " << result.summaries.size();
+    }
+    std::cerr << std::endl;
+    if (!result.accounting.empty()) {
+        std::cerr << "samples: produced " << total.produced << ", decimated " << total.decimated << ", dropped "
+                  << total.dropped << ", written " << total.written << ", max decimation 1/"
+                  << (1u << total.decimation) << std::endl;
+    }
+    return result.crc_errors == 0 && result.bad_blocks == 0 ? 0 : 2;
+}
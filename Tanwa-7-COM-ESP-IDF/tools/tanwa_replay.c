@@ -0,0 +1,84 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host replay of the recorded sessions through the TANWA data and the telemetry serializers, the
+/// same sources as the firmware built with the FreeRTOS shim in tools/host. Use it to reproduce a
+/// test campaign offline, to check a serializer change against the recorded data (the digest
+/// changes with the output) and to find how much faster than real time the data path can go.
+///
+/// Build (protobuf-c runtime from ESP-IDF):
+///   gcc -std=gnu11 -O2 -Ihost -I../components/data -I../components/app -I../components/esp_now
+///       -I../components/proto -I$IDF_PATH/components/protobuf-c/protobuf-c
+///       tanwa_replay.c log_replay.c host/host_rtos.c ../components/data/TANWA_data.c
+///       ../components/data/tanwa_log_format.c ../components/data/record_codec.c
+///       ../components/app/telemetry_frames.c ../components/proto/lora.pb-c.c
+///       $IDF_PATH/components/protobuf-c/protobuf-c/protobuf-c/protobuf-c.c
+///       -lpthread -o tanwa_replay
+/// Usage:
+///   tanwa_replay [--speed x] [--csv-period ms] <session directory|data.bin|data.txt>
+///   speed 1 is the recorded pace, 0 (default) as fast as possible
+///===-----------------------------------------------------------------------------------------===//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_replay.h"
+
+int main(int argc, char **argv) {
+    float speed = 0.0f;
+    uint32_t csv_period_ms = LOG_REPLAY_CSV_PERIOD_MS;
+    const char *path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--csv-period") == 0 && i + 1 < argc) {
+            csv_period_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == NULL || speed < 0.0f || csv_period_ms == 0) {
+        fprintf(stderr, "usage: %s [--speed x] [--csv-period ms] <session directory|data.bin|data.txt>\n", argv[0]);
+        return 1;
+    }
+
+    log_replay_session_t session;
+    if (log_replay_load(path, csv_period_ms, &session) == false) {
+        fprintf(stderr, "no samples loaded from %s\n", path);
+        return 1;
+    }
+    printf("loaded %zu samples from %u file(s), %u bad records, %u bad lines\n", session.count, session.files,
+           session.crc_errors, session.skipped);
+
+    log_replay_result_t result;
+    if (log_replay_run(&session, speed, &result) == false) {
+        fprintf(stderr, "replay failed\n");
+        log_replay_free(&session);
+        return 1;
+    }
+
+    if (speed > 0.0f) {
+        printf("replay x%.2f: recorded %.3f s, wall %.3f s, late samples %u (%.2f %%)\n", speed, result.session_s,
+               result.wall_s, result.late, 100.0 * result.late / result.samples);
+    } else {
+        printf("replay as fast as possible: recorded %.3f s, wall %.3f s\n", result.session_s, result.wall_s);
+    }
+    printf("average    update %.3f us, esp-now %.3f us, lora %.3f us\n", result.update_us, result.now_us,
+           result.lora_us);
+    printf("sample     busy %.3f s, p50 %.3f us, p99 %.3f us, max %.3f us\n", result.busy_s, result.sample_p50_us,
+           result.sample_p99_us, result.sample_max_us);
+    printf("frames     esp-now %llu B, lora %llu B (avg %.1f B, max %u B)\n", (unsigned long long)result.now_bytes,
+           (unsigned long long)result.lora_bytes, (double)result.lora_bytes / result.samples, result.lora_max_bytes);
+    printf("max sustainable speed x%.0f (average), x%.0f (p99 sample)\n", log_replay_max_speed(&result),
+           log_replay_max_speed_p99(&result));
+    printf("digest 0x%04X\n", result.digest);
+
+    log_replay_free(&session);
+    return 0;
+}
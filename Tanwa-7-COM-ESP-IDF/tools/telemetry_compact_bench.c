@@ -0,0 +1,209 @@
+///===-----------------------------------------------------------------------------------------===//
+///
+/// Copyright (c) PWr in Space. All rights reserved.
+/// Created: 19.10.2026 by Michał Kos
+///
+///===-----------------------------------------------------------------------------------------===//
+///
+/// \file
+/// Host comparison of the LoRa telemetry encodings. Every sample of a recorded session (or of a
+/// generated filling when no path is given) is sent as the LoRaFrame protobuf, as the compact key
+/// frame and as the compact delta frame with the ground station acknowledging the received
+/// frames, some acknowledgements can be dropped. Reports the packet bytes and the time on air
+/// with the modem settings of the LoRa task and for all spreading factors, and checks that every
+/// compact frame decodes to the same values. Fails if one does not.
+///
+/// Build (protobuf-c runtime from ESP-IDF):
+///   gcc -std=gnu11 -O2 -Ihost -I../components/data -I../components/app -I../components/esp_now
+///       -I../components/proto -I../components/lora -I$IDF_PATH/components/protobuf-c/protobuf-c
+///       telemetry_compact_bench.c log_replay.c host/host_rtos.c ../components/data/TANWA_data.c
+///       ../components/data/tanwa_log_format.c ../components/data/record_codec.c
+///       ../components/app/telemetry_frames.c ../components/app/telemetry_compact.c
+///       ../components/lora/lora.c ../components/proto/lora.pb-c.c
+///       $IDF_PATH/components/protobuf-c/protobuf-c/protobuf-c/protobuf-c.c -lm -lpthread
+///       -o telemetry_compact_bench
+/// Usage:
+///   telemetry_compact_bench [--ack-loss percent] [session directory|data.bin|data.txt]
+///===-----------------------------------------------------------------------------------------===//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_replay.h"
+#include "lora.h"
+#include "telemetry_compact.h"
+#include "telemetry_frames.h"
+
+#define GENERATED_SAMPLES 2000
+#define PREFIX_SIZE 6  // PACKET_PREFIX
+#define PACKET_OVERHEAD (PREFIX_SIZE + 1)  // prefix and checksum
+
+typedef struct {
+    uint64_t bytes;
+    uint32_t max_bytes;
+    uint64_t time_on_air_us[LORA_SF_4096_CoS + 1];
+} encoding_result_t;
+
+/**
+ * @brief Modem settings of the LoRa task, chip defaults except the bandwidth
+ */
+static lora_modem_config_t task_modem(void) {
+    lora_modem_config_t modem = {
+        .sf = LORA_SF_128_CoS,
+        .bw = LORA_BW_250_kHz,  // LORA_TASK_BANDWIDTH
+        .coding_rate = 5,
+        .preamble_length = 8,
+        .implicit_header = false,
+        .crc = false,  // LORA_TASK_CRC_ENABLE
+        .low_data_rate_optimize = false,
+    };
+    return modem;
+}
+
+static void add_packet(encoding_result_t *result, size_t frame_size) {
+    size_t size = frame_size + PACKET_OVERHEAD;
+    result->bytes += size;
+    if (size > result->max_bytes) {
+        result->max_bytes = (uint32_t)size;
+    }
+    lora_modem_config_t modem = task_modem();
+    for (int sf = LORA_SF_128_CoS; sf <= LORA_SF_4096_CoS; ++sf) {
+        modem.sf = (lora_spreading_factor_t)sf;
+        // the SX1276 requires the optimization above 16 ms symbols
+        modem.low_data_rate_optimize = (1UL << sf) * 1000 / 250000 > 16;
+        result->time_on_air_us[sf] += lora_time_on_air_us(&modem, (int16_t)size);
+    }
+}
+
+/**
+ * @brief Filling of the oxidizer tank with noisy load cells and the battery slowly discharging
+ */
+static void generate_samples(log_replay_session_t *session) {
+    session->samples = calloc(GENERATED_SAMPLES, sizeof(tanwa_log_sample_t));
+    session->count = session->samples != NULL ? GENERATED_SAMPLES : 0;
+    for (size_t i = 0; i < session->count; ++i) {
+        tanwa_data_t *data = &session->samples[i].data;
+        float progress = (float)i / GENERATED_SAMPLES;
+        session->samples[i].timestamp_ms = (uint32_t)i * 1800;
+        data->state = progress < 0.1f ? 1 : progress < 0.8f ? 4 : 6;
+        data->com_data.vbat = 12.6f - progress * 0.8f + (rand() % 5) * 0.01f;
+        data->com_data.pressure_3 = progress * 55.0f + (rand() % 20) * 0.01f;
+        data->com_data.solenoid_state_fill = progress >= 0.1f && progress < 0.8f;
+        data->com_data.igniter_cont_1 = true;
+        data->com_data.igniter_cont_2 = true;
+        data->can_hx_rocket_status.temperature = (int16_t)(21 + progress * 2);
+        data->can_hx_oxidizer_status.temperature = (int16_t)(20 - progress * 15);
+        data->can_hx_rocket_data.weight = 32.5f + (rand() % 11 - 5) * 0.01f;
+        data->can_hx_oxidizer_data.weight = progress * 9.0f + (rand() % 11 - 5) * 0.01f;
+        data->can_hx_rocket_data.weight_raw = (uint32_t)(425000 + rand() % 600 - 300);
+        data->can_hx_oxidizer_data.weight_raw = (uint32_t)(80000 + (int32_t)(progress * 120000) + rand() % 600 - 300);
+        data->can_connected_slaves.hx_rocket = true;
+        data->can_connected_slaves.hx_oxidizer = true;
+        data->can_fac_status.motor_state_1 = data->com_data.solenoid_state_fill ? 2 : 1;
+    }
+}
+
+static void print_result(const char *name, const encoding_result_t *result, size_t count) {
+    printf("%-15s avg %5.1f B, max %3u B, on air SF7 %6.2f ms |", name, (double)result->bytes / count,
+           result->max_bytes, result->time_on_air_us[LORA_SF_128_CoS] / 1000.0 / count);
+    for (int sf = LORA_SF_128_CoS; sf <= LORA_SF_4096_CoS; ++sf) {
+        printf(" %7.1f", result->time_on_air_us[sf] / 1000.0 / count);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    int ack_loss = 0;
+    const char *path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--ack-loss") == 0 && i + 1 < argc) {
+            ack_loss = atoi(argv[++i]);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (ack_loss < 0 || ack_loss > 100) {
+        fprintf(stderr, "usage: %s [--ack-loss percent] [session directory|data.bin|data.txt]\n", argv[0]);
+        return 1;
+    }
+
+    log_replay_session_t session;
+    memset(&session, 0, sizeof(session));
+    if (path != NULL) {
+        if (log_replay_load(path, LOG_REPLAY_CSV_PERIOD_MS, &session) == false) {
+            fprintf(stderr, "no samples loaded from %s\n", path);
+            return 1;
+        }
+    } else {
+        generate_samples(&session);
+    }
+    if (session.count == 0) {
+        return 1;
+    }
+
+    telemetry_compact_encoder_t key_encoder, delta_encoder;
+    telemetry_compact_encoder_init(&key_encoder, false);
+    telemetry_compact_encoder_init(&delta_encoder, true);
+    static telemetry_compact_decoder_t decoder;
+    telemetry_compact_decoder_init(&decoder);
+
+    encoding_result_t protobuf = {0}, key = {0}, delta = {0};
+    uint32_t errors = 0;
+    float max_weight_error = 0.0f, max_vbat_error = 0.0f;
+    uint8_t buffer[256];
+    for (size_t i = 0; i < session.count; ++i) {
+        LoRaFrame frame;
+        telemetry_fill_lora_frame(&session.samples[i].data, &frame);
+        add_packet(&protobuf, lo_ra_frame__pack(&frame, buffer));
+
+        telemetry_compact_t compact;
+        telemetry_compact_from_lora_frame(&frame, &compact);
+        add_packet(&key, telemetry_compact_encode(&key_encoder, &compact, buffer));
+
+        size_t size = telemetry_compact_encode(&delta_encoder, &compact, buffer);
+        add_packet(&delta, size);
+        telemetry_compact_t decoded;
+        uint8_t sequence;
+        if (telemetry_compact_decode(&decoder, buffer, size, &decoded, &sequence) == false ||
+            memcmp(&decoded, &compact, sizeof(compact)) != 0) {
+            errors++;
+            continue;
+        }
+        if (rand() % 100 >= ack_loss) {
+            telemetry_compact_ack(&delta_encoder, sequence);
+        }
+
+        LoRaFrame received;
+        telemetry_compact_to_lora_frame(&decoded, &received);
+        float weight_error = fmaxf(fabsf(received.rocketweight_val - frame.rocketweight_val),
+                                   fabsf(received.tankweight_val - frame.tankweight_val));
+        max_weight_error = fmaxf(max_weight_error, weight_error);
+        max_vbat_error = fmaxf(max_vbat_error, fabsf(received.vbat - frame.vbat));
+        if (received.pressuresensor != frame.pressuresensor || received.tanwastate != frame.tanwastate ||
+            received.rocketweightraw_val != frame.rocketweightraw_val) {
+            errors++;
+        }
+    }
+
+    lora_modem_config_t modem = task_modem();
+    printf("%zu frames from %s, SF%d BW 250 kHz CR 4/%d, preamble %d, packet = %d B prefix + frame + 1 B checksum\n",
+           session.count, path != NULL ? path : "generated filling", modem.sf, modem.coding_rate,
+           modem.preamble_length, PREFIX_SIZE);
+    printf("%-15s %-45s| avg ms on air SF7..SF12\n", "encoding", "");
+    print_result("protobuf", &protobuf, session.count);
+    print_result("compact key", &key, session.count);
+    print_result("compact delta", &delta, session.count);
+    printf("delta frames %u of %zu, %d %% acks lost\n", delta_encoder.delta_frames, session.count, ack_loss);
+    printf("airtime saved at SF7: key %.1f %%, delta %.1f %%\n",
+           100.0 - 100.0 * key.time_on_air_us[LORA_SF_128_CoS] / protobuf.time_on_air_us[LORA_SF_128_CoS],
+           100.0 - 100.0 * delta.time_on_air_us[LORA_SF_128_CoS] / protobuf.time_on_air_us[LORA_SF_128_CoS]);
+    printf("max quantization error weight %.4f kg, vbat %.4f V, decode errors %u\n", max_weight_error,
+           max_vbat_error, errors);
+
+    bool ok = errors == 0 && max_weight_error <= 0.0051f && max_vbat_error <= 0.0051f;
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+    log_replay_free(&session);
+    return ok ? 0 : 1;
+}